@@ -77,6 +77,20 @@ ${CROSS_PREFIX}g++ -O3 -shared -fPIC -std=c++14 \
     -Ithird_party/clap/include \
     -ldl
 
+# Compile the sandbox helper (hosts a plugin out of process when "sandbox" is on)
+echo "Compiling CLAP sandbox helper..."
+${CROSS_PREFIX}g++ -O3 -std=c++14 \
+    -march=armv8-a -mtune=cortex-a72 \
+    -fno-exceptions \
+    -DNDEBUG \
+    src/dsp/clap_sandbox_main.c \
+    src/dsp/clap_host.c \
+    -o build/clap-sandbox \
+    -Isrc \
+    -Isrc/dsp \
+    -Ithird_party/clap/include \
+    -ldl -lpthread
+
 # Copy files to dist (use cat to avoid ExtFS deallocation issues with Docker)
 echo "Packaging..."
 cat src/module.json > dist/clap/module.json
@@ -86,6 +100,10 @@ chmod +x dist/clap/dsp.so
 cat build/clap_fx.so > dist/chain_audio_fx/clap/clap.so
 chmod +x dist/chain_audio_fx/clap/clap.so
 cat src/chain_audio_fx/module.json > dist/chain_audio_fx/clap/module.json
+cat build/clap-sandbox > dist/clap/clap-sandbox
+chmod +x dist/clap/clap-sandbox
+cat build/clap-sandbox > dist/chain_audio_fx/clap/clap-sandbox
+chmod +x dist/chain_audio_fx/clap/clap-sandbox
 
 # Copy included plugins (if any)
 if [ -d "plugins" ] && [ "$(ls -A plugins/*.clap 2>/dev/null)" ]; then
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 
 /* Inline API definitions to avoid path issues */
@@ -46,6 +47,9 @@ typedef struct audio_fx_api_v1 {
 #include "dsp/clap_host.h"
 }
 
+#include "dsp/param_keys.h"
+#include "dsp/module_shared.h"
+
 /* Plugin state */
 static const host_api_v1_t *g_host = NULL;
 static audio_fx_api_v1_t g_fx_api;
@@ -58,11 +62,9 @@ static char g_selected_plugin_id[256] = "";
 /* Forward declarations */
 static void fx_log(const char *msg);
 
+/* Log through the host logger (stderr and the host's log, off this thread) */
 static void fx_log(const char *msg) {
-    if (g_host && g_host->log) {
-        g_host->log(msg);
-    }
-    fprintf(stderr, "[CLAP FX] %s\n", msg);
+    CLAP_HOST_LOG(CLAP_HOST_LOG_INFO, "CLAP FX", "%s", msg);
 }
 
 /* Find and load a plugin by ID */
@@ -105,6 +107,8 @@ static int load_plugin_by_id(const char *plugin_id) {
 /* === Audio FX API Implementation === */
 
 static int on_load(const char *module_dir, const char *config_json) {
+    /* The host's log runs on the writer thread - it is also called from v2's UI-thread keys */
+    clap_log_open(NULL, 0, g_host ? g_host->log : NULL);
     fx_log("CLAP FX loading");
 
     strncpy(g_module_dir, module_dir, sizeof(g_module_dir) - 1);
@@ -148,6 +152,7 @@ static void on_unload(void) {
         clap_unload_plugin(&g_current_plugin);
     }
     clap_free_plugin_list(&g_plugin_list);
+    clap_log_close();
 }
 
 static void process_block(int16_t *audio_inout, int frames) {
@@ -156,27 +161,8 @@ static void process_block(int16_t *audio_inout, int frames) {
         return;
     }
 
-    /* Convert int16 to float */
-    float float_in[MOVE_FRAMES_PER_BLOCK * 2];
-    float float_out[MOVE_FRAMES_PER_BLOCK * 2];
-
-    for (int i = 0; i < frames * 2; i++) {
-        float_in[i] = audio_inout[i] / 32768.0f;
-    }
-
-    /* Process through CLAP plugin */
-    if (clap_process_block(&g_current_plugin, float_in, float_out, frames) != 0) {
-        /* Error - pass through original */
-        return;
-    }
-
-    /* Convert float to int16 */
-    for (int i = 0; i < frames * 2; i++) {
-        float sample = float_out[i];
-        if (sample > 1.0f) sample = 1.0f;
-        if (sample < -1.0f) sample = -1.0f;
-        audio_inout[i] = (int16_t)(sample * 32767.0f);
-    }
+    /* Process through CLAP plugin, converting in place (error leaves input untouched) */
+    clap_process_block_i16(&g_current_plugin, audio_inout, audio_inout, frames);
 }
 
 static void set_param(const char *key, const char *val) {
@@ -243,6 +229,7 @@ static int get_param(const char *key, char *buf, int buf_len) {
 
 extern "C" audio_fx_api_v1_t* move_audio_fx_init_v1(const host_api_v1_t *host) {
     g_host = host;
+    clap_host_set_audio_config(host->sample_rate, host->frames_per_block);
 
     g_fx_api.api_version = AUDIO_FX_API_VERSION;
     g_fx_api.on_load = on_load;
@@ -269,8 +256,10 @@ typedef struct audio_fx_api_v2 {
     int (*get_param)(void *instance, const char *key, char *buf, int buf_len);
 } audio_fx_api_v2_t;
 
-/* Forward declaration */
-static void v2_fx_log(const char *msg);
+/* Logs through the host logger - written out off the calling thread */
+#define V2_FX_DEBUG_FILE "/tmp/clap_fx_debug.txt"
+#define V2_FX_DEBUG_FILE_MAX (256 * 1024)
+#define V2_FX_LOG(level, ...) CLAP_HOST_LOG(level, "CLAP FX v2", __VA_ARGS__)
 
 /* Get current time in milliseconds */
 static uint64_t get_time_ms(void) {
@@ -279,8 +268,40 @@ static uint64_t get_time_ms(void) {
     return (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
 }
 
+/*
+ * Param metadata for the loaded plugin, sized to its real param count. Entries are
+ * filled a page at a time on first touch, and their sanitized keys go into a hash index
+ * as pages fill. Each plugin's layout (names, ranges, module groups) is saved under
+ * <module>/param_layouts so a selected plugin can be shown while it is still loading.
+ */
+#define PARAM_META_PAGE 32
+#define PARAM_GROUP_NAME_LEN 128
+#define PARAM_LAYOUT_MAGIC 0x4C504C43u   /* "CLPL" */
+#define PARAM_LAYOUT_VERSION 1
+
+typedef struct {
+    char name[64];
+    char key[64];                   /* Sanitized for use as a key */
+    double min, max;
+    int group;                      /* Index into groups, 0 = top level */
+} param_meta_t;
+
+typedef struct {
+    int count;
+    param_meta_t *params;
+    uint8_t *page_filled;           /* One flag per page of PARAM_META_PAGE */
+    int pages_filled;
+    uint32_t *key_index;            /* key -> index + 1, open addressing (0 = empty) */
+    uint32_t key_mask;
+    char (*groups)[PARAM_GROUP_NAME_LEN];  /* Module paths, groups[0] = "" */
+    int group_count;
+    int group_cap;
+    const void *source;             /* Host param table the entries were read from */
+    bool live;                      /* Backed by the loaded plugin, else a saved layout */
+    bool saved;                     /* Live layout already written */
+} param_meta_store_t;
+
 /* Per-instance state for V2 API */
-#define MAX_CACHED_PARAMS 32
 #define PLUGIN_LOAD_DEBOUNCE_MS 300  /* Wait 300ms after last scroll before loading */
 typedef struct {
     char module_dir[256];
@@ -292,12 +313,17 @@ typedef struct {
     uint64_t pending_load_time;     /* Time (ms) when we should actually load pending plugin */
     clap_host_list_t plugin_list;
     clap_instance_t current_plugin;
-    /* Cached param info for loaded plugin */
-    int cached_param_count;
-    char cached_param_names[MAX_CACHED_PARAMS][64];
-    char cached_param_keys[MAX_CACHED_PARAMS][64];  /* Sanitized for use as keys */
-    double cached_param_min[MAX_CACHED_PARAMS];
-    double cached_param_max[MAX_CACHED_PARAMS];
+    param_meta_store_t meta;        /* Param metadata, loaded plugin or the selected one's layout */
+    int meta_gen;                   /* Bumped whenever meta is replaced */
+    v2_snapshot_t snapshot;         /* params_snapshot, rebuilt when the param generation, page or metadata changes */
+    int page;                       /* Remote-control page on the knobs (knob_0..knob_7) */
+    /* Audio routing */
+    int sidechain_source;           /* CLAP_SIDECHAIN_* source fed to the sidechain port */
+    int sidechain_send;             /* Bus our output is sent to, CLAP_SIDECHAIN_OFF if none */
+    bool aux_outputs;               /* Mix auxiliary output buses into the main output */
+    int midi_out;                   /* MIDI_OUT_* destination for MIDI the plugin emits */
+    float mix;                      /* Dry/wet, 1 = fully wet */
+    bool sandbox;                   /* Host plugins out of process */
 } clap_fx_instance_t;
 
 /* Sanitize a param name for use as a key (lowercase, no spaces) */
@@ -319,54 +345,299 @@ static void sanitize_param_key(const char *name, char *key, int key_len) {
     }
 }
 
-/* Cache param names from loaded plugin */
-static void v2_cache_param_names(clap_fx_instance_t *inst) {
-    inst->cached_param_count = 0;
-    if (!inst->current_plugin.plugin) return;
+static void param_meta_free(param_meta_store_t *m) {
+    free(m->params);
+    free(m->page_filled);
+    free(m->key_index);
+    free(m->groups);
+    memset(m, 0, sizeof(*m));
+}
 
+static int param_meta_alloc(param_meta_store_t *m, int count) {
+    param_meta_free(m);
+    uint32_t size = 8;
+    while (size < (uint32_t)count * 2) size <<= 1;
+    m->params = (param_meta_t *)calloc(count + 1, sizeof(param_meta_t));
+    m->page_filled = (uint8_t *)calloc(count / PARAM_META_PAGE + 1, 1);
+    m->key_index = (uint32_t *)calloc(size, sizeof(uint32_t));
+    m->groups = (char (*)[PARAM_GROUP_NAME_LEN])calloc(8, PARAM_GROUP_NAME_LEN);
+    if (!m->params || !m->page_filled || !m->key_index || !m->groups) {
+        param_meta_free(m);
+        return -1;
+    }
+    m->key_mask = size - 1;
+    m->group_cap = 8;
+    m->group_count = 1;
+    m->count = count;
+    return 0;
+}
+
+static int param_meta_pages(const param_meta_store_t *m) {
+    return (m->count + PARAM_META_PAGE - 1) / PARAM_META_PAGE;
+}
+
+static void param_meta_index(param_meta_store_t *m, int index) {
+    uint32_t slot = param_key_hash(m->params[index].key) & m->key_mask;
+    while (m->key_index[slot]) slot = (slot + 1) & m->key_mask;
+    m->key_index[slot] = index + 1;
+}
+
+/* Group index for a module path, added if new - plugins have few modules, a scan is fine */
+static int param_meta_group(param_meta_store_t *m, const char *module) {
+    if (!module[0]) return 0;
+    for (int g = 1; g < m->group_count; g++) {
+        if (strcmp(m->groups[g], module) == 0) return g;
+    }
+    if (m->group_count == m->group_cap) {
+        char (*groups)[PARAM_GROUP_NAME_LEN] =
+            (char (*)[PARAM_GROUP_NAME_LEN])realloc(m->groups, (size_t)m->group_cap * 2 * PARAM_GROUP_NAME_LEN);
+        if (!groups) return 0;
+        m->groups = groups;
+        m->group_cap *= 2;
+    }
+    snprintf(m->groups[m->group_count], PARAM_GROUP_NAME_LEN, "%s", module);
+    return m->group_count++;
+}
+
+/* Start a live store for the loaded plugin - entries are read on first touch */
+static void v2_param_meta_reset(clap_fx_instance_t *inst) {
+    param_meta_store_t *m = &inst->meta;
+    param_meta_free(m);
+    inst->meta_gen++;
+    if (!inst->current_plugin.plugin) return;
     int count = clap_param_count(&inst->current_plugin);
-    if (count > MAX_CACHED_PARAMS) count = MAX_CACHED_PARAMS;
+    if (count <= 0 || param_meta_alloc(m, count) != 0) return;
+    m->source = inst->current_plugin.param_cache;
+    m->live = true;
+}
 
-    for (int i = 0; i < count; i++) {
-        char name[64] = "";
-        double min_val = 0, max_val = 1, def_val = 0;
-        if (clap_param_info(&inst->current_plugin, i, name, sizeof(name), &min_val, &max_val, &def_val) == 0 && name[0]) {
-            strncpy(inst->cached_param_names[i], name, sizeof(inst->cached_param_names[i]) - 1);
-        } else {
-            snprintf(inst->cached_param_names[i], sizeof(inst->cached_param_names[i]), "Param %d", i);
+static void v2_param_layout_save(clap_fx_instance_t *inst);
+
+static void v2_param_meta_fill_page(clap_fx_instance_t *inst, int page) {
+    param_meta_store_t *m = &inst->meta;
+    if (!m->live || m->page_filled[page]) return;
+
+    int end = (page + 1) * PARAM_META_PAGE;
+    if (end > m->count) end = m->count;
+    for (int i = page * PARAM_META_PAGE; i < end; i++) {
+        param_meta_t *p = &m->params[i];
+        char module[PARAM_GROUP_NAME_LEN] = "";
+        p->min = 0;
+        p->max = 1;
+        if (clap_param_info(&inst->current_plugin, i, p->name, sizeof(p->name), &p->min, &p->max, NULL) != 0 ||
+            !p->name[0]) {
+            snprintf(p->name, sizeof(p->name), "Param %d", i);
         }
-        sanitize_param_key(inst->cached_param_names[i], inst->cached_param_keys[i], sizeof(inst->cached_param_keys[i]));
-        inst->cached_param_min[i] = min_val;
-        inst->cached_param_max[i] = max_val;
+        clap_param_module(&inst->current_plugin, i, module, sizeof(module));
+        p->group = param_meta_group(m, module);
+        sanitize_param_key(p->name, p->key, sizeof(p->key));
+        param_meta_index(m, i);
+    }
+    m->page_filled[page] = 1;
+    m->pages_filled++;
+    if (m->pages_filled == param_meta_pages(m)) v2_param_layout_save(inst);
+}
+
+static void v2_param_meta_fill_all(clap_fx_instance_t *inst) {
+    for (int page = 0; page < param_meta_pages(&inst->meta); page++) {
+        v2_param_meta_fill_page(inst, page);
     }
-    inst->cached_param_count = count;
+}
 
-    char msg[256];
-    snprintf(msg, sizeof(msg), "Cached %d param names", count);
-    v2_fx_log(msg);
+/* The live store, rebuilt if the plugin rescanned its params into a new table */
+static param_meta_store_t *v2_param_meta_sync(clap_fx_instance_t *inst) {
+    param_meta_store_t *m = &inst->meta;
+    if (m->live && inst->current_plugin.plugin &&
+        (clap_param_count(&inst->current_plugin) != m->count || inst->current_plugin.param_cache != m->source)) {
+        v2_param_meta_reset(inst);
+    }
+    return m;
 }
 
-/* Find param index by key */
-static int v2_find_param_by_key(clap_fx_instance_t *inst, const char *key) {
-    for (int i = 0; i < inst->cached_param_count; i++) {
-        if (strcmp(inst->cached_param_keys[i], key) == 0) {
-            return i;
-        }
+/* Metadata for param index, NULL if out of range */
+static const param_meta_t *v2_param_meta(clap_fx_instance_t *inst, int index) {
+    param_meta_store_t *m = v2_param_meta_sync(inst);
+    if (index < 0 || index >= m->count) return NULL;
+    v2_param_meta_fill_page(inst, index / PARAM_META_PAGE);
+    return &m->params[index];
+}
+
+/* Layout file for a plugin id: <module>/param_layouts/<id>.params */
+static void v2_param_layout_path(clap_fx_instance_t *inst, const char *plugin_id, char *path, int path_len) {
+    char name[256];
+    int j = 0;
+    for (int i = 0; plugin_id[i] && j < (int)sizeof(name) - 1; i++) {
+        char c = plugin_id[i];
+        bool keep = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                    c == '.' || c == '-' || c == '_';
+        name[j++] = keep ? c : '_';
     }
-    return -1;
+    name[j] = '\0';
+    snprintf(path, path_len, "%s/param_layouts/%s.params", inst->module_dir, name);
 }
 
-static void v2_fx_log(const char *msg) {
-    if (g_host && g_host->log) {
-        g_host->log(msg);
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t count;
+    int32_t group_count;
+} param_layout_header_t;
+
+typedef struct {
+    char name[64];
+    double min, max;
+    int32_t group;
+} param_layout_entry_t;
+
+/* Write the loaded plugin's layout once per load - a full read of the host's table */
+static void v2_param_layout_save(clap_fx_instance_t *inst) {
+    param_meta_store_t *m = v2_param_meta_sync(inst);
+    if (!m->live || m->saved || !m->count) return;
+    if (inst->loaded_plugin_index < 0 || inst->loaded_plugin_index >= inst->plugin_list.count) return;
+    m->saved = true;
+    v2_param_meta_fill_all(inst);
+
+    char path[1024], tmp[1100];
+    snprintf(path, sizeof(path), "%s/param_layouts", inst->module_dir);
+    mkdir(path, 0755);
+    v2_param_layout_path(inst, inst->plugin_list.items[inst->loaded_plugin_index].id, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return;
+    param_layout_header_t hdr = { PARAM_LAYOUT_MAGIC, PARAM_LAYOUT_VERSION, m->count, m->group_count };
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+              fwrite(m->groups + 1, PARAM_GROUP_NAME_LEN, m->group_count - 1, f) == (size_t)m->group_count - 1;
+    for (int i = 0; ok && i < m->count; i++) {
+        param_layout_entry_t e;
+        memset(&e, 0, sizeof(e));
+        memcpy(e.name, m->params[i].name, sizeof(e.name));
+        e.min = m->params[i].min;
+        e.max = m->params[i].max;
+        e.group = m->params[i].group;
+        ok = fwrite(&e, sizeof(e), 1, f) == 1;
+    }
+    if (fclose(f) != 0) ok = false;
+    if (!ok || rename(tmp, path) != 0) {
+        remove(tmp);
+        V2_FX_LOG(CLAP_HOST_LOG_ERROR, "Failed to write param layout");
     }
-    fprintf(stderr, "[CLAP FX v2] %s\n", msg);
-    /* Also write to file for debugging */
-    FILE *f = fopen("/tmp/clap_fx_debug.txt", "a");
-    if (f) {
-        fprintf(f, "[CLAP FX v2] %s\n", msg);
-        fclose(f);
+}
+
+/* Show a plugin's saved layout until it is loaded, -1 if none was saved */
+static int v2_param_layout_load(clap_fx_instance_t *inst, int plugin_index) {
+    if (plugin_index < 0 || plugin_index >= inst->plugin_list.count) return -1;
+    v2_param_layout_save(inst);
+
+    char path[1024];
+    v2_param_layout_path(inst, inst->plugin_list.items[plugin_index].id, path, sizeof(path));
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+
+    param_meta_store_t *m = &inst->meta;
+    param_layout_header_t hdr;
+    bool ok = fread(&hdr, sizeof(hdr), 1, f) == 1 && hdr.magic == PARAM_LAYOUT_MAGIC &&
+              hdr.version == PARAM_LAYOUT_VERSION && hdr.count > 0 && hdr.count <= (1 << 20) &&
+              hdr.group_count >= 1 && hdr.group_count <= 65536 && param_meta_alloc(m, hdr.count) == 0;
+    for (int g = 1; ok && g < hdr.group_count; g++) {
+        char group[PARAM_GROUP_NAME_LEN];
+        ok = fread(group, PARAM_GROUP_NAME_LEN, 1, f) == 1;
+        group[PARAM_GROUP_NAME_LEN - 1] = '\0';
+        if (ok) ok = param_meta_group(m, group) == g;
     }
+    for (int i = 0; ok && i < hdr.count; i++) {
+        param_layout_entry_t e;
+        ok = fread(&e, sizeof(e), 1, f) == 1;
+        if (!ok) break;
+        param_meta_t *p = &m->params[i];
+        memcpy(p->name, e.name, sizeof(p->name));
+        p->name[sizeof(p->name) - 1] = '\0';
+        p->min = e.min;
+        p->max = e.max;
+        p->group = (e.group >= 0 && e.group < m->group_count) ? e.group : 0;
+        sanitize_param_key(p->name, p->key, sizeof(p->key));
+        param_meta_index(m, i);
+    }
+    fclose(f);
+    if (!ok) {
+        v2_param_meta_reset(inst);  /* Back to the loaded plugin's params */
+        return -1;
+    }
+    memset(m->page_filled, 1, param_meta_pages(m));
+    m->pages_filled = param_meta_pages(m);
+    m->saved = true;
+    inst->meta_gen++;
+    return 0;
+}
+
+/* Param index under knob_N on the current page, -1 if the knob is unassigned */
+static int v2_knob_param(clap_fx_instance_t *inst, int knob) {
+    if (!inst->current_plugin.plugin || !inst->meta.live) return -1;
+    return clap_remote_param(&inst->current_plugin, inst->page, knob);
+}
+
+/* Knob pages - a saved layout is paged in index order until the plugin is loaded */
+static int v2_page_count(clap_fx_instance_t *inst) {
+    if (inst->meta.live) return clap_remote_page_count(&inst->current_plugin);
+    return (inst->meta.count + CLAP_KNOBS_PER_PAGE - 1) / CLAP_KNOBS_PER_PAGE;
+}
+
+static int v2_page_name(clap_fx_instance_t *inst, char *buf, int buf_len) {
+    if (!inst->meta.live) {
+        int first = inst->page * CLAP_KNOBS_PER_PAGE;
+        int last = first + CLAP_KNOBS_PER_PAGE < inst->meta.count ? first + CLAP_KNOBS_PER_PAGE : inst->meta.count;
+        return snprintf(buf, buf_len, "Params %d-%d", first + 1, last);
+    }
+    return clap_remote_page_name(&inst->current_plugin, inst->page, buf, buf_len);
+}
+
+/* Param index shown on a knob - a saved layout's knobs follow index order */
+static int v2_knob_shown(clap_fx_instance_t *inst, int knob) {
+    return inst->meta.live ? clap_remote_param(&inst->current_plugin, inst->page, knob)
+                           : inst->page * CLAP_KNOBS_PER_PAGE + knob;
+}
+
+/* Rebuild params_snapshot if anything shown changed, returns its generation (a saved layout leaves values empty) */
+static uint32_t v2_params_snapshot(clap_fx_instance_t *inst) {
+    clap_instance_t *plugin = &inst->current_plugin;
+    v2_snapshot_t *s = &inst->snapshot;
+    uint32_t gen = inst->meta.live ? clap_param_generation(plugin) : 0;
+    if (v2_snapshot_fresh(s, gen, inst->page, inst->meta_gen)) return s->seq;
+
+    char text[64];
+    if (v2_page_name(inst, text, sizeof(text)) < 0) text[0] = '\0';
+    v2_snapshot_begin(s, inst->page, v2_page_count(inst), text);
+    for (int knob = 0; knob < CLAP_KNOBS_PER_PAGE; knob++) {
+        int idx = v2_knob_shown(inst, knob);
+        const param_meta_t *p = v2_param_meta(inst, idx);
+        if (!p) continue;
+        if (inst->meta.live) {
+            double value = clap_param_get(plugin, idx);
+            if (clap_param_text(plugin, idx, text, sizeof(text)) < 0) text[0] = '\0';
+            v2_snapshot_knob(s, knob, p->name, &value, text);
+        } else {
+            v2_snapshot_knob(s, knob, p->name, NULL, NULL);
+        }
+    }
+    return v2_snapshot_commit(s, gen, inst->page, inst->meta_gen);
+}
+
+static void v2_set_param(void *instance, const char *key, const char *val);
+
+/* Find param index by key - the first param with that key wins */
+static int v2_find_param_by_key(clap_fx_instance_t *inst, const char *key) {
+    param_meta_store_t *m = v2_param_meta_sync(inst);
+    if (!m->live) return -1;
+    v2_param_meta_fill_all(inst);
+
+    int found = -1;
+    uint32_t slot = param_key_hash(key) & m->key_mask;
+    for (uint32_t idx; (idx = m->key_index[slot]) != 0; slot = (slot + 1) & m->key_mask) {
+        if ((found < 0 || (int)idx - 1 < found) && strcmp(m->params[idx - 1].key, key) == 0) {
+            found = (int)idx - 1;
+        }
+    }
+    return found;
 }
 
 /* Ensure plugin list is scanned (only once per instance) */
@@ -374,18 +645,15 @@ static void v2_ensure_plugins_scanned(clap_fx_instance_t *inst) {
     if (inst->plugins_scanned) return;
 
     char plugins_dir[512];
-    char msg[512];
     snprintf(plugins_dir, sizeof(plugins_dir), "%s/../../sound_generators/clap/plugins", inst->module_dir);
 
-    snprintf(msg, sizeof(msg), "Scanning plugins at: %s", plugins_dir);
-    v2_fx_log(msg);
+    V2_FX_LOG(CLAP_HOST_LOG_DEBUG, "Scanning plugins at: %s", plugins_dir);
 
     clap_free_plugin_list(&inst->plugin_list);
     if (clap_scan_plugins(plugins_dir, &inst->plugin_list) == 0) {
-        snprintf(msg, sizeof(msg), "Found %d plugins", inst->plugin_list.count);
-        v2_fx_log(msg);
+        V2_FX_LOG(CLAP_HOST_LOG_INFO, "Found %d plugins", inst->plugin_list.count);
     } else {
-        v2_fx_log("Failed to scan plugins directory");
+        V2_FX_LOG(CLAP_HOST_LOG_ERROR, "Failed to scan plugins directory");
     }
     inst->plugins_scanned = 1;
 }
@@ -395,14 +663,14 @@ static int v2_load_plugin_by_index(clap_fx_instance_t *inst, int index) {
     v2_ensure_plugins_scanned(inst);
 
     if (index < 0 || index >= inst->plugin_list.count) {
-        v2_fx_log("Plugin index out of range");
+        V2_FX_LOG(CLAP_HOST_LOG_ERROR, "Plugin index out of range");
         return -1;
     }
 
     clap_plugin_info_t *info = &inst->plugin_list.items[index];
 
     if (!info->has_audio_in) {
-        v2_fx_log("Plugin is not an audio effect (no audio input)");
+        V2_FX_LOG(CLAP_HOST_LOG_ERROR, "Plugin is not an audio effect (no audio input)");
         return -1;
     }
 
@@ -410,33 +678,44 @@ static int v2_load_plugin_by_index(clap_fx_instance_t *inst, int index) {
     inst->loading = 1;
     __sync_synchronize();
 
-    /* Unload current plugin if any */
+    /* Unload current plugin if any, keeping its layout for next time */
     if (inst->current_plugin.plugin) {
+        v2_param_layout_save(inst);
         clap_unload_plugin(&inst->current_plugin);
     }
 
-    char msg[512];
-    snprintf(msg, sizeof(msg), "Loading FX plugin [%d]: %s", index, info->name);
-    v2_fx_log(msg);
+    V2_FX_LOG(CLAP_HOST_LOG_INFO, "Loading FX plugin [%d]: %s", index, info->name);
 
-    if (clap_load_plugin(info->path, info->plugin_index, &inst->current_plugin) != 0) {
-        v2_fx_log("Failed to load plugin");
+    int rc;
+    if (inst->sandbox) {
+        char helper[512];
+        snprintf(helper, sizeof(helper), "%s/%s", inst->module_dir, CLAP_SANDBOX_HELPER);
+        rc = clap_load_plugin_sandboxed(helper, info->path, info->plugin_index, &inst->current_plugin);
+    } else {
+        rc = clap_load_plugin(info->path, info->plugin_index, &inst->current_plugin);
+    }
+    if (rc != 0) {
+        V2_FX_LOG(CLAP_HOST_LOG_ERROR, "Failed to load plugin");
         inst->loaded_plugin_index = -1;
         inst->selected_plugin_index = -1;
         inst->selected_plugin_id[0] = '\0';
-        inst->cached_param_count = 0;
+        v2_param_meta_reset(inst);
         inst->pending_load_time = 0;
         inst->loading = 0;
         return -1;
     }
 
+    clap_set_aux_outputs(&inst->current_plugin, inst->aux_outputs);
+    if (inst->mix < 1.0f) clap_set_mix(&inst->current_plugin, inst->mix);
+
     /* Update both loaded and selected indices */
     inst->loaded_plugin_index = index;
     inst->selected_plugin_index = index;
     strncpy(inst->selected_plugin_id, info->id, sizeof(inst->selected_plugin_id) - 1);
 
-    /* Cache param names for this plugin */
-    v2_cache_param_names(inst);
+    /* Param metadata is read from the plugin as it is used */
+    v2_param_meta_reset(inst);
+    inst->page = 0;
 
     /* Clear pending load and mark as done */
     inst->pending_load_time = 0;
@@ -448,9 +727,7 @@ static int v2_load_plugin_by_index(clap_fx_instance_t *inst, int index) {
 static int v2_load_plugin_by_id(clap_fx_instance_t *inst, const char *plugin_id) {
     v2_ensure_plugins_scanned(inst);
 
-    char msg[512];
-    snprintf(msg, sizeof(msg), "Searching for plugin: %s", plugin_id);
-    v2_fx_log(msg);
+    V2_FX_LOG(CLAP_HOST_LOG_DEBUG, "Searching for plugin: %s", plugin_id);
 
     for (int i = 0; i < inst->plugin_list.count; i++) {
         if (strcmp(inst->plugin_list.items[i].id, plugin_id) == 0) {
@@ -459,20 +736,28 @@ static int v2_load_plugin_by_id(clap_fx_instance_t *inst, const char *plugin_id)
         }
     }
 
-    snprintf(msg, sizeof(msg), "Plugin not found: %s", plugin_id);
-    v2_fx_log(msg);
+    V2_FX_LOG(CLAP_HOST_LOG_ERROR, "Plugin not found: %s", plugin_id);
     return -1;
 }
 
 static void* v2_create_instance(const char *module_dir, const char *config_json) {
-    v2_fx_log("Creating CLAP FX instance");
+    clap_log_open(V2_FX_DEBUG_FILE, V2_FX_DEBUG_FILE_MAX, g_host ? g_host->log : NULL);
+    V2_FX_LOG(CLAP_HOST_LOG_INFO, "Creating CLAP FX instance");
 
     clap_fx_instance_t *inst = (clap_fx_instance_t*)calloc(1, sizeof(clap_fx_instance_t));
-    if (!inst) return NULL;
+    if (!inst) {
+        clap_log_close();
+        return NULL;
+    }
 
     strncpy(inst->module_dir, module_dir, sizeof(inst->module_dir) - 1);
     inst->selected_plugin_index = -1;  /* No plugin selected yet */
     inst->loaded_plugin_index = -1;    /* No plugin loaded yet */
+    inst->sidechain_source = CLAP_SIDECHAIN_OFF;
+    inst->sidechain_send = CLAP_SIDECHAIN_OFF;
+    inst->aux_outputs = true;
+    inst->midi_out = MIDI_OUT_OFF;
+    inst->mix = 1.0f;
 
     int plugin_loaded = 0;
 
@@ -506,7 +791,7 @@ static void* v2_create_instance(const char *module_dir, const char *config_json)
     if (!plugin_loaded) {
         v2_ensure_plugins_scanned(inst);
         if (inst->plugin_list.count > 0) {
-            v2_fx_log("No plugin in config, loading first available");
+            V2_FX_LOG(CLAP_HOST_LOG_INFO, "No plugin in config, loading first available");
             v2_load_plugin_by_index(inst, 0);
         }
     }
@@ -518,13 +803,25 @@ static void v2_destroy_instance(void *instance) {
     clap_fx_instance_t *inst = (clap_fx_instance_t*)instance;
     if (!inst) return;
 
-    v2_fx_log("Destroying CLAP FX instance");
+    V2_FX_LOG(CLAP_HOST_LOG_INFO, "Destroying CLAP FX instance");
 
     if (inst->current_plugin.plugin) {
+        v2_param_layout_save(inst);
         clap_unload_plugin(&inst->current_plugin);
     }
+    param_meta_free(&inst->meta);
     clap_free_plugin_list(&inst->plugin_list);
     free(inst);
+    clap_log_close();
+}
+
+/* Re-activate the plugin if the host's rate or block size changed (UI thread) */
+static void v2_check_audio_config(clap_fx_instance_t *inst) {
+    if (!g_host || !inst->current_plugin.plugin || inst->loading || g_host->sample_rate <= 0) return;
+    if (g_host->sample_rate == (int)inst->current_plugin.sample_rate &&
+        (g_host->frames_per_block <= 0 || g_host->frames_per_block == inst->current_plugin.max_frames)) return;
+    clap_host_set_audio_config(g_host->sample_rate, g_host->frames_per_block);
+    clap_reconfigure(&inst->current_plugin, g_host->sample_rate, g_host->frames_per_block);
 }
 
 static void v2_process_block(void *instance, int16_t *audio_inout, int frames) {
@@ -533,68 +830,122 @@ static void v2_process_block(void *instance, int16_t *audio_inout, int frames) {
         return;  /* Pass through - no plugin or loading in progress */
     }
 
-    float float_in[MOVE_FRAMES_PER_BLOCK * 2];
-    float float_out[MOVE_FRAMES_PER_BLOCK * 2];
+    /* Error leaves audio_inout untouched - pass through */
+    clap_set_sidechain_input(&inst->current_plugin, v2_sidechain_input(g_host, inst->sidechain_source, frames));
+    clap_process_block_i16(&inst->current_plugin, audio_inout, audio_inout, frames);
 
-    for (int i = 0; i < frames * 2; i++) {
-        float_in[i] = audio_inout[i] / 32768.0f;
-    }
-
-    if (clap_process_block(&inst->current_plugin, float_in, float_out, frames) != 0) {
-        return;  /* Error - pass through */
-    }
-
-    for (int i = 0; i < frames * 2; i++) {
-        float sample = float_out[i];
-        if (sample > 1.0f) sample = 1.0f;
-        if (sample < -1.0f) sample = -1.0f;
-        audio_inout[i] = (int16_t)(sample * 32767.0f);
+    if (inst->sidechain_send != CLAP_SIDECHAIN_OFF) {
+        clap_sidechain_bus_write(inst->sidechain_send, audio_inout, frames);
     }
+    v2_forward_midi_out(g_host, &inst->current_plugin, inst->midi_out);
 }
 
 static void v2_set_param(void *instance, const char *key, const char *val) {
     clap_fx_instance_t *inst = (clap_fx_instance_t*)instance;
     if (!inst || !key || !val) return;
 
-    char msg[512];
-    snprintf(msg, sizeof(msg), "v2_set_param: key='%s' val='%s'", key, val);
-    v2_fx_log(msg);
+    V2_FX_LOG(CLAP_HOST_LOG_DEBUG, "v2_set_param: key='%s' val='%s'", key, val);
 
-    if (strcmp(key, "plugin_id") == 0) {
-        if (strcmp(val, inst->selected_plugin_id) != 0) {
-            v2_load_plugin_by_id(inst, val);
+    param_key_t k;
+    if (param_key_parse(key, &k)) {
+        switch (k.hash) {
+        PARAM_KEY_CASE(k, "plugin_id")
+            if (strcmp(val, inst->selected_plugin_id) != 0) {
+                v2_load_plugin_by_id(inst, val);
+            }
+            return;
+        PARAM_KEY_CASE(k, "plugin_index") {
+            int idx = atoi(val);
+            if (idx != inst->selected_plugin_index) {
+                /* Update selected index and schedule debounced load */
+                inst->selected_plugin_index = idx;
+                inst->pending_load_time = get_time_ms() + PLUGIN_LOAD_DEBOUNCE_MS;
+                /* Show the saved layout while the load is pending */
+                v2_ensure_plugins_scanned(inst);
+                if (idx != inst->loaded_plugin_index) {
+                    if (v2_param_layout_load(inst, idx) == 0) inst->page = 0;
+                } else if (!inst->meta.live) {
+                    v2_param_meta_reset(inst);
+                }
+                V2_FX_LOG(CLAP_HOST_LOG_DEBUG, "Scheduled plugin load: idx=%d (debounce %dms)", idx, PLUGIN_LOAD_DEBOUNCE_MS);
+            }
+            return;
         }
-    }
-    else if (strcmp(key, "plugin_index") == 0) {
-        int idx = atoi(val);
-        if (idx != inst->selected_plugin_index) {
-            /* Update selected index and schedule debounced load */
-            inst->selected_plugin_index = idx;
-            inst->pending_load_time = get_time_ms() + PLUGIN_LOAD_DEBOUNCE_MS;
-            snprintf(msg, sizeof(msg), "Scheduled plugin load: idx=%d (debounce %dms)", idx, PLUGIN_LOAD_DEBOUNCE_MS);
-            v2_fx_log(msg);
+        PARAM_KEY_CASE(k, "sidechain")
+            inst->sidechain_source = clap_sidechain_parse(val);
+            return;
+        PARAM_KEY_CASE(k, "sidechain_send")
+            inst->sidechain_send = clap_sidechain_parse(val);
+            if (inst->sidechain_send == CLAP_SIDECHAIN_LINE_IN) inst->sidechain_send = CLAP_SIDECHAIN_OFF;
+            return;
+        PARAM_KEY_CASE(k, "aux_outputs")
+            inst->aux_outputs = atoi(val) != 0;
+            clap_set_aux_outputs(&inst->current_plugin, inst->aux_outputs);
+            return;
+        PARAM_KEY_CASE(k, "midi_out")
+            inst->midi_out = v2_midi_out_parse(val);
+            return;
+        PARAM_KEY_CASE(k, "mix") {
+            float mix = (float)atof(val);
+            inst->mix = mix < 0.0f ? 0.0f : (mix > 1.0f ? 1.0f : mix);
+            if (inst->current_plugin.plugin) clap_set_mix(&inst->current_plugin, inst->mix);
+            return;
         }
-    }
-    else if (strncmp(key, "param_", 6) == 0 && key[6] >= '0' && key[6] <= '9') {
-        /* param_0, param_1, etc. - direct index */
-        int param_idx = atoi(key + 6);
-        double value = atof(val);
-        if (inst->current_plugin.plugin) {
-            clap_param_set(&inst->current_plugin, param_idx, value);
-            snprintf(msg, sizeof(msg), "Set param[%d] = %.3f", param_idx, value);
-            v2_fx_log(msg);
+        PARAM_KEY_CASE(k, "state")
+            /* A state file from get_param("state") - one state load restores the plugin */
+            if (inst->current_plugin.plugin && clap_state_read_file(&inst->current_plugin, val) != 0) {
+                V2_FX_LOG(CLAP_HOST_LOG_ERROR, "State load failed: %s", val);
+            }
+            return;
+        PARAM_KEY_CASE(k, "sandbox") {
+            bool sandbox = atoi(val) != 0;
+            if (sandbox != inst->sandbox) {
+                inst->sandbox = sandbox;
+                if (inst->current_plugin.plugin && inst->loaded_plugin_index >= 0) {
+                    v2_load_plugin_by_index(inst, inst->loaded_plugin_index);
+                }
+            }
+            return;
         }
-    }
-    else {
-        /* Try to find param by sanitized name key */
-        int param_idx = v2_find_param_by_key(inst, key);
-        if (param_idx >= 0 && inst->current_plugin.plugin) {
+        PARAM_KEY_CASE(k, "page") {
+            int page = atoi(val);
+            if (page >= 0 && page < v2_page_count(inst)) inst->page = page;
+            return;
+        }
+        PARAM_KEY_CASE(k, "params_batch")
+            v2_params_batch(inst, val, v2_set_param);
+            return;
+        PARAM_KEY_CASE(k, "log_level")
+            clap_log_set_level(clap_log_level_parse(val));
+            return;
+        PARAM_KEY_CASE(k, "perf_reset")
+            clap_perf_reset(&inst->current_plugin);
+            return;
+        PARAM_KEY_CASE(k, "knob_N") {
+            /* knob_0..knob_7 - the param on that knob of the current page */
+            int param_idx = v2_knob_param(inst, k.index);
+            if (param_idx >= 0) clap_param_set(&inst->current_plugin, param_idx, atof(val));
+            return;
+        }
+        PARAM_KEY_CASE(k, "param_N") {
+            /* param_0, param_1, etc. - direct index */
             double value = atof(val);
-            clap_param_set(&inst->current_plugin, param_idx, value);
-            snprintf(msg, sizeof(msg), "Set param '%s' [%d] = %.3f", key, param_idx, value);
-            v2_fx_log(msg);
+            if (inst->current_plugin.plugin) {
+                clap_param_set(&inst->current_plugin, k.index, value);
+                V2_FX_LOG(CLAP_HOST_LOG_DEBUG, "Set param[%d] = %.3f", k.index, value);
+            }
+            return;
+        }
         }
     }
+
+    /* Try to find param by sanitized name key */
+    int param_idx = v2_find_param_by_key(inst, key);
+    if (param_idx >= 0 && inst->current_plugin.plugin) {
+        double value = atof(val);
+        clap_param_set(&inst->current_plugin, param_idx, value);
+        V2_FX_LOG(CLAP_HOST_LOG_DEBUG, "Set param '%s' [%d] = %.3f", key, param_idx, value);
+    }
 }
 
 /* Check if a pending plugin load is ready (debounce expired) and execute it */
@@ -607,9 +958,7 @@ static void v2_check_pending_load(clap_fx_instance_t *inst) {
         /* Debounce expired - actually load the plugin */
         int idx = inst->selected_plugin_index;
         if (idx != inst->loaded_plugin_index && idx >= 0) {
-            char msg[256];
-            snprintf(msg, sizeof(msg), "Debounce expired, loading plugin idx=%d", idx);
-            v2_fx_log(msg);
+            V2_FX_LOG(CLAP_HOST_LOG_INFO, "Debounce expired, loading plugin idx=%d", idx);
             v2_load_plugin_by_index(inst, idx);
         } else {
             inst->pending_load_time = 0;  /* Nothing to do */
@@ -617,12 +966,21 @@ static void v2_check_pending_load(clap_fx_instance_t *inst) {
     }
 }
 
+/* Name of the selected plugin, or fallback if none is selected */
+static int v2_selected_plugin_name(clap_fx_instance_t *inst, const char *fallback, char *buf, int buf_len) {
+    if (inst->selected_plugin_index >= 0 && inst->selected_plugin_index < inst->plugin_list.count) {
+        return snprintf(buf, buf_len, "%s", inst->plugin_list.items[inst->selected_plugin_index].name);
+    }
+    return snprintf(buf, buf_len, "%s", fallback);
+}
+
 static int v2_get_param(void *instance, const char *key, char *buf, int buf_len) {
     clap_fx_instance_t *inst = (clap_fx_instance_t*)instance;
     if (!inst || !key || !buf || buf_len <= 0) return -1;
 
     /* Check if a pending plugin load is ready */
     v2_check_pending_load(inst);
+    v2_check_audio_config(inst);
 
     /* Ensure plugins are scanned for list queries */
     if (strncmp(key, "plugin", 6) == 0) {
@@ -630,114 +988,172 @@ static int v2_get_param(void *instance, const char *key, char *buf, int buf_len)
     }
 
     /* Debug: log all get_param calls */
-    char msg[512];
-    snprintf(msg, sizeof(msg), "v2_get_param: key='%s' plugin_count=%d selected_idx=%d",
+    V2_FX_LOG(CLAP_HOST_LOG_DEBUG, "v2_get_param: key='%s' plugin_count=%d selected_idx=%d",
              key, inst->plugin_list.count, inst->selected_plugin_index);
-    v2_fx_log(msg);
 
-    if (strcmp(key, "plugin_id") == 0) {
-        return snprintf(buf, buf_len, "%s", inst->selected_plugin_id);
-    }
-    else if (strcmp(key, "plugin_name") == 0 || strcmp(key, "preset_name") == 0) {
-        if (inst->selected_plugin_index >= 0 && inst->selected_plugin_index < inst->plugin_list.count) {
-            return snprintf(buf, buf_len, "%s", inst->plugin_list.items[inst->selected_plugin_index].name);
-        }
-        return snprintf(buf, buf_len, "None");
-    }
-    else if (strcmp(key, "plugin_count") == 0) {
-        return snprintf(buf, buf_len, "%d", inst->plugin_list.count);
-    }
-    else if (strcmp(key, "plugin_index") == 0) {
-        return snprintf(buf, buf_len, "%d", inst->selected_plugin_index >= 0 ? inst->selected_plugin_index : 0);
-    }
-    /* plugin_<idx>_name - for list display */
-    else if (strncmp(key, "plugin_", 7) == 0 && strstr(key, "_name")) {
-        int idx = atoi(key + 7);
-        if (idx >= 0 && idx < inst->plugin_list.count) {
-            return snprintf(buf, buf_len, "%s", inst->plugin_list.items[idx].name);
+    param_key_t k;
+    if (param_key_parse(key, &k)) {
+        switch (k.hash) {
+        PARAM_KEY_CASE(k, "plugin_id")
+            return snprintf(buf, buf_len, "%s", inst->selected_plugin_id);
+        PARAM_KEY_CASE(k, "plugin_name")
+            return v2_selected_plugin_name(inst, "None", buf, buf_len);
+        PARAM_KEY_CASE(k, "preset_name")
+            return v2_selected_plugin_name(inst, "None", buf, buf_len);
+        PARAM_KEY_CASE(k, "plugin_count")
+            return snprintf(buf, buf_len, "%d", inst->plugin_list.count);
+        PARAM_KEY_CASE(k, "plugin_index")
+            return snprintf(buf, buf_len, "%d", inst->selected_plugin_index >= 0 ? inst->selected_plugin_index : 0);
+        /* plugin_<idx>_name - for list display */
+        PARAM_KEY_CASE(k, "plugin_N_name")
+            if (k.index < inst->plugin_list.count) {
+                return snprintf(buf, buf_len, "%s", inst->plugin_list.items[k.index].name);
+            }
+            return snprintf(buf, buf_len, "---");
+        PARAM_KEY_CASE(k, "param_count")
+            return snprintf(buf, buf_len, "%d", v2_param_meta_sync(inst)->count);
+        /* Module groups: group_count, group_name_N, group_params_N (param indexes, comma separated) */
+        PARAM_KEY_CASE(k, "group_count") {
+            param_meta_store_t *m = v2_param_meta_sync(inst);
+            v2_param_meta_fill_all(inst);
+            return snprintf(buf, buf_len, "%d", m->count ? m->group_count : 0);
         }
-        return snprintf(buf, buf_len, "---");
-    }
-    else if (strcmp(key, "param_count") == 0) {
-        return snprintf(buf, buf_len, "%d", clap_param_count(&inst->current_plugin));
-    }
-    /* chain_params - return metadata array for UI display */
-    else if (strcmp(key, "chain_params") == 0) {
-        /* Build JSON array with param metadata from cache */
-        int count = inst->cached_param_count;
-        if (count > 8) count = 8;  /* Limit to 8 params for knobs */
-        if (count == 0) {
-            return snprintf(buf, buf_len, "[]");
+        PARAM_KEY_CASE(k, "group_name_N") {
+            param_meta_store_t *m = v2_param_meta_sync(inst);
+            v2_param_meta_fill_all(inst);
+            if (k.index >= m->group_count) return -1;
+            return snprintf(buf, buf_len, "%s", m->groups[k.index]);
         }
-
-        int offset = snprintf(buf, buf_len, "[");
-        for (int i = 0; i < count && offset < buf_len - 100; i++) {
-            if (i > 0) offset += snprintf(buf + offset, buf_len - offset, ",");
-            offset += snprintf(buf + offset, buf_len - offset,
-                "{\"key\":\"param_%d\",\"name\":\"%s\",\"type\":\"float\",\"min\":%.3f,\"max\":%.3f}",
-                i, inst->cached_param_names[i], inst->cached_param_min[i], inst->cached_param_max[i]);
+        PARAM_KEY_CASE(k, "group_params_N") {
+            param_meta_store_t *m = v2_param_meta_sync(inst);
+            v2_param_meta_fill_all(inst);
+            if (k.index >= m->group_count) return -1;
+            int offset = 0;
+            buf[0] = '\0';
+            for (int i = 0; i < m->count && offset < buf_len - 12; i++) {
+                if (m->params[i].group != k.index) continue;
+                offset += snprintf(buf + offset, buf_len - offset, offset ? ",%d" : "%d", i);
+            }
+            return offset;
         }
-        offset += snprintf(buf + offset, buf_len - offset, "]");
-        return offset;
-    }
-    else if (strncmp(key, "param_name_", 11) == 0) {
-        int idx = atoi(key + 11);
-        char name[64] = "";
-        if (clap_param_info(&inst->current_plugin, idx, name, sizeof(name), NULL, NULL, NULL) == 0) {
-            return snprintf(buf, buf_len, "%s", name);
+        /* chain_params - the current remote-control page's knobs, for UI display */
+        PARAM_KEY_CASE(k, "chain_params") {
+            int offset = snprintf(buf, buf_len, "[");
+            bool first = true;
+            for (int knob = 0; knob < CLAP_KNOBS_PER_PAGE && offset < buf_len - 100; knob++) {
+                int idx = v2_knob_shown(inst, knob);
+                const param_meta_t *p = v2_param_meta(inst, idx);
+                if (!p) continue;
+                if (!first) offset += snprintf(buf + offset, buf_len - offset, ",");
+                first = false;
+                offset += snprintf(buf + offset, buf_len - offset,
+                    "{\"key\":\"knob_%d\",\"name\":\"%s\",\"type\":\"float\",\"min\":%.3f,\"max\":%.3f}",
+                    knob, p->name, p->min, p->max);
+            }
+            offset += snprintf(buf + offset, buf_len - offset, "]");
+            return offset;
         }
-        return snprintf(buf, buf_len, "Param %d", idx);
-    }
-    else if (strncmp(key, "param_value_", 12) == 0) {
-        int idx = atoi(key + 12);
-        double value = clap_param_get(&inst->current_plugin, idx);
-        return snprintf(buf, buf_len, "%.3f", value);
-    }
-    /* Handle param_0, param_1, etc. - return value as string */
-    else if (strncmp(key, "param_", 6) == 0 && key[6] >= '0' && key[6] <= '9') {
-        int idx = atoi(key + 6);
-        if (inst->current_plugin.plugin) {
-            double value = clap_param_get(&inst->current_plugin, idx);
-            return snprintf(buf, buf_len, "%.3f", value);
+        PARAM_KEY_CASE(k, "page")
+            return snprintf(buf, buf_len, "%d", inst->page);
+        PARAM_KEY_CASE(k, "page_count")
+            return snprintf(buf, buf_len, "%d", v2_page_count(inst));
+        PARAM_KEY_CASE(k, "page_name")
+            return v2_page_name(inst, buf, buf_len);
+        /* params_gen is cheap to poll; params_snapshot only needs reading when it changes */
+        PARAM_KEY_CASE(k, "params_gen")
+            return snprintf(buf, buf_len, "%u", v2_params_snapshot(inst));
+        PARAM_KEY_CASE(k, "params_snapshot")
+            v2_params_snapshot(inst);
+            return v2_snapshot_read(&inst->snapshot, buf, buf_len);
+        /* knob_text_N - the knob's value as the plugin displays it (units included) */
+        PARAM_KEY_CASE(k, "knob_text_N") {
+            int idx = v2_knob_param(inst, k.index);
+            if (idx < 0) return -1;
+            return clap_param_text(&inst->current_plugin, idx, buf, buf_len);
         }
-        return snprintf(buf, buf_len, "0.0");
-    }
-    /* Handle 'name' query (alias for plugin_name) */
-    else if (strcmp(key, "name") == 0) {
-        if (inst->selected_plugin_index >= 0 && inst->selected_plugin_index < inst->plugin_list.count) {
-            return snprintf(buf, buf_len, "%s", inst->plugin_list.items[inst->selected_plugin_index].name);
+        PARAM_KEY_CASE(k, "knob_N") {
+            int idx = v2_knob_param(inst, k.index);
+            if (idx < 0) return -1;
+            return snprintf(buf, buf_len, "%.3f", clap_param_get(&inst->current_plugin, idx));
         }
-        return snprintf(buf, buf_len, "CLAP FX");
-    }
-    /* param_N_label - return display name for param N */
-    else if (strncmp(key, "param_", 6) == 0 && strstr(key, "_label")) {
-        int idx = atoi(key + 6);
-        if (idx >= 0 && idx < inst->cached_param_count) {
-            return snprintf(buf, buf_len, "%s", inst->cached_param_names[idx]);
+        PARAM_KEY_CASE(k, "param_name_N") {
+            const param_meta_t *p = v2_param_meta(inst, k.index);
+            if (p) return snprintf(buf, buf_len, "%s", p->name);
+            return snprintf(buf, buf_len, "Param %d", k.index);
         }
-        /* Query from plugin if not cached */
-        char name[64] = "";
-        if (clap_param_info(&inst->current_plugin, idx, name, sizeof(name), NULL, NULL, NULL) == 0 && name[0]) {
-            return snprintf(buf, buf_len, "%s", name);
+        PARAM_KEY_CASE(k, "param_value_N")
+            return snprintf(buf, buf_len, "%.3f", clap_param_get(&inst->current_plugin, k.index));
+        PARAM_KEY_CASE(k, "param_text_N")
+            return clap_param_text(&inst->current_plugin, k.index, buf, buf_len);
+        /* Handle param_0, param_1, etc. - return value as string */
+        PARAM_KEY_CASE(k, "param_N")
+            if (inst->current_plugin.plugin) {
+                return snprintf(buf, buf_len, "%.3f", clap_param_get(&inst->current_plugin, k.index));
+            }
+            return snprintf(buf, buf_len, "0.0");
+        /* Handle 'name' query (alias for plugin_name) */
+        PARAM_KEY_CASE(k, "name")
+            return v2_selected_plugin_name(inst, "CLAP FX", buf, buf_len);
+        /* param_N_label - return display name for param N */
+        PARAM_KEY_CASE(k, "param_N_label") {
+            const param_meta_t *p = v2_param_meta(inst, k.index);
+            if (p) return snprintf(buf, buf_len, "%s", p->name);
+            return snprintf(buf, buf_len, "Param %d", k.index);
         }
-        return snprintf(buf, buf_len, "Param %d", idx);
-    }
-    /* ui_hierarchy - use param_0-7 keys with labels */
-    else if (strcmp(key, "ui_hierarchy") == 0) {
-        const char *hierarchy = "{"
-            "\"modes\":null,"
-            "\"levels\":{"
-                "\"root\":{"
-                    "\"list_param\":\"plugin_index\","
-                    "\"count_param\":\"plugin_count\","
-                    "\"name_param\":\"plugin_name\","
-                    "\"children\":null,"
-                    "\"knobs\":[\"param_0\",\"param_1\",\"param_2\",\"param_3\",\"param_4\",\"param_5\",\"param_6\",\"param_7\"],"
-                    "\"params\":[\"param_0\",\"param_1\",\"param_2\",\"param_3\",\"param_4\",\"param_5\",\"param_6\",\"param_7\"]"
+        /* ui_hierarchy - knobs follow the current remote-control page */
+        PARAM_KEY_CASE(k, "ui_hierarchy") {
+            const char *hierarchy = "{"
+                "\"modes\":null,"
+                "\"levels\":{"
+                    "\"root\":{"
+                        "\"list_param\":\"plugin_index\","
+                        "\"count_param\":\"plugin_count\","
+                        "\"name_param\":\"plugin_name\","
+                        "\"children\":null,"
+                        "\"knobs\":[\"knob_0\",\"knob_1\",\"knob_2\",\"knob_3\",\"knob_4\",\"knob_5\",\"knob_6\",\"knob_7\"],"
+                        "\"params\":[\"page\",\"knob_0\",\"knob_1\",\"knob_2\",\"knob_3\",\"knob_4\",\"knob_5\",\"knob_6\",\"knob_7\"]"
+                    "}"
                 "}"
-            "}"
-        "}";
-        return snprintf(buf, buf_len, "%s", hierarchy);
+            "}";
+            return snprintf(buf, buf_len, "%s", hierarchy);
+        }
+        PARAM_KEY_CASE(k, "sidechain")
+            return clap_sidechain_format(inst->sidechain_source, buf, buf_len);
+        PARAM_KEY_CASE(k, "sidechain_send")
+            return clap_sidechain_format(inst->sidechain_send, buf, buf_len);
+        PARAM_KEY_CASE(k, "aux_outputs")
+            return snprintf(buf, buf_len, "%d", inst->aux_outputs ? 1 : 0);
+        PARAM_KEY_CASE(k, "midi_out")
+            return snprintf(buf, buf_len, "%s", k_midi_out_names[inst->midi_out]);
+        PARAM_KEY_CASE(k, "sleeping")
+            return snprintf(buf, buf_len, "%d", inst->current_plugin.sleeping ? 1 : 0);
+        PARAM_KEY_CASE(k, "sleep_ms")
+            return snprintf(buf, buf_len, "%.0f", clap_sleep_ms(&inst->current_plugin));
+        PARAM_KEY_CASE(k, "pool_speedup")
+            return snprintf(buf, buf_len, "%.2f", clap_thread_pool_speedup(&inst->current_plugin));
+        PARAM_KEY_CASE(k, "latency")
+            return snprintf(buf, buf_len, "%u", clap_latency(&inst->current_plugin));
+        PARAM_KEY_CASE(k, "mix")
+            return snprintf(buf, buf_len, "%.2f", inst->mix);
+        PARAM_KEY_CASE(k, "state") {
+            /* Written to <module>/states for the patch to reference, named by content */
+            char dir[512], path[1024];
+            snprintf(dir, sizeof(dir), "%s/states", inst->module_dir);
+            if (clap_state_write_file(&inst->current_plugin, dir, path, sizeof(path)) != 0) return -1;
+            return snprintf(buf, buf_len, "%s", path);
+        }
+        PARAM_KEY_CASE(k, "sandbox")
+            return snprintf(buf, buf_len, "%d", inst->sandbox ? 1 : 0);
+        PARAM_KEY_CASE(k, "sandbox_restarts")
+            return snprintf(buf, buf_len, "%d", clap_sandbox_restarts(&inst->current_plugin));
+        PARAM_KEY_CASE(k, "sandbox_ipc_us")
+            return snprintf(buf, buf_len, "%.1f", clap_sandbox_ipc_us(&inst->current_plugin));
+        PARAM_KEY_CASE(k, "log_level")
+            return clap_log_level_format(clap_log_get_level(), buf, buf_len);
+        /* perf_stats - process-time histograms, only in builds with CLAP_HOST_PERF */
+        PARAM_KEY_CASE(k, "perf_stats")
+            return clap_perf_stats(&inst->current_plugin, buf, buf_len);
+        }
     }
 
     /* Fallback: try to find param by sanitized name key */
@@ -755,6 +1171,7 @@ static audio_fx_api_v2_t g_fx_api_v2;
 
 extern "C" audio_fx_api_v2_t* move_audio_fx_init_v2(const host_api_v1_t *host) {
     g_host = host;
+    clap_host_set_audio_config(host->sample_rate, host->frames_per_block);
 
     memset(&g_fx_api_v2, 0, sizeof(g_fx_api_v2));
     g_fx_api_v2.api_version = AUDIO_FX_API_VERSION_2;
@@ -764,7 +1181,7 @@ extern "C" audio_fx_api_v2_t* move_audio_fx_init_v2(const host_api_v1_t *host) {
     g_fx_api_v2.set_param = v2_set_param;
     g_fx_api_v2.get_param = v2_get_param;
 
-    v2_fx_log("CLAP FX V2 API initialized");
+    V2_FX_LOG(CLAP_HOST_LOG_INFO, "CLAP FX V2 API initialized");
 
     return &g_fx_api_v2;
 }
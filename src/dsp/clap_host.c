@@ -1,9 +1,13 @@
 /*
  * CLAP Host Core - Plugin discovery, loading, and processing
  */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE                  /* pthread_setaffinity_np */
+#endif
 #include "clap_host.h"
 #include "clap/clap.h"
 #include "clap/factory/plugin-factory.h"
+#include "clap/factory/preset-discovery.h"
 #include "clap/ext/audio-ports.h"
 #include "clap/ext/note-ports.h"
 #include "clap/ext/params.h"
@@ -16,52 +20,261 @@
 #include "clap/ext/voice-info.h"
 #include "clap/ext/note-name.h"
 #include "clap/ext/audio-ports-config.h"
+#include "clap/ext/audio-ports-activation.h"
+#include "clap/ext/thread-pool.h"
+#include "clap/ext/timer-support.h"
+#include "clap/ext/posix-fd-support.h"
+#include "clap/ext/preset-load.h"
+#include "clap/ext/remote-controls.h"
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <dlfcn.h>
 #include <dirent.h>
 #include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <linux/futex.h>
 
-/* Sample rate for activation */
-#define HOST_SAMPLE_RATE 44100.0
+/* Activation defaults, replaced by the Move host's real config via clap_host_set_audio_config() */
+#define HOST_DEFAULT_SAMPLE_RATE 44100.0
+#define HOST_DEFAULT_MAX_FRAMES 128
 #define HOST_MIN_FRAMES 1
 #define HOST_MAX_FRAMES 4096
 
-/* MIDI event queue */
+/* Longest we wait for the audio thread to leave process() before re-activating */
+#define HOST_SUSPEND_TIMEOUT_US 1000000
+
+static double s_sample_rate = HOST_DEFAULT_SAMPLE_RATE;
+static int s_max_frames = HOST_DEFAULT_MAX_FRAMES;
+
+/* Output below this level counts as quiet for CLAP_PROCESS_CONTINUE_IF_NOT_QUIET (~-100 dB) */
+#define HOST_QUIET_THRESHOLD 1e-5f
+
+/* MIDI events */
 #define MAX_MIDI_EVENTS 256
 typedef struct {
     uint8_t data[3];
     int len;
 } midi_event_t;
 
-static midi_event_t s_midi_queue[MAX_MIDI_EVENTS];
-static int s_midi_queue_count = 0;
-static pthread_mutex_t s_midi_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* CLAP event storage for a process block - MIDI translates to any of these */
+typedef union {
+    clap_event_header_t header;
+    clap_event_note_t note;
+    clap_event_note_expression_t expr;
+    clap_event_midi_t midi;
+} midi_clap_event_t;
+
+/*
+ * Per-instance event state, preallocated at load so instances can process on any thread.
+ * The MIDI rings are single producer/single consumer: MIDI in is written by the
+ * module's on_midi and read at the start of the block, MIDI out is written by the
+ * plugin's try_push and read by the module right after the block. Param values the
+ * plugin reports are published straight into the param table.
+ */
+#define HOST_EVENT_RING_SIZE 256    /* Power of two */
+#define HOST_VOICE_SLOTS (16 * 128) /* One per channel/key */
+
+typedef struct clap_events {
+    midi_event_t midi_in[HOST_EVENT_RING_SIZE];
+    uint32_t midi_in_head;          /* Written by clap_send_midi */
+    uint32_t midi_in_tail;          /* Written by the audio thread */
+    midi_event_t midi[HOST_EVENT_RING_SIZE];
+    uint32_t midi_head;             /* Written by the audio thread */
+    uint32_t midi_tail;             /* Written by the reader */
+    /* Input events for the block being processed */
+    midi_clap_event_t in_events[MAX_MIDI_EVENTS];
+    int in_event_count;
+    const clap_event_param_value_t *param_events;  /* Storage is in the param table */
+    int param_event_count;
+    /* Voice accounting - set on note on, cleared on CLAP_EVENT_NOTE_END, or on note off
+       while the plugin hasn't sent a NOTE_END (many never do) */
+    uint64_t voice_bits[HOST_VOICE_SLOTS / 64];
+    int voices;
+    bool note_ends;                 /* The plugin has reported a NOTE_END */
+} clap_events_t;
+
+/*
+ * Parameter table snapshotted from clap_plugin_params at load, struct-of-arrays so
+ * UI polling touches only the arrays it reads. Rebuilt when the plugin calls rescan,
+ * with the audio thread suspended - the audio thread looks ids up to publish values.
+ */
+#define HOST_PARAM_TEXT_SIZE 32     /* Display strings - a knob readout, not a label */
+
+typedef struct clap_param_cache {
+    uint32_t count;
+    int gen;                         /* params rescan generation at build time */
+    const clap_plugin_params_t *params;
+    clap_id *ids;
+    void **cookies;
+    double *min;
+    double *max;
+    double *def;
+    uint32_t *flags;
+    char (*names)[CLAP_NAME_SIZE];
+    uint32_t *module_off;            /* Offset of the param's module path in module_pool, 0 = "" */
+    char *module_pool;
+    size_t module_pool_len;
+    size_t module_pool_cap;
+    double *values;                  /* Value mirror, atomic - what we sent plus what the plugin reported */
+    uint32_t values_gen;             /* Bumped when a mirrored value changes, atomic */
+    /*
+     * Changes from the UI, coalesced per param (last value wins). The UI thread stores
+     * the value then sets its dirty bit and the bit's summary bit; the audio thread
+     * takes whole words, so a block costs O(changed params) and nothing is dropped.
+     */
+    double *pending;
+    uint64_t *dirty;                 /* One bit per param */
+    uint64_t *dirty_summary;         /* One bit per dirty word */
+    uint32_t dirty_words;
+    clap_event_param_value_t *events; /* Per-block event storage, one slot per param */
+    /* id -> index, open addressing, stores index + 1 (0 = empty) */
+    uint32_t *hash;
+    uint32_t hash_mask;
+    /*
+     * value_to_text results, one per param, reused until the value changes. Allocated
+     * on first use and touched only off the audio thread with s_loop_mutex held.
+     */
+    char (*text)[HOST_PARAM_TEXT_SIZE];
+    double *text_value;              /* Value each string was rendered from */
+    uint8_t *text_valid;
+} clap_param_cache_t;
+
+/* Growable byte buffer behind the state streams - capacity is kept across saves */
+#define HOST_STATE_PREALLOC (16 * 1024)
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+    size_t pos;                      /* Read position */
+    bool failed;                     /* A write could not grow the buffer */
+} state_buf_t;
+
+#ifdef CLAP_HOST_PERF
+/*
+ * Process-time stats (CLAP_HOST_PERF builds) - per block, the time inside
+ * plugin->process and the host's own time around it. Log-bucket histograms: bucket 0
+ * is under 0.25 us, then 4 linear buckets per octave up to ~200 ms. Written only by the
+ * audio thread; a reset is requested and carried out at the start of the next block.
+ */
+#define HOST_PERF_BUCKETS 80
+#define HOST_PERF_MIN_SHIFT 8            /* 256 ns, top of bucket 0 */
+
+typedef struct {
+    uint64_t count;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t sum_ns;
+    uint32_t buckets[HOST_PERF_BUCKETS];
+} perf_hist_t;
+
+typedef struct {
+    perf_hist_t plugin;              /* plugin->process, summed over a block's chunks */
+    perf_hist_t host;                /* Rest of clap_process_block* */
+    uint64_t over_budget;            /* Blocks that took longer than they last */
+    uint64_t budget_ns;              /* Length of the last block */
+    uint64_t block_plugin_ns;        /* Plugin time so far this block */
+    bool block_ran;                  /* process() was called this block (not asleep) */
+    int reset_requested;
+} host_perf_t;
+#endif
+
+/*
+ * Per-instance host - each instance hands its plugin its own clap_host_t with host_data
+ * pointing back at the instance, so callbacks know which plugin they came from.
+ * Generations are bumped by the plugin and compared against what the host last read.
+ */
+typedef struct clap_instance_host {
+    clap_host_t host;
+    int params_gen;                  /* params->rescan */
+    int tail_gen;                    /* tail->changed */
+    int latency_gen;                 /* latency->changed */
+    int remote_gen;                  /* remote_controls->changed */
+    int restart_requested;           /* Serviced by the main loop */
+    int process_requested;           /* Wakes a sleeping plugin on the next block */
+    int thread_pool_queried;         /* Plugin fetched the thread pool extension - workers start on the main loop */
+    pthread_t audio_thread;          /* Last thread that ran process(), valid once audio_thread_set */
+    int audio_thread_set;
+    /* State snapshots, taken on the main loop after state->mark_dirty (guarded by s_loop_mutex) */
+    int state_dirty;
+    bool state_valid;                /* state_snap holds the current state */
+    state_buf_t state_snap;
+    state_buf_t state_scratch;       /* Save target, swapped with state_snap on success */
+#ifdef CLAP_HOST_PERF
+    host_perf_t perf;
+#endif
+} clap_instance_host_t;
+
+/* Helper: the instance a host callback belongs to, NULL for the scanner's host */
+static clap_instance_t *host_inst(const clap_host_t *host) {
+    return host ? (clap_instance_t *)host->host_data : NULL;
+}
+
+static clap_instance_host_t *host_ctx(const clap_host_t *host) {
+    clap_instance_t *inst = host_inst(host);
+    return inst ? inst->host : NULL;
+}
 
-/* Track main thread ID for thread check */
+/* Track main thread ID for thread check - the first thread to scan or load */
 static pthread_t s_main_thread;
-static int s_main_thread_set = 0;
+static int s_main_thread_set = 0;               /* Atomic, s_main_thread is valid once set */
+
+static void host_record_main_thread(void) {
+    if (__atomic_load_n(&s_main_thread_set, __ATOMIC_ACQUIRE)) return;
+    s_main_thread = pthread_self();
+    __atomic_store_n(&s_main_thread_set, 1, __ATOMIC_RELEASE);
+}
+
+#define HOST_LOG(level, ...) CLAP_HOST_LOG(level, "CLAP", __VA_ARGS__)
 
 /* Host callbacks (minimal implementation) */
 static void host_log(const clap_host_t *host, clap_log_severity severity, const char *msg) {
-    fprintf(stderr, "[CLAP] %s\n", msg);
+    /* Plugins log from any thread, the audio thread included - the logger doesn't block */
+    int level = CLAP_HOST_LOG_DEBUG;
+    if (severity >= CLAP_LOG_ERROR) level = CLAP_HOST_LOG_ERROR;
+    else if (severity == CLAP_LOG_WARNING) level = CLAP_HOST_LOG_WARN;
+    else if (severity == CLAP_LOG_INFO) level = CLAP_HOST_LOG_INFO;
+    HOST_LOG(level, "%s", msg ? msg : "");
 }
 
 static const clap_host_log_t s_host_log = {
     .log = host_log
 };
 
-/* Thread check extension - prevents crashes from thread assertions */
-static bool host_is_main_thread(const clap_host_t *host) {
-    if (!s_main_thread_set) return true;
-    return pthread_equal(pthread_self(), s_main_thread);
-}
+static __thread int s_on_main_loop = 0;      /* Set on the main-loop thread */
+static __thread int s_rt_thread = 0;         /* Set on threads that have run process() or pool tasks */
 
+/* Thread check extension - the audio thread is whichever thread last processed the instance */
 static bool host_is_audio_thread(const clap_host_t *host) {
-    /* In our single-threaded host, audio runs on main thread */
-    return true;
+    clap_instance_host_t *ctx = host_ctx(host);
+    if (!ctx || !__atomic_load_n(&ctx->audio_thread_set, __ATOMIC_ACQUIRE)) return false;
+    return pthread_equal(pthread_self(), __atomic_load_n(&ctx->audio_thread, __ATOMIC_RELAXED));
+}
+
+static bool host_is_main_thread(const clap_host_t *host) {
+    if (s_on_main_loop) return true;
+    if (host_is_audio_thread(host)) return false;
+    if (!__atomic_load_n(&s_main_thread_set, __ATOMIC_ACQUIRE)) return true;
+    return pthread_equal(pthread_self(), s_main_thread);
 }
 
 static const clap_host_thread_check_t s_host_thread_check = {
@@ -69,44 +282,54 @@ static const clap_host_thread_check_t s_host_thread_check = {
     .is_audio_thread = host_is_audio_thread
 };
 
-/* State extension - stub implementation */
+static void loop_wake(void);
+
+/* State extension - the main loop snapshots the state in the background */
 static void host_state_mark_dirty(const clap_host_t *host) {
-    /* No-op: we don't track dirty state */
+    clap_instance_host_t *ctx = host_ctx(host);
+    if (!ctx) return;
+    __atomic_store_n(&ctx->state_dirty, 1, __ATOMIC_RELEASE);
+    loop_wake();
 }
 
 static const clap_host_state_t s_host_state = {
     .mark_dirty = host_state_mark_dirty
 };
 
-/* Latency extension - stub implementation */
+/* Latency extension - bump generation so the instance re-queries its latency */
 static void host_latency_changed(const clap_host_t *host) {
-    /* No-op: we don't compensate for latency */
+    clap_instance_host_t *ctx = host_ctx(host);
+    if (ctx) __atomic_add_fetch(&ctx->latency_gen, 1, __ATOMIC_RELEASE);
 }
 
 static const clap_host_latency_t s_host_latency = {
     .changed = host_latency_changed
 };
 
-/* Tail extension - stub implementation */
+/* Tail extension - bump generation so the instance re-queries its tail */
 static void host_tail_changed(const clap_host_t *host) {
-    /* No-op: we don't handle tail */
+    clap_instance_host_t *ctx = host_ctx(host);
+    if (ctx) __atomic_add_fetch(&ctx->tail_gen, 1, __ATOMIC_RELEASE);
 }
 
 static const clap_host_tail_t s_host_tail = {
     .changed = host_tail_changed
 };
 
-/* Params extension - stub implementation */
+/* Params extension - rescan bumps a generation so the instance rebuilds its param table */
 static void host_params_rescan(const clap_host_t *host, clap_param_rescan_flags flags) {
-    /* No-op: we re-query params on demand */
+    clap_instance_host_t *ctx = host_ctx(host);
+    if (ctx) __atomic_add_fetch(&ctx->params_gen, 1, __ATOMIC_RELEASE);
 }
 
 static void host_params_clear(const clap_host_t *host, clap_id param_id, clap_param_clear_flags flags) {
     /* No-op */
 }
 
+/* Asleep, queued values would wait for the next input - process the next block instead */
 static void host_params_request_flush(const clap_host_t *host) {
-    /* No-op: we don't support async param flush */
+    clap_instance_host_t *ctx = host_ctx(host);
+    if (ctx) __atomic_store_n(&ctx->process_requested, 1, __ATOMIC_RELEASE);
 }
 
 static const clap_host_params_t s_host_params = {
@@ -143,6 +366,21 @@ static const clap_host_gui_t s_host_gui = {
     .closed = host_gui_closed
 };
 
+/* Remote controls extension - the page table is rebuilt on the next main-thread query */
+static void host_remote_controls_changed(const clap_host_t *host) {
+    clap_instance_host_t *ctx = host_ctx(host);
+    if (ctx) __atomic_add_fetch(&ctx->remote_gen, 1, __ATOMIC_RELEASE);
+}
+
+static void host_remote_controls_suggest_page(const clap_host_t *host, clap_id page_id) {
+    /* Pages are picked by the user */
+}
+
+static const clap_host_remote_controls_t s_host_remote_controls = {
+    .changed = host_remote_controls_changed,
+    .suggest_page = host_remote_controls_suggest_page
+};
+
 /* Note name extension - stub implementation */
 static void host_note_name_changed(const clap_host_t *host) {}
 
@@ -157,9 +395,789 @@ static const clap_host_audio_ports_config_t s_host_audio_ports_config = {
     .rescan = host_audio_ports_config_rescan
 };
 
-static void host_request_restart(const clap_host_t *host) {}
-static void host_request_process(const clap_host_t *host) {}
-static void host_request_callback(const clap_host_t *host) {}
+/*
+ * Worker pool - realtime threads pinned to the cores the audio thread doesn't use.
+ * One job at a time: the caller publishes it, wakes the workers and works on it too,
+ * so the job finishes within the caller's block even if no worker shows up.
+ */
+#define HOST_POOL_MAX_WORKERS 3
+#define HOST_POOL_PRIORITY_BELOW_MAX 10  /* SCHED_FIFO priority, kept below the audio thread */
+
+typedef void (*pool_task_fn)(void *ctx, uint32_t index);
+
+typedef struct {
+    pthread_t threads[HOST_POOL_MAX_WORKERS];
+    int workers;
+    int users;                       /* Instances using the pool, workers run while > 0 */
+    int stop;
+    int busy;                        /* A job is running - further requests run inline */
+    int wake_seq;                    /* futex word, bumped for each job */
+    /* Current job - fn/ctx/count are only read by workers holding a claim for its generation */
+    pool_task_fn fn;
+    void *ctx;
+    uint32_t count;
+    uint64_t claim;                  /* job generation << 32 | next task index */
+    uint32_t done;
+    uint64_t task_ns;                /* Summed task time, for the speedup metric */
+} host_pool_t;
+
+static host_pool_t s_pool;
+static pthread_mutex_t s_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void futex_wait(int *addr, int val) {
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static void futex_wake_all(int *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+}
+
+/* Claim and run tasks of job gen until none are left */
+static void pool_run_tasks(uint32_t gen) {
+    uint64_t claim = __atomic_load_n(&s_pool.claim, __ATOMIC_ACQUIRE);
+    for (;;) {
+        if ((uint32_t)(claim >> 32) != gen ||
+            (uint32_t)claim >= __atomic_load_n(&s_pool.count, __ATOMIC_RELAXED)) break;
+        if (!__atomic_compare_exchange_n(&s_pool.claim, &claim, claim + 1, true,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) continue;
+        uint64_t t0 = now_ns();
+        s_pool.fn(s_pool.ctx, (uint32_t)claim);
+        __atomic_add_fetch(&s_pool.task_ns, now_ns() - t0, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&s_pool.done, 1, __ATOMIC_RELEASE);
+        claim = __atomic_load_n(&s_pool.claim, __ATOMIC_ACQUIRE);
+    }
+}
+
+static void *pool_worker(void *arg) {
+    (void)arg;
+    s_rt_thread = 1;
+    for (;;) {
+        int seq = __atomic_load_n(&s_pool.wake_seq, __ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&s_pool.stop, __ATOMIC_ACQUIRE)) break;
+        uint64_t claim = __atomic_load_n(&s_pool.claim, __ATOMIC_ACQUIRE);
+        pool_run_tasks((uint32_t)(claim >> 32));
+        futex_wait(&s_pool.wake_seq, seq);
+    }
+    return NULL;
+}
+
+/* Start the workers for the first user (main thread) */
+static void pool_acquire(void) {
+    pthread_mutex_lock(&s_pool_mutex);
+    if (s_pool.users++ == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        int workers = cpus > 1 ? (int)cpus - 1 : 0;
+        if (workers > HOST_POOL_MAX_WORKERS) workers = HOST_POOL_MAX_WORKERS;
+        s_pool.stop = 0;
+        s_pool.workers = 0;
+        for (int i = 0; i < workers; i++) {
+            /* Realtime priority when permitted, plain thread otherwise */
+            pthread_attr_t attr;
+            struct sched_param sp;
+            pthread_attr_init(&attr);
+            pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+            pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+            sp.sched_priority = sched_get_priority_max(SCHED_FIFO) - HOST_POOL_PRIORITY_BELOW_MAX;
+            pthread_attr_setschedparam(&attr, &sp);
+            int rc = pthread_create(&s_pool.threads[s_pool.workers], &attr, pool_worker, NULL);
+            pthread_attr_destroy(&attr);
+            if (rc != 0 && pthread_create(&s_pool.threads[s_pool.workers], NULL, pool_worker, NULL) != 0) break;
+
+            /* Pin to cores 1..n, leaving core 0 to the audio thread */
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET((i + 1) % cpus, &set);
+            pthread_setaffinity_np(s_pool.threads[s_pool.workers], sizeof(set), &set);
+            s_pool.workers++;
+        }
+    }
+    pthread_mutex_unlock(&s_pool_mutex);
+}
+
+static void pool_release(void) {
+    pthread_mutex_lock(&s_pool_mutex);
+    if (s_pool.users > 0 && --s_pool.users == 0) {
+        __atomic_store_n(&s_pool.stop, 1, __ATOMIC_RELEASE);
+        __atomic_add_fetch(&s_pool.wake_seq, 1, __ATOMIC_RELEASE);
+        futex_wake_all(&s_pool.wake_seq);
+        for (int i = 0; i < s_pool.workers; i++) pthread_join(s_pool.threads[i], NULL);
+        s_pool.workers = 0;
+    }
+    pthread_mutex_unlock(&s_pool_mutex);
+}
+
+/*
+ * Run fn(ctx, 0..count-1) across the pool and the calling thread, returning when all
+ * tasks are done. Runs everything inline when the pool is busy or has no workers.
+ * task_ns gets the summed task time. Returns true if the pool was used.
+ */
+static bool pool_exec(pool_task_fn fn, void *ctx, uint32_t count, uint64_t *task_ns) {
+    int expected = 0;
+    if (count == 0) return false;
+    if (__atomic_load_n(&s_pool.workers, __ATOMIC_RELAXED) == 0 || count == 1 ||
+        !__atomic_compare_exchange_n(&s_pool.busy, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        uint64_t t0 = now_ns();
+        for (uint32_t i = 0; i < count; i++) fn(ctx, i);
+        if (task_ns) *task_ns = now_ns() - t0;
+        return false;
+    }
+
+    /* Publish the job - a claim still in flight is for the old generation and fails */
+    uint32_t gen = (uint32_t)(__atomic_load_n(&s_pool.claim, __ATOMIC_RELAXED) >> 32) + 1;
+    s_pool.fn = fn;
+    s_pool.ctx = ctx;
+    __atomic_store_n(&s_pool.count, count, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_pool.done, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_pool.task_ns, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&s_pool.claim, (uint64_t)gen << 32, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&s_pool.wake_seq, 1, __ATOMIC_RELEASE);
+    futex_wake_all(&s_pool.wake_seq);
+
+    /* Work on it ourselves, then wait for tasks the workers claimed */
+    pool_run_tasks(gen);
+    while (__atomic_load_n(&s_pool.done, __ATOMIC_ACQUIRE) < count) {
+        sched_yield();
+    }
+    if (task_ns) *task_ns = __atomic_load_n(&s_pool.task_ns, __ATOMIC_RELAXED);
+
+    /* Close the job so a late worker can't claim past the next job's count */
+    __atomic_store_n(&s_pool.claim, ((uint64_t)gen << 32) | UINT32_MAX, __ATOMIC_RELEASE);
+    __atomic_store_n(&s_pool.busy, 0, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* Thread pool extension - plugin tasks run on the worker pool from inside process() */
+static __thread clap_instance_t *s_processing_inst = NULL;  /* Instance in process() on this thread */
+
+static void pool_plugin_task(void *ctx, uint32_t index) {
+    const clap_plugin_t *plugin = (const clap_plugin_t *)ctx;
+    const clap_plugin_thread_pool_t *tp =
+        (const clap_plugin_thread_pool_t *)plugin->get_extension(plugin, CLAP_EXT_THREAD_POOL);
+    tp->exec(plugin, index);
+}
+
+static bool host_thread_pool_request_exec(const clap_host_t *host, uint32_t num_tasks) {
+    clap_instance_t *inst = host_inst(host);
+    /* False until the main loop has started workers - the plugin runs the tasks itself */
+    if (!inst || inst != s_processing_inst || !__atomic_load_n(&inst->thread_pool, __ATOMIC_ACQUIRE)) return false;
+
+    uint64_t t0 = now_ns();
+    uint64_t task_ns = 0;
+    pool_exec(pool_plugin_task, (void *)inst->plugin, num_tasks, &task_ns);
+    __atomic_add_fetch(&inst->pool_wall_ns, now_ns() - t0, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&inst->pool_task_ns, task_ns, __ATOMIC_RELAXED);
+    return true;
+}
+
+static const clap_host_thread_pool_t s_host_thread_pool = {
+    .request_exec = host_thread_pool_request_exec
+};
+
+/*
+ * Logger - producers claim a ring slot with a CAS on head (a per-slot sequence says
+ * whether it is free), format into it and publish it; the writer thread drains the
+ * ring in order. Nothing on the producer side locks, allocates or does I/O.
+ */
+#define HOST_LOG_RING_SIZE 256           /* Records, power of two */
+#define HOST_LOG_RECORD_SIZE 256
+#define HOST_LOG_FLUSH_MS 100            /* Writer wake interval when nothing urgent is queued */
+
+typedef struct {
+    uint32_t seq;                    /* == position when free, position + 1 when published */
+    int level;
+    char text[HOST_LOG_RECORD_SIZE];
+} log_record_t;
+
+typedef struct {
+    log_record_t ring[HOST_LOG_RING_SIZE];
+    uint32_t head;                   /* Next position to claim */
+    uint32_t tail;                   /* Next position to write, writer thread only */
+    int level;                       /* Runtime level, atomic */
+    int level_set;                   /* Level came from clap_log_set_level, not the default */
+    int ring_ready;
+    int running;                     /* Writer is draining the ring, atomic */
+    int users;
+    int stop;
+    int wake_seq;                    /* futex word, bumped for errors and a filling ring */
+    uint32_t dropped;                /* Ring was full, atomic */
+    uint32_t limited;                /* Over the rate limit, writer thread only */
+    pthread_t thread;
+    FILE *file;
+    char file_path[512];
+    long file_max;
+    long file_size;
+    void (*sink)(const char *msg);
+} host_log_t;
+
+static host_log_t s_log = { .level = CLAP_HOST_LOG_INFO };
+static pthread_mutex_t s_log_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void futex_wait_ms(int *addr, int val, int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, &ts, NULL, 0);
+}
+
+void clap_log(int level, const char *tag, const char *fmt, ...) {
+    if (level > __atomic_load_n(&s_log.level, __ATOMIC_RELAXED)) return;
+
+    va_list args;
+    va_start(args, fmt);
+    if (!__atomic_load_n(&s_log.running, __ATOMIC_ACQUIRE)) {
+        /* No writer - stdio could block an audio thread, so count it there instead */
+        if (s_rt_thread) {
+            __atomic_add_fetch(&s_log.dropped, 1, __ATOMIC_RELAXED);
+            va_end(args);
+            return;
+        }
+        fprintf(stderr, "[%s] ", tag);
+        vfprintf(stderr, fmt, args);
+        fputc('\n', stderr);
+        va_end(args);
+        return;
+    }
+
+    uint32_t pos = __atomic_load_n(&s_log.head, __ATOMIC_RELAXED);
+    log_record_t *rec;
+    for (;;) {
+        rec = &s_log.ring[pos & (HOST_LOG_RING_SIZE - 1)];
+        int32_t diff = (int32_t)(__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&s_log.head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+        } else if (diff < 0) {
+            /* Full - the writer is behind, don't wait for it */
+            __atomic_add_fetch(&s_log.dropped, 1, __ATOMIC_RELAXED);
+            va_end(args);
+            return;
+        } else {
+            pos = __atomic_load_n(&s_log.head, __ATOMIC_RELAXED);
+        }
+    }
+
+    int n = snprintf(rec->text, sizeof(rec->text), "[%s] ", tag);
+    if (n < 0 || n >= (int)sizeof(rec->text)) n = 0;
+    vsnprintf(rec->text + n, sizeof(rec->text) - n, fmt, args);
+    va_end(args);
+    rec->level = level;
+    __atomic_store_n(&rec->seq, pos + 1, __ATOMIC_RELEASE);
+
+    /* Errors and a half-full ring don't wait for the writer's next interval */
+    if (level == CLAP_HOST_LOG_ERROR ||
+        pos - __atomic_load_n(&s_log.tail, __ATOMIC_RELAXED) == HOST_LOG_RING_SIZE / 2) {
+        __atomic_add_fetch(&s_log.wake_seq, 1, __ATOMIC_RELEASE);
+        futex_wake_all(&s_log.wake_seq);
+    }
+}
+
+/* Write one line to the outputs (writer thread) */
+static void log_write_line(const char *text) {
+    fprintf(stderr, "%s\n", text);
+    if (s_log.file) {
+        if (s_log.file_max > 0 && s_log.file_size >= s_log.file_max) {
+            /* Rotate - the file holds at most twice file_max across both halves */
+            char old_path[sizeof(s_log.file_path) + 2];
+            fclose(s_log.file);
+            snprintf(old_path, sizeof(old_path), "%s.1", s_log.file_path);
+            rename(s_log.file_path, old_path);
+            s_log.file = fopen(s_log.file_path, "w");
+            s_log.file_size = 0;
+        }
+        if (s_log.file) {
+            int n = fprintf(s_log.file, "%s\n", text);
+            if (n > 0) s_log.file_size += n;
+        }
+    }
+    if (s_log.sink) s_log.sink(text);
+}
+
+/* Write out everything published, at most CLAP_HOST_LOG_RATE records a second (writer thread) */
+static void log_drain(double *tokens, uint64_t *refill_ns) {
+    uint64_t now = now_ns();
+    *tokens += (double)(now - *refill_ns) * CLAP_HOST_LOG_RATE / 1e9;
+    if (*tokens > CLAP_HOST_LOG_RATE) *tokens = CLAP_HOST_LOG_RATE;
+    *refill_ns = now;
+
+    bool wrote = false;
+    for (;;) {
+        uint32_t pos = s_log.tail;
+        log_record_t *rec = &s_log.ring[pos & (HOST_LOG_RING_SIZE - 1)];
+        if (__atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE) != pos + 1) break;
+        if (rec->level == CLAP_HOST_LOG_ERROR || *tokens >= 1.0) {
+            if (rec->level != CLAP_HOST_LOG_ERROR) *tokens -= 1.0;
+            log_write_line(rec->text);
+            wrote = true;
+        } else {
+            s_log.limited++;
+        }
+        __atomic_store_n(&rec->seq, pos + HOST_LOG_RING_SIZE, __ATOMIC_RELEASE);
+        __atomic_store_n(&s_log.tail, pos + 1, __ATOMIC_RELEASE);
+    }
+
+    uint32_t dropped = __atomic_exchange_n(&s_log.dropped, 0, __ATOMIC_RELAXED);
+    if ((dropped || s_log.limited) && *tokens >= 1.0) {
+        char line[128];
+        snprintf(line, sizeof(line), "[CLAP] log: %u records over the rate limit, %u dropped (ring full)",
+                 s_log.limited, dropped);
+        *tokens -= 1.0;
+        log_write_line(line);
+        s_log.limited = 0;
+        wrote = true;
+    } else if (dropped) {
+        __atomic_add_fetch(&s_log.dropped, dropped, __ATOMIC_RELAXED);
+    }
+    if (wrote && s_log.file) fflush(s_log.file);
+}
+
+static void *log_thread(void *arg) {
+    (void)arg;
+    double tokens = CLAP_HOST_LOG_RATE;
+    uint64_t refill_ns = now_ns();
+    for (;;) {
+        int seq = __atomic_load_n(&s_log.wake_seq, __ATOMIC_ACQUIRE);
+        log_drain(&tokens, &refill_ns);
+        if (__atomic_load_n(&s_log.stop, __ATOMIC_ACQUIRE)) break;
+        futex_wait_ms(&s_log.wake_seq, seq, HOST_LOG_FLUSH_MS);
+    }
+    return NULL;
+}
+
+void clap_log_open(const char *file, long max_bytes, void (*sink)(const char *msg)) {
+    pthread_mutex_lock(&s_log_mutex);
+    if (s_log.users++ == 0) {
+        if (!s_log.ring_ready) {
+            for (uint32_t i = 0; i < HOST_LOG_RING_SIZE; i++) s_log.ring[i].seq = i;
+            s_log.ring_ready = 1;
+        }
+        const char *env = getenv("CLAP_LOG_LEVEL");
+        if (env && !s_log.level_set) __atomic_store_n(&s_log.level, clap_log_level_parse(env), __ATOMIC_RELAXED);
+
+        s_log.file = NULL;
+        s_log.file_path[0] = '\0';
+        if (file) {
+            struct stat st;
+            snprintf(s_log.file_path, sizeof(s_log.file_path), "%s", file);
+            s_log.file = fopen(file, "a");
+            s_log.file_size = stat(file, &st) == 0 ? (long)st.st_size : 0;
+        }
+        s_log.file_max = max_bytes;
+        s_log.sink = sink;
+        s_log.stop = 0;
+        __atomic_store_n(&s_log.running, 1, __ATOMIC_RELEASE);
+        if (pthread_create(&s_log.thread, NULL, log_thread, NULL) != 0) {
+            __atomic_store_n(&s_log.running, 0, __ATOMIC_RELEASE);
+            if (s_log.file) fclose(s_log.file);
+            s_log.file = NULL;
+        }
+    }
+    pthread_mutex_unlock(&s_log_mutex);
+}
+
+void clap_log_close(void) {
+    pthread_mutex_lock(&s_log_mutex);
+    if (s_log.users > 0 && --s_log.users == 0 && __atomic_load_n(&s_log.running, __ATOMIC_ACQUIRE)) {
+        /* Later records go to stderr directly (or are counted, on audio threads); the
+           writer's last drain takes the rest */
+        __atomic_store_n(&s_log.running, 0, __ATOMIC_RELEASE);
+        __atomic_store_n(&s_log.stop, 1, __ATOMIC_RELEASE);
+        __atomic_add_fetch(&s_log.wake_seq, 1, __ATOMIC_RELEASE);
+        futex_wake_all(&s_log.wake_seq);
+        pthread_join(s_log.thread, NULL);
+        if (s_log.file) fclose(s_log.file);
+        s_log.file = NULL;
+        s_log.sink = NULL;
+    }
+    pthread_mutex_unlock(&s_log_mutex);
+}
+
+void clap_log_set_level(int level) {
+    if (level < CLAP_HOST_LOG_ERROR) level = CLAP_HOST_LOG_ERROR;
+    if (level > CLAP_HOST_LOG_DEBUG) level = CLAP_HOST_LOG_DEBUG;
+    __atomic_store_n(&s_log.level, level, __ATOMIC_RELAXED);
+    s_log.level_set = 1;
+}
+
+int clap_log_get_level(void) {
+    return __atomic_load_n(&s_log.level, __ATOMIC_RELAXED);
+}
+
+static const char *const k_log_level_names[] = { "error", "warn", "info", "debug" };
+
+int clap_log_level_parse(const char *val) {
+    if (!val) return CLAP_HOST_LOG_INFO;
+    for (int i = CLAP_HOST_LOG_ERROR; i <= CLAP_HOST_LOG_DEBUG; i++) {
+        if (strcmp(val, k_log_level_names[i]) == 0) return i;
+    }
+    if (val[0] >= '0' && val[0] <= '3' && val[1] == '\0') return val[0] - '0';
+    return CLAP_HOST_LOG_INFO;
+}
+
+int clap_log_level_format(int level, char *buf, int buf_len) {
+    if (level < CLAP_HOST_LOG_ERROR || level > CLAP_HOST_LOG_DEBUG) level = CLAP_HOST_LOG_INFO;
+    return snprintf(buf, buf_len, "%s", k_log_level_names[level]);
+}
+
+/*
+ * Main loop - one epoll thread for all in-process instances. It fires plugin timers
+ * (a timerfd each), watches plugin fds and turns request_callback into on_main_thread,
+ * so plugins have somewhere other than the audio thread for housekeeping. Runs while
+ * instances are loaded; dispatch holds s_loop_mutex, which load and unload take to
+ * keep main-thread calls into a plugin from overlapping.
+ */
+#define HOST_LOOP_MAX_SOURCES 128
+#define HOST_LOOP_MAX_INSTANCES 64
+#define HOST_LOOP_MAX_EVENTS 16
+
+typedef struct {
+    clap_instance_t *inst;
+    int fd;                          /* timerfd (also the timer id), or the plugin's fd */
+    bool is_timer;
+    uint32_t flags;                  /* CLAP_POSIX_FD_* */
+} loop_source_t;
+
+typedef struct {
+    pthread_t thread;
+    int users;
+    int epoll_fd;
+    int wake_fd;                     /* eventfd - callback requests and stop */
+    int stop;
+    clap_instance_t *insts[HOST_LOOP_MAX_INSTANCES];
+    int inst_count;
+    loop_source_t sources[HOST_LOOP_MAX_SOURCES];
+    int source_count;
+} host_loop_t;
+
+static host_loop_t s_loop = { 0, 0, -1, -1 };
+static pthread_mutex_t s_loop_life_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t s_loop_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;  /* Plugins re-register from callbacks */
+
+static int reconfigure(clap_instance_t *inst, double sample_rate, int max_frames);
+static int state_snapshot(clap_instance_t *inst);
+
+/* Helper: is inst loaded and in the loop (caller holds s_loop_mutex) */
+static bool loop_has_inst(const clap_instance_t *inst) {
+    for (int i = 0; i < s_loop.inst_count; i++) {
+        if (s_loop.insts[i] == inst) return true;
+    }
+    return false;
+}
+
+static loop_source_t *loop_find_source(int fd, bool is_timer) {
+    for (int i = 0; i < s_loop.source_count; i++) {
+        if (s_loop.sources[i].fd == fd && s_loop.sources[i].is_timer == is_timer) return &s_loop.sources[i];
+    }
+    return NULL;
+}
+
+/* Helper: a source registered by inst - plugins can't touch each other's timers and fds */
+static loop_source_t *loop_find_owned_source(clap_instance_t *inst, int fd, bool is_timer) {
+    loop_source_t *src = loop_find_source(fd, is_timer);
+    return src && inst && src->inst == inst ? src : NULL;
+}
+
+static uint32_t loop_epoll_events(uint32_t flags) {
+    uint32_t events = 0;
+    if (flags & CLAP_POSIX_FD_READ) events |= EPOLLIN;
+    if (flags & CLAP_POSIX_FD_WRITE) events |= EPOLLOUT;
+    if (flags & CLAP_POSIX_FD_ERROR) events |= EPOLLERR;
+    return events;
+}
+
+static bool loop_add_source(clap_instance_t *inst, int fd, bool is_timer, uint32_t flags) {
+    if (!inst || s_loop.epoll_fd < 0 || s_loop.source_count >= HOST_LOOP_MAX_SOURCES) return false;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = is_timer ? EPOLLIN : loop_epoll_events(flags);
+    ev.data.fd = fd;
+    if (epoll_ctl(s_loop.epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) return false;
+    loop_source_t *src = &s_loop.sources[s_loop.source_count++];
+    src->inst = inst;
+    src->fd = fd;
+    src->is_timer = is_timer;
+    src->flags = flags;
+    return true;
+}
+
+static void loop_remove_source(loop_source_t *src) {
+    epoll_ctl(s_loop.epoll_fd, EPOLL_CTL_DEL, src->fd, NULL);
+    if (src->is_timer) close(src->fd);
+    *src = s_loop.sources[--s_loop.source_count];
+}
+
+/* Call one ready source back (caller holds s_loop_mutex) */
+static void loop_dispatch(int fd, uint32_t events) {
+    loop_source_t *src = loop_find_source(fd, true);
+    if (!src) src = loop_find_source(fd, false);
+    if (!src || !loop_has_inst(src->inst)) return;
+
+    clap_instance_t *inst = src->inst;
+    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
+    if (src->is_timer) {
+        uint64_t expirations;
+        if (read(fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+            const clap_plugin_timer_support_t *timer =
+                (const clap_plugin_timer_support_t *)plugin->get_extension(plugin, CLAP_EXT_TIMER_SUPPORT);
+            if (timer) timer->on_timer(plugin, (clap_id)fd);
+        }
+    } else {
+        const clap_plugin_posix_fd_support_t *posix_fd =
+            (const clap_plugin_posix_fd_support_t *)plugin->get_extension(plugin, CLAP_EXT_POSIX_FD_SUPPORT);
+        clap_posix_fd_flags_t flags = 0;
+        if (events & EPOLLIN) flags |= CLAP_POSIX_FD_READ;
+        if (events & EPOLLOUT) flags |= CLAP_POSIX_FD_WRITE;
+        if (events & (EPOLLERR | EPOLLHUP)) flags |= CLAP_POSIX_FD_ERROR;
+        if (posix_fd) posix_fd->on_fd(plugin, fd, flags);
+    }
+}
+
+/* Start workers for an instance whose plugin fetched the thread pool extension (main thread) */
+static void thread_pool_sync(clap_instance_t *inst) {
+    if (inst->thread_pool || !__atomic_load_n(&inst->host->thread_pool_queried, __ATOMIC_ACQUIRE)) return;
+    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
+    if (!plugin->get_extension(plugin, CLAP_EXT_THREAD_POOL)) return;
+    pool_acquire();
+    __atomic_store_n(&inst->thread_pool, true, __ATOMIC_RELEASE);
+}
+
+/* Deliver pending restarts and request_callback calls (caller holds s_loop_mutex) */
+static void loop_dispatch_callbacks(void) {
+    for (int i = 0; i < s_loop.inst_count; i++) {
+        clap_instance_t *inst = s_loop.insts[i];
+        if (__atomic_exchange_n(&inst->host->restart_requested, 0, __ATOMIC_ACQ_REL)) {
+            /* Deactivate and reactivate - ports are re-read, the audio thread skips it meanwhile */
+            HOST_LOG(CLAP_HOST_LOG_INFO, "Restart requested by %s", inst->path);
+            if (reconfigure(inst, inst->sample_rate, inst->max_frames) != 0) {
+                /* Still owed - the next wake tries again, without spinning on it here */
+                HOST_LOG(CLAP_HOST_LOG_WARN, "Restart of %s failed, retrying on the next wake", inst->path);
+                __atomic_store_n(&inst->host->restart_requested, 1, __ATOMIC_RELEASE);
+            }
+        }
+        if (__atomic_exchange_n(&inst->callback_requested, 0, __ATOMIC_ACQ_REL)) {
+            const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
+            plugin->on_main_thread(plugin);
+        }
+        if (__atomic_exchange_n(&inst->host->state_dirty, 0, __ATOMIC_ACQ_REL)) {
+            state_snapshot(inst);
+        }
+        thread_pool_sync(inst);
+    }
+}
+
+static void *loop_thread(void *arg) {
+    s_on_main_loop = 1;
+    struct epoll_event events[HOST_LOOP_MAX_EVENTS];
+    while (!__atomic_load_n(&s_loop.stop, __ATOMIC_ACQUIRE)) {
+        int n = epoll_wait(s_loop.epoll_fd, events, HOST_LOOP_MAX_EVENTS, -1);
+        if (n < 0) continue;  /* EINTR */
+
+        pthread_mutex_lock(&s_loop_mutex);
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.fd == s_loop.wake_fd) {
+                uint64_t count;
+                if (read(s_loop.wake_fd, &count, sizeof(count)) < 0) continue;
+                loop_dispatch_callbacks();
+            } else {
+                loop_dispatch(events[i].data.fd, events[i].events);
+            }
+        }
+        pthread_mutex_unlock(&s_loop_mutex);
+    }
+    return NULL;
+}
+
+/* Helper: wake the loop thread - async-signal and audio-thread safe */
+static void loop_wake(void) {
+    uint64_t one = 1;
+    if (s_loop.wake_fd >= 0 && write(s_loop.wake_fd, &one, sizeof(one)) < 0) {
+        /* Counter saturated - a wakeup is pending anyway */
+    }
+}
+
+/* Start the loop for one more instance; it only gets callbacks once loop_add_inst is called */
+static void loop_acquire(void) {
+    pthread_mutex_lock(&s_loop_life_mutex);
+    if (s_loop.users++ == 0) {
+        s_loop.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        s_loop.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        s_loop.stop = 0;
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = s_loop.wake_fd;
+        if (s_loop.epoll_fd < 0 || s_loop.wake_fd < 0 ||
+            epoll_ctl(s_loop.epoll_fd, EPOLL_CTL_ADD, s_loop.wake_fd, &ev) != 0 ||
+            pthread_create(&s_loop.thread, NULL, loop_thread, NULL) != 0) {
+            HOST_LOG(CLAP_HOST_LOG_ERROR, "main loop unavailable, timers and fds are not serviced");
+            if (s_loop.epoll_fd >= 0) close(s_loop.epoll_fd);
+            if (s_loop.wake_fd >= 0) close(s_loop.wake_fd);
+            s_loop.epoll_fd = s_loop.wake_fd = -1;
+        }
+    }
+    pthread_mutex_unlock(&s_loop_life_mutex);
+}
+
+/* Drop an instance's remaining timers and fds, stop the loop with the last instance */
+static void loop_release(clap_instance_t *inst) {
+    pthread_mutex_lock(&s_loop_life_mutex);
+    pthread_mutex_lock(&s_loop_mutex);
+    for (int i = s_loop.source_count - 1; i >= 0; i--) {
+        if (s_loop.sources[i].inst == inst) loop_remove_source(&s_loop.sources[i]);
+    }
+    pthread_mutex_unlock(&s_loop_mutex);
+
+    if (--s_loop.users == 0 && s_loop.epoll_fd >= 0) {
+        __atomic_store_n(&s_loop.stop, 1, __ATOMIC_RELEASE);
+        loop_wake();
+        pthread_join(s_loop.thread, NULL);
+        close(s_loop.epoll_fd);
+        close(s_loop.wake_fd);
+        s_loop.epoll_fd = s_loop.wake_fd = -1;
+    }
+    pthread_mutex_unlock(&s_loop_life_mutex);
+}
+
+/* Make a loaded instance eligible for callbacks */
+static void loop_add_inst(clap_instance_t *inst) {
+    pthread_mutex_lock(&s_loop_mutex);
+    if (s_loop.inst_count < HOST_LOOP_MAX_INSTANCES) s_loop.insts[s_loop.inst_count++] = inst;
+    pthread_mutex_unlock(&s_loop_mutex);
+    /* Requests made while loading */
+    if (__atomic_load_n(&inst->callback_requested, __ATOMIC_ACQUIRE) ||
+        __atomic_load_n(&inst->host->restart_requested, __ATOMIC_ACQUIRE) ||
+        (__atomic_load_n(&inst->host->thread_pool_queried, __ATOMIC_ACQUIRE) && !inst->thread_pool)) loop_wake();
+}
+
+/* Stop callbacks into an instance - returns once any in flight are done */
+static void loop_remove_inst(clap_instance_t *inst) {
+    pthread_mutex_lock(&s_loop_mutex);
+    for (int i = 0; i < s_loop.inst_count; i++) {
+        if (s_loop.insts[i] == inst) {
+            s_loop.insts[i] = s_loop.insts[--s_loop.inst_count];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_loop_mutex);
+}
+
+/* Timer support extension */
+static bool host_register_timer(const clap_host_t *host, uint32_t period_ms, clap_id *timer_id) {
+    clap_instance_t *inst = host_inst(host);
+    if (!inst || !timer_id) return false;
+
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) return false;
+    if (period_ms == 0) period_ms = 1;
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = period_ms / 1000;
+    spec.it_interval.tv_nsec = (long)(period_ms % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;
+    timerfd_settime(fd, 0, &spec, NULL);
+
+    pthread_mutex_lock(&s_loop_mutex);
+    bool ok = loop_add_source(inst, fd, true, 0);
+    pthread_mutex_unlock(&s_loop_mutex);
+    if (!ok) {
+        close(fd);
+        return false;
+    }
+    *timer_id = (clap_id)fd;
+    return true;
+}
+
+static bool host_unregister_timer(const clap_host_t *host, clap_id timer_id) {
+    pthread_mutex_lock(&s_loop_mutex);
+    loop_source_t *src = loop_find_owned_source(host_inst(host), (int)timer_id, true);
+    if (src) loop_remove_source(src);
+    pthread_mutex_unlock(&s_loop_mutex);
+    return src != NULL;
+}
+
+static const clap_host_timer_support_t s_host_timer_support = {
+    .register_timer = host_register_timer,
+    .unregister_timer = host_unregister_timer
+};
+
+/* POSIX fd support extension */
+static bool host_register_fd(const clap_host_t *host, int fd, clap_posix_fd_flags_t flags) {
+    clap_instance_t *inst = host_inst(host);
+    if (!inst) return false;
+    pthread_mutex_lock(&s_loop_mutex);
+    bool ok = !loop_find_source(fd, false) && loop_add_source(inst, fd, false, flags);
+    pthread_mutex_unlock(&s_loop_mutex);
+    return ok;
+}
+
+static bool host_modify_fd(const clap_host_t *host, int fd, clap_posix_fd_flags_t flags) {
+    pthread_mutex_lock(&s_loop_mutex);
+    loop_source_t *src = loop_find_owned_source(host_inst(host), fd, false);
+    bool ok = false;
+    if (src) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = loop_epoll_events(flags);
+        ev.data.fd = fd;
+        ok = epoll_ctl(s_loop.epoll_fd, EPOLL_CTL_MOD, fd, &ev) == 0;
+        if (ok) src->flags = flags;
+    }
+    pthread_mutex_unlock(&s_loop_mutex);
+    return ok;
+}
+
+static bool host_unregister_fd(const clap_host_t *host, int fd) {
+    pthread_mutex_lock(&s_loop_mutex);
+    loop_source_t *src = loop_find_owned_source(host_inst(host), fd, false);
+    if (src) loop_remove_source(src);
+    pthread_mutex_unlock(&s_loop_mutex);
+    return src != NULL;
+}
+
+static const clap_host_posix_fd_support_t s_host_posix_fd_support = {
+    .register_fd = host_register_fd,
+    .modify_fd = host_modify_fd,
+    .unregister_fd = host_unregister_fd
+};
+
+/* Requests may come from any thread, including audio - flag the instance and wake the loop */
+static void host_request_restart(const clap_host_t *host) {
+    clap_instance_host_t *ctx = host_ctx(host);
+    if (!ctx) return;
+    __atomic_store_n(&ctx->restart_requested, 1, __ATOMIC_RELEASE);
+    loop_wake();
+}
+
+static void host_request_process(const clap_host_t *host) {
+    clap_instance_host_t *ctx = host_ctx(host);
+    if (ctx) __atomic_store_n(&ctx->process_requested, 1, __ATOMIC_RELEASE);
+}
+
+static void host_request_callback(const clap_host_t *host) {
+    clap_instance_t *inst = host_inst(host);
+    if (!inst) return;
+    __atomic_store_n(&inst->callback_requested, 1, __ATOMIC_RELEASE);
+    loop_wake();
+}
+
+/* Preset load extension - outcome of clap_preset_load's from_location call */
+static void host_preset_on_error(const clap_host_t *host, uint32_t location_kind, const char *location,
+                                 const char *load_key, int32_t os_error, const char *msg) {
+    HOST_LOG(CLAP_HOST_LOG_ERROR, "preset %s%s%s failed to load: %s", location ? location : "",
+            load_key ? ":" : "", load_key ? load_key : "", msg ? msg : "");
+}
+
+static void host_preset_loaded(const clap_host_t *host, uint32_t location_kind, const char *location,
+                               const char *load_key) {
+    /* Nothing to track - clap_preset_load remembers the index */
+}
+
+static const clap_host_preset_load_t s_host_preset_load = {
+    .on_error = host_preset_on_error,
+    .loaded = host_preset_loaded
+};
 
 static const void *host_get_extension(const clap_host_t *host, const char *extension_id) {
     /* Core extensions */
@@ -174,10 +1192,23 @@ static const void *host_get_extension(const clap_host_t *host, const char *exten
     if (!strcmp(extension_id, CLAP_EXT_GUI)) return &s_host_gui;
     if (!strcmp(extension_id, CLAP_EXT_NOTE_NAME)) return &s_host_note_name;
     if (!strcmp(extension_id, CLAP_EXT_AUDIO_PORTS_CONFIG)) return &s_host_audio_ports_config;
+    if (!strcmp(extension_id, CLAP_EXT_TIMER_SUPPORT)) return &s_host_timer_support;
+    if (!strcmp(extension_id, CLAP_EXT_POSIX_FD_SUPPORT)) return &s_host_posix_fd_support;
+    if (!strcmp(extension_id, CLAP_EXT_REMOTE_CONTROLS)) return &s_host_remote_controls;
+    if (!strcmp(extension_id, CLAP_EXT_REMOTE_CONTROLS_COMPAT)) return &s_host_remote_controls;
+    if (!strcmp(extension_id, CLAP_EXT_PRESET_LOAD)) return &s_host_preset_load;
+    if (!strcmp(extension_id, CLAP_EXT_PRESET_LOAD_COMPAT)) return &s_host_preset_load;
+    if (!strcmp(extension_id, CLAP_EXT_THREAD_POOL)) {
+        /* May come after init, even from process() - the main loop picks it up */
+        clap_instance_host_t *ctx = host_ctx(host);
+        if (ctx && !__atomic_exchange_n(&ctx->thread_pool_queried, 1, __ATOMIC_ACQ_REL)) loop_wake();
+        return &s_host_thread_pool;
+    }
     /* Return NULL for unimplemented extensions - plugins should handle gracefully */
     return NULL;
 }
 
+/* Template for instance hosts, and the host of the scanner's temporary instances */
 static const clap_host_t s_host = {
     .clap_version = CLAP_VERSION,
     .host_data = NULL,
@@ -191,6 +1222,36 @@ static const clap_host_t s_host = {
     .request_callback = host_request_callback
 };
 
+static int instance_host_create(clap_instance_t *inst) {
+    clap_instance_host_t *ctx = (clap_instance_host_t *)calloc(1, sizeof(clap_instance_host_t));
+    if (!ctx) return -1;
+#ifdef CLAP_HOST_PERF
+    ctx->perf.plugin.min_ns = ctx->perf.host.min_ns = UINT64_MAX;
+#endif
+    ctx->state_snap.data = (uint8_t *)malloc(HOST_STATE_PREALLOC);
+    ctx->state_scratch.data = (uint8_t *)malloc(HOST_STATE_PREALLOC);
+    if (!ctx->state_snap.data || !ctx->state_scratch.data) {
+        free(ctx->state_snap.data);
+        free(ctx->state_scratch.data);
+        free(ctx);
+        return -1;
+    }
+    ctx->state_snap.cap = ctx->state_scratch.cap = HOST_STATE_PREALLOC;
+    ctx->host = s_host;
+    ctx->host.host_data = inst;
+    inst->host = ctx;
+    return 0;
+}
+
+static void instance_host_free(clap_instance_t *inst) {
+    if (inst->host) {
+        free(inst->host->state_snap.data);
+        free(inst->host->state_scratch.data);
+    }
+    free(inst->host);
+    inst->host = NULL;
+}
+
 /* Helper: check if string ends with suffix */
 static int ends_with(const char *str, const char *suffix) {
     size_t str_len = strlen(str);
@@ -219,20 +1280,20 @@ static int list_add(clap_host_list_t *list, const clap_plugin_info_t *info) {
 static int scan_clap_file(const char *path, clap_host_list_t *list) {
     void *handle = dlopen(path, RTLD_LOCAL | RTLD_LAZY);
     if (!handle) {
-        fprintf(stderr, "[CLAP] dlopen failed for %s: %s\n", path, dlerror());
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "dlopen failed for %s: %s", path, dlerror());
         return -1;
     }
 
     const clap_plugin_entry_t *entry = (const clap_plugin_entry_t *)dlsym(handle, "clap_entry");
     if (!entry) {
-        fprintf(stderr, "[CLAP] No clap_entry in %s\n", path);
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "No clap_entry in %s", path);
         dlclose(handle);
         return -1;
     }
 
     /* Initialize entry */
     if (!entry->init(path)) {
-        fprintf(stderr, "[CLAP] entry->init failed for %s\n", path);
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "entry->init failed for %s", path);
         dlclose(handle);
         return -1;
     }
@@ -241,7 +1302,7 @@ static int scan_clap_file(const char *path, clap_host_list_t *list) {
     const clap_plugin_factory_t *factory =
         (const clap_plugin_factory_t *)entry->get_factory(CLAP_PLUGIN_FACTORY_ID);
     if (!factory) {
-        fprintf(stderr, "[CLAP] No plugin factory in %s\n", path);
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "No plugin factory in %s", path);
         entry->deinit();
         dlclose(handle);
         return -1;
@@ -292,10 +1353,7 @@ static int scan_clap_file(const char *path, clap_host_list_t *list) {
 
 int clap_scan_plugins(const char *dir, clap_host_list_t *out) {
     /* Record main thread for thread check extension */
-    if (!s_main_thread_set) {
-        s_main_thread = pthread_self();
-        s_main_thread_set = 1;
-    }
+    host_record_main_thread();
 
     /* Add plugins directory to LD_LIBRARY_PATH so plugins can find bundled libs */
     const char *current_path = getenv("LD_LIBRARY_PATH");
@@ -309,7 +1367,7 @@ int clap_scan_plugins(const char *dir, clap_host_list_t *out) {
 
     DIR *d = opendir(dir);
     if (!d) {
-        fprintf(stderr, "[CLAP] Cannot open directory: %s\n", dir);
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "Cannot open directory: %s", dir);
         return -1;
     }
 
@@ -335,100 +1393,701 @@ void clap_free_plugin_list(clap_host_list_t *list) {
     list->capacity = 0;
 }
 
+/* MIDI translation dialects, see k_midi_xlate */
+#define MIDI_DIALECT_RAW       0   /* Everything as CLAP_EVENT_MIDI */
+#define MIDI_DIALECT_CLAP_MIDI 1   /* Notes as CLAP notes/expressions, controllers as raw MIDI */
+#define MIDI_DIALECT_CLAP      2   /* CLAP events only - controllers become note expressions */
+#define MIDI_DIALECT_COUNT     3
+
+/* Pick the translation dialect from what the plugin's note input port supports */
+static int query_midi_dialect(const clap_plugin_t *plugin) {
+    const clap_plugin_note_ports_t *note_ports =
+        (const clap_plugin_note_ports_t *)plugin->get_extension(plugin, CLAP_EXT_NOTE_PORTS);
+    clap_note_port_info_t info;
+    if (!note_ports || note_ports->count(plugin, true) == 0 || !note_ports->get(plugin, 0, true, &info)) {
+        return MIDI_DIALECT_RAW;
+    }
+
+    bool clap = (info.supported_dialects & CLAP_NOTE_DIALECT_CLAP) != 0;
+    bool midi = (info.supported_dialects & CLAP_NOTE_DIALECT_MIDI) != 0;
+    if (clap && midi) {
+        return info.preferred_dialect == CLAP_NOTE_DIALECT_MIDI ? MIDI_DIALECT_RAW : MIDI_DIALECT_CLAP_MIDI;
+    }
+    return clap ? MIDI_DIALECT_CLAP : MIDI_DIALECT_RAW;
+}
+
+/* Helper: query latency in frames, 0 if the plugin has no latency extension */
+static uint32_t query_latency(const clap_plugin_t *plugin) {
+    const clap_plugin_latency_t *latency =
+        (const clap_plugin_latency_t *)plugin->get_extension(plugin, CLAP_EXT_LATENCY);
+    if (!latency) return 0;
+    return latency->get(plugin);
+}
+
+/* Helper: query tail length in frames, 0 if the plugin has no tail extension */
+static uint32_t query_tail(const clap_plugin_t *plugin) {
+    const clap_plugin_tail_t *tail =
+        (const clap_plugin_tail_t *)plugin->get_extension(plugin, CLAP_EXT_TAIL);
+    if (!tail) return 0;
+    return tail->get(plugin);
+}
+
+/* Audio port layout and planar buffers of one instance */
+typedef struct clap_audio_io {
+    uint32_t in_count;
+    uint32_t out_count;
+    clap_audio_buffer_t *in;         /* One buffer per input port */
+    clap_audio_buffer_t *out;        /* One buffer per output port */
+    bool *in_active;                 /* Port activation state */
+    bool *out_active;
+    int main_in;                     /* Main input port, -1 if none */
+    int main_out;                    /* Main output port, -1 if none */
+    int sidechain_in;                /* First non-main input port, -1 if none */
+    const clap_plugin_audio_ports_activation_t *activation;
+    bool can_toggle;                 /* Ports can be (de)activated while processing */
+    bool use64;                      /* Ports take data64 buffers (plugin prefers double) */
+    uint32_t total_channels;
+    void **chan;                     /* Channel pointer table, carved up per port */
+    void *storage;                   /* Planar samples, frames_cap per channel */
+    int frames_cap;
+} clap_audio_io_t;
+
+static void io_free(clap_audio_io_t *io) {
+    if (!io) return;
+    free(io->in);
+    free(io->out);
+    free(io->in_active);
+    free(io->out_active);
+    free(io->chan);
+    free(io->storage);
+    free(io);
+}
+
+/* Helper: point a port at its slice of the channel table */
+static void io_bind_port(clap_audio_io_t *io, clap_audio_buffer_t *buf, void **chan) {
+    if (io->use64) {
+        buf->data32 = NULL;
+        buf->data64 = (double **)chan;
+    } else {
+        buf->data32 = (float **)chan;
+        buf->data64 = NULL;
+    }
+}
+
+/* Allocate planar storage for max_frames per channel, 16-byte aligned for SIMD */
+static int io_alloc(clap_instance_t *inst, int max_frames) {
+    clap_audio_io_t *io = inst->io;
+    size_t sample_size = io->use64 ? sizeof(double) : sizeof(float);
+    int cap = (max_frames + 3) & ~3;
+    size_t bytes = (size_t)cap * (io->total_channels + 1) * sample_size;
+    void *storage = NULL;
+    if (posix_memalign(&storage, 16, bytes) != 0) {
+        return -1;
+    }
+    memset(storage, 0, bytes);
+    io->storage = storage;
+    io->frames_cap = cap;
+
+    /* Carve channels out of storage - in-place main input aliases the main output */
+    void **chan = io->chan;
+    char *p = (char *)storage;
+    size_t stride = (size_t)cap * sample_size;
+    for (uint32_t i = 0; i < io->out_count; i++) {
+        io_bind_port(io, &io->out[i], chan);
+        for (uint32_t c = 0; c < io->out[i].channel_count; c++, p += stride) *chan++ = p;
+    }
+    for (uint32_t i = 0; i < io->in_count; i++) {
+        if (inst->in_place && (int)i == io->main_in) {
+            io->in[i].data32 = io->out[io->main_out].data32;
+            io->in[i].data64 = io->out[io->main_out].data64;
+            continue;
+        }
+        io_bind_port(io, &io->in[i], chan);
+        for (uint32_t c = 0; c < io->in[i].channel_count; c++, p += stride) *chan++ = p;
+    }
+    return 0;
+}
+
+/* Read the declared audio ports and size the buffers from them (main thread, inactive plugin) */
+static int io_create(clap_instance_t *inst, const clap_plugin_t *plugin, int max_frames) {
+    clap_audio_io_t *io = (clap_audio_io_t *)calloc(1, sizeof(clap_audio_io_t));
+    if (!io) return -1;
+    io->main_in = io->main_out = io->sidechain_in = -1;
+
+    const clap_plugin_audio_ports_t *ports =
+        (const clap_plugin_audio_ports_t *)plugin->get_extension(plugin, CLAP_EXT_AUDIO_PORTS);
+    if (ports) {
+        io->in_count = ports->count(plugin, true);
+        io->out_count = ports->count(plugin, false);
+    }
+
+    io->in = (clap_audio_buffer_t *)calloc(io->in_count + 1, sizeof(clap_audio_buffer_t));
+    io->out = (clap_audio_buffer_t *)calloc(io->out_count + 1, sizeof(clap_audio_buffer_t));
+    io->in_active = (bool *)calloc(io->in_count + 1, sizeof(bool));
+    io->out_active = (bool *)calloc(io->out_count + 1, sizeof(bool));
+    if (!io->in || !io->out || !io->in_active || !io->out_active) {
+        io_free(io);
+        return -1;
+    }
+
+    clap_id main_in_id = CLAP_INVALID_ID, main_in_pair = CLAP_INVALID_ID;
+    clap_id main_out_id = CLAP_INVALID_ID, main_out_pair = CLAP_INVALID_ID;
+    bool all_support64 = io->in_count + io->out_count > 0;
+    bool any_prefer64 = false;
+    for (uint32_t i = 0; i < io->in_count; i++) {
+        clap_audio_port_info_t info;
+        if (!ports->get(plugin, i, true, &info)) continue;
+        all_support64 = all_support64 && (info.flags & CLAP_AUDIO_PORT_SUPPORTS_64BITS);
+        any_prefer64 = any_prefer64 || (info.flags & CLAP_AUDIO_PORT_PREFERS_64BITS);
+        io->in[i].channel_count = info.channel_count;
+        io->in_active[i] = true;
+        if ((info.flags & CLAP_AUDIO_PORT_IS_MAIN) && io->main_in < 0) {
+            io->main_in = (int)i;
+            main_in_id = info.id;
+            main_in_pair = info.in_place_pair;
+        }
+    }
+    for (uint32_t i = 0; i < io->out_count; i++) {
+        clap_audio_port_info_t info;
+        if (!ports->get(plugin, i, false, &info)) continue;
+        all_support64 = all_support64 && (info.flags & CLAP_AUDIO_PORT_SUPPORTS_64BITS);
+        any_prefer64 = any_prefer64 || (info.flags & CLAP_AUDIO_PORT_PREFERS_64BITS);
+        io->out[i].channel_count = info.channel_count;
+        io->out_active[i] = true;
+        if ((info.flags & CLAP_AUDIO_PORT_IS_MAIN) && io->main_out < 0) {
+            io->main_out = (int)i;
+            main_out_id = info.id;
+            main_out_pair = info.in_place_pair;
+        }
+    }
+
+    /* Double precision only when every port can take it and the plugin asks for it */
+    io->use64 = all_support64 && any_prefer64;
+
+    /* Plugins that don't flag a main port get their first port used as main */
+    if (io->main_in < 0 && io->in_count > 0) io->main_in = 0;
+    if (io->main_out < 0 && io->out_count > 0) io->main_out = 0;
+    for (uint32_t i = 0; i < io->in_count; i++) {
+        if ((int)i != io->main_in) {
+            io->sidechain_in = (int)i;
+            break;
+        }
+    }
+
+    /* In-place when the main input is paired with the main output and they have the same width */
+    bool in_place = io->main_in >= 0 && io->main_out >= 0 &&
+                    main_in_id != CLAP_INVALID_ID && main_out_id != CLAP_INVALID_ID &&
+                    io->in[io->main_in].channel_count == io->out[io->main_out].channel_count &&
+                    (main_in_pair == main_out_id || main_out_pair == main_in_id);
+
+    for (uint32_t i = 0; i < io->in_count; i++) {
+        if (in_place && (int)i == io->main_in) continue;
+        io->total_channels += io->in[i].channel_count;
+    }
+    for (uint32_t i = 0; i < io->out_count; i++) {
+        io->total_channels += io->out[i].channel_count;
+    }
+    io->chan = (void **)calloc(io->total_channels + 1, sizeof(void *));
+    if (!io->chan) {
+        io_free(io);
+        return -1;
+    }
+
+    /* Switch off inputs we never feed - sidechain starts off until something is routed to it */
+    io->activation = (const clap_plugin_audio_ports_activation_t *)
+        plugin->get_extension(plugin, CLAP_EXT_AUDIO_PORTS_ACTIVATION);
+    if (!io->activation) {
+        io->activation = (const clap_plugin_audio_ports_activation_t *)
+            plugin->get_extension(plugin, CLAP_EXT_AUDIO_PORTS_ACTIVATION_COMPAT);
+    }
+    if (io->activation) {
+        io->can_toggle = io->activation->can_activate_while_processing(plugin);
+        for (uint32_t i = 0; i < io->in_count; i++) {
+            if ((int)i == io->main_in) continue;
+            if ((int)i == io->sidechain_in && !io->can_toggle) continue;
+            if (io->activation->set_active(plugin, true, i, false, io->use64 ? 64 : 32)) {
+                io->in_active[i] = false;
+            }
+        }
+    }
+
+    inst->io = io;
+    inst->audio_in_ports = io->in_count;
+    inst->audio_out_ports = io->out_count;
+    inst->in_place = in_place;
+    inst->use64 = io->use64;
+    if (io_alloc(inst, max_frames) != 0) {
+        io_free(io);
+        inst->io = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/* Bring port activation in line with the current routing (audio thread) */
+static void io_apply_activation(clap_instance_t *inst) {
+    clap_audio_io_t *io = inst->io;
+    if (!io->activation || !io->can_toggle) return;
+
+    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
+    if (io->sidechain_in >= 0) {
+        bool want = inst->sidechain_src != NULL;
+        if (io->in_active[io->sidechain_in] != want &&
+            io->activation->set_active(plugin, true, io->sidechain_in, want, io->use64 ? 64 : 32)) {
+            io->in_active[io->sidechain_in] = want;
+        }
+    }
+    for (uint32_t i = 0; i < io->out_count; i++) {
+        if ((int)i == io->main_out) continue;
+        if (io->out_active[i] != inst->aux_outputs &&
+            io->activation->set_active(plugin, false, i, inst->aux_outputs, io->use64 ? 64 : 32)) {
+            io->out_active[i] = inst->aux_outputs;
+        }
+    }
+}
+
+static void param_cache_free(clap_param_cache_t *cache) {
+    if (!cache) return;
+    free(cache->ids);
+    free(cache->cookies);
+    free(cache->min);
+    free(cache->max);
+    free(cache->def);
+    free(cache->flags);
+    free(cache->names);
+    free(cache->module_off);
+    free(cache->module_pool);
+    free(cache->values);
+    free(cache->pending);
+    free(cache->dirty);
+    free(cache->dirty_summary);
+    free(cache->events);
+    free(cache->hash);
+    free(cache->text);
+    free(cache->text_value);
+    free(cache->text_valid);
+    free(cache);
+}
+
+static uint32_t param_id_hash(clap_id id) {
+    /* Plugin ids are often sequential or hashed already - a multiplicative mix covers both */
+    return id * 2654435761u;
+}
+
+static void param_cache_insert(clap_param_cache_t *cache, uint32_t index) {
+    uint32_t slot = param_id_hash(cache->ids[index]) & cache->hash_mask;
+    while (cache->hash[slot]) slot = (slot + 1) & cache->hash_mask;
+    cache->hash[slot] = index + 1;
+}
+
+/* Look up a param index by id, -1 if unknown */
+static int param_cache_find(const clap_param_cache_t *cache, clap_id id) {
+    uint32_t slot = param_id_hash(id) & cache->hash_mask;
+    for (uint32_t idx; (idx = cache->hash[slot]) != 0; slot = (slot + 1) & cache->hash_mask) {
+        if (cache->ids[idx - 1] == id) return (int)(idx - 1);
+    }
+    return -1;
+}
+
+/*
+ * Intern a module path - params of one module are usually listed together, so checking
+ * the previous param's path catches most repeats. Returns the offset, 0 for "" or on failure.
+ */
+static uint32_t param_cache_module(clap_param_cache_t *cache, uint32_t index, const char *module) {
+    if (!module[0]) return 0;
+    if (index > 0 && cache->module_off[index - 1] &&
+        strcmp(cache->module_pool + cache->module_off[index - 1], module) == 0) {
+        return cache->module_off[index - 1];
+    }
+    size_t len = strnlen(module, CLAP_PATH_SIZE - 1);
+    if (cache->module_pool_len + len + 1 > cache->module_pool_cap) {
+        size_t cap = cache->module_pool_cap ? cache->module_pool_cap * 2 : 256;
+        while (cap < cache->module_pool_len + len + 1) cap *= 2;
+        char *pool = (char *)realloc(cache->module_pool, cap);
+        if (!pool) return 0;
+        if (!cache->module_pool_len) pool[cache->module_pool_len++] = '\0';  /* Offset 0 is "" */
+        cache->module_pool = pool;
+        cache->module_pool_cap = cap;
+    }
+    uint32_t off = (uint32_t)cache->module_pool_len;
+    memcpy(cache->module_pool + off, module, len);
+    cache->module_pool[off + len] = '\0';
+    cache->module_pool_len += len + 1;
+    return off;
+}
+
+/* Snapshot param info and current values (main thread), gen = rescan generation read beforehand */
+static clap_param_cache_t *param_cache_create(const clap_plugin_t *plugin, int gen) {
+    const clap_plugin_params_t *params =
+        (const clap_plugin_params_t *)plugin->get_extension(plugin, CLAP_EXT_PARAMS);
+    if (!params) return NULL;
+
+    clap_param_cache_t *cache = (clap_param_cache_t *)calloc(1, sizeof(clap_param_cache_t));
+    if (!cache) return NULL;
+    uint32_t count = params->count(plugin);
+    uint32_t hash_size = 8;
+    while (hash_size < count * 2) hash_size <<= 1;
+
+    cache->gen = gen;
+    cache->params = params;
+    cache->ids = (clap_id *)calloc(count + 1, sizeof(clap_id));
+    cache->cookies = (void **)calloc(count + 1, sizeof(void *));
+    cache->min = (double *)calloc(count + 1, sizeof(double));
+    cache->max = (double *)calloc(count + 1, sizeof(double));
+    cache->def = (double *)calloc(count + 1, sizeof(double));
+    cache->flags = (uint32_t *)calloc(count + 1, sizeof(uint32_t));
+    cache->names = (char (*)[CLAP_NAME_SIZE])calloc(count + 1, CLAP_NAME_SIZE);
+    cache->module_off = (uint32_t *)calloc(count + 1, sizeof(uint32_t));
+    cache->values = (double *)calloc(count + 1, sizeof(double));
+    cache->hash = (uint32_t *)calloc(hash_size, sizeof(uint32_t));
+    cache->hash_mask = hash_size - 1;
+    cache->dirty_words = (count + 63) / 64;
+    cache->pending = (double *)calloc(count + 1, sizeof(double));
+    cache->dirty = (uint64_t *)calloc(cache->dirty_words + 1, sizeof(uint64_t));
+    cache->dirty_summary = (uint64_t *)calloc(cache->dirty_words / 64 + 1, sizeof(uint64_t));
+    cache->events = (clap_event_param_value_t *)calloc(count + 1, sizeof(clap_event_param_value_t));
+    if (!cache->ids || !cache->cookies || !cache->min || !cache->max || !cache->def ||
+        !cache->flags || !cache->names || !cache->module_off || !cache->values || !cache->hash ||
+        !cache->pending || !cache->dirty || !cache->dirty_summary || !cache->events) {
+        param_cache_free(cache);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        clap_param_info_t info;
+        if (!params->get_info(plugin, i, &info)) {
+            /* Keep indexes stable - an unreadable param stays in the table, unreachable by id */
+            cache->ids[i] = CLAP_INVALID_ID;
+            continue;
+        }
+        cache->ids[i] = info.id;
+        cache->cookies[i] = info.cookie;
+        cache->min[i] = info.min_value;
+        cache->max[i] = info.max_value;
+        cache->def[i] = info.default_value;
+        cache->flags[i] = info.flags;
+        memcpy(cache->names[i], info.name, CLAP_NAME_SIZE);
+        cache->names[i][CLAP_NAME_SIZE - 1] = '\0';
+        info.module[CLAP_PATH_SIZE - 1] = '\0';
+        cache->module_off[i] = param_cache_module(cache, i, info.module);
+        if (!params->get_value(plugin, info.id, &cache->values[i])) {
+            cache->values[i] = info.default_value;
+        }
+        param_cache_insert(cache, i);
+    }
+    cache->count = count;
+    return cache;
+}
+
+/* Queue a value for the next block, replacing any not yet delivered (UI thread) */
+static void param_queue_push(clap_param_cache_t *cache, uint32_t index, double value) {
+    __atomic_store(&cache->pending[index], &value, __ATOMIC_RELAXED);
+    __atomic_fetch_or(&cache->dirty[index >> 6], 1ULL << (index & 63), __ATOMIC_RELEASE);
+    __atomic_fetch_or(&cache->dirty_summary[index >> 12], 1ULL << ((index >> 6) & 63), __ATOMIC_RELEASE);
+}
+
+static bool suspend_processing(clap_instance_t *inst);
+static void resume_processing(clap_instance_t *inst);
+static void dry_free(struct clap_dry_delay *dry);
+static void preset_index_free(clap_instance_t *inst);
+
+/* Helper: rebuild the param table if the plugin asked for a rescan, returns the table */
+static clap_param_cache_t *param_cache_sync(clap_instance_t *inst) {
+    clap_param_cache_t *cache = inst->param_cache;
+    int gen = __atomic_load_n(&inst->host->params_gen, __ATOMIC_ACQUIRE);
+    if (!cache || cache->gen == gen) return cache;
+
+    /* Main-thread calls into the plugin - not concurrently with the main loop's */
+    pthread_mutex_lock(&s_loop_mutex);
+    clap_param_cache_t *fresh = param_cache_create((const clap_plugin_t *)inst->plugin, gen);
+    pthread_mutex_unlock(&s_loop_mutex);
+    if (!fresh) return cache;
+
+    /* The audio thread publishes into the table - swap it while process() is out,
+       or keep the old one and retry on the next call if process() is stuck */
+    if (!suspend_processing(inst)) {
+        param_cache_free(fresh);
+        return cache;
+    }
+    for (uint32_t i = 0; i < cache->count; i++) {
+        /* Carry over changes the audio thread hasn't picked up yet */
+        if (!(cache->dirty[i >> 6] & (1ULL << (i & 63)))) continue;
+        int index = param_cache_find(fresh, cache->ids[i]);
+        if (index >= 0) param_queue_push(fresh, (uint32_t)index, cache->pending[i]);
+    }
+    fresh->values_gen = cache->values_gen;  /* Keeps clap_param_generation moving forward */
+    __atomic_store_n(&inst->param_cache, fresh, __ATOMIC_RELEASE);
+    resume_processing(inst);
+    param_cache_free(cache);
+    return fresh;
+}
+
+/*
+ * Remote-control pages - the plugin's own grouping of params onto 8 knobs, read once and
+ * again only after remote_controls->changed. Plugins without pages get pages of 8 params
+ * in index order.
+ */
+typedef struct {
+    char name[CLAP_NAME_SIZE];
+    clap_id param_ids[CLAP_REMOTE_CONTROLS_COUNT];   /* CLAP_INVALID_ID = unassigned knob */
+} remote_page_t;
+
+typedef struct clap_remote_pages {
+    int gen;                         /* remote_gen the table was read at */
+    uint32_t count;
+    remote_page_t *pages;
+} clap_remote_pages_t;
+
+static const clap_plugin_remote_controls_t *remote_ext(const clap_plugin_t *plugin) {
+    const clap_plugin_remote_controls_t *ext =
+        (const clap_plugin_remote_controls_t *)plugin->get_extension(plugin, CLAP_EXT_REMOTE_CONTROLS);
+    if (!ext) {
+        ext = (const clap_plugin_remote_controls_t *)plugin->get_extension(plugin, CLAP_EXT_REMOTE_CONTROLS_COMPAT);
+    }
+    return ext;
+}
+
+static void remote_pages_free(clap_remote_pages_t *remote) {
+    if (!remote) return;
+    free(remote->pages);
+    free(remote);
+}
+
+/* Read the plugin's pages (main thread), NULL if it has none */
+static clap_remote_pages_t *remote_pages_create(const clap_plugin_t *plugin, int gen) {
+    const clap_plugin_remote_controls_t *ext = remote_ext(plugin);
+    uint32_t count = ext ? ext->count(plugin) : 0;
+    if (count == 0) return NULL;
+
+    clap_remote_pages_t *remote = (clap_remote_pages_t *)calloc(1, sizeof(clap_remote_pages_t));
+    if (!remote) return NULL;
+    remote->pages = (remote_page_t *)calloc(count, sizeof(remote_page_t));
+    if (!remote->pages) {
+        free(remote);
+        return NULL;
+    }
+    remote->gen = gen;
+
+    clap_remote_controls_page_t page;
+    for (uint32_t i = 0; i < count; i++) {
+        memset(&page, 0, sizeof(page));
+        if (!ext->get(plugin, i, &page)) continue;
+        remote_page_t *dst = &remote->pages[remote->count++];
+        memcpy(dst->name, page.page_name, CLAP_NAME_SIZE);
+        dst->name[CLAP_NAME_SIZE - 1] = '\0';
+        memcpy(dst->param_ids, page.param_ids, sizeof(dst->param_ids));
+    }
+    return remote;
+}
+
+/* Helper: re-read the pages if the plugin reported a change, returns the table */
+static clap_remote_pages_t *remote_pages_sync(clap_instance_t *inst) {
+    int gen = __atomic_load_n(&inst->host->remote_gen, __ATOMIC_ACQUIRE);
+    if (inst->remote && inst->remote->gen == gen) return inst->remote;
+    if (!inst->remote && inst->remote_gen == gen) return NULL;
+
+    pthread_mutex_lock(&s_loop_mutex);
+    clap_remote_pages_t *fresh = remote_pages_create((const clap_plugin_t *)inst->plugin, gen);
+    pthread_mutex_unlock(&s_loop_mutex);
+    remote_pages_free(inst->remote);
+    inst->remote = fresh;
+    inst->remote_gen = gen;
+    return fresh;
+}
+
+int clap_remote_page_count(clap_instance_t *inst) {
+    if (!inst || !inst->plugin) return 0;
+    clap_remote_pages_t *remote = remote_pages_sync(inst);
+    if (remote) return (int)remote->count;
+    int params = clap_param_count(inst);
+    return (params + CLAP_REMOTE_CONTROLS_COUNT - 1) / CLAP_REMOTE_CONTROLS_COUNT;
+}
+
+int clap_remote_page_name(clap_instance_t *inst, int page, char *buf, int buf_len) {
+    if (!buf || buf_len <= 0 || page < 0 || page >= clap_remote_page_count(inst)) return -1;
+    if (inst->remote) return snprintf(buf, buf_len, "%s", inst->remote->pages[page].name);
+    int first = page * CLAP_REMOTE_CONTROLS_COUNT;
+    int last = first + CLAP_REMOTE_CONTROLS_COUNT;
+    int params = clap_param_count(inst);
+    return snprintf(buf, buf_len, "Params %d-%d", first + 1, last < params ? last : params);
+}
+
+int clap_remote_param(clap_instance_t *inst, int page, int knob) {
+    if (!inst || !inst->plugin || page < 0 || knob < 0 || knob >= CLAP_REMOTE_CONTROLS_COUNT) return -1;
+    clap_remote_pages_t *remote = remote_pages_sync(inst);
+    clap_param_cache_t *cache = param_cache_sync(inst);
+    if (!cache) return -1;
+    if (!remote) {
+        int index = page * CLAP_REMOTE_CONTROLS_COUNT + knob;
+        return index < (int)cache->count ? index : -1;
+    }
+    if ((uint32_t)page >= remote->count) return -1;
+    clap_id id = remote->pages[page].param_ids[knob];
+    return id == CLAP_INVALID_ID ? -1 : param_cache_find(cache, id);
+}
+
+/*
+ * Bring a created, initialized plugin up: audio ports, activation, event queues and
+ * the param table. On failure everything set up here is undone, the plugin is not destroyed.
+ */
+static int instance_start(const clap_plugin_t *plugin, clap_instance_t *out) {
+    /* Read audio port layout - port activation has to happen before activate */
+    out->sample_rate = s_sample_rate;
+    out->max_frames = s_max_frames;
+    out->aux_outputs = true;
+    if (io_create(out, plugin, out->max_frames) != 0) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "audio port setup failed");
+        return -1;
+    }
+
+    /* Activate the plugin */
+    HOST_LOG(CLAP_HOST_LOG_DEBUG, "calling plugin->activate...");
+    if (!plugin->activate(plugin, out->sample_rate, HOST_MIN_FRAMES, (uint32_t)out->max_frames)) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "plugin->activate failed");
+        io_free(out->io);
+        out->io = NULL;
+        return -1;
+    }
+    HOST_LOG(CLAP_HOST_LOG_DEBUG, "plugin->activate OK");
+
+    /* Start processing */
+    HOST_LOG(CLAP_HOST_LOG_DEBUG, "calling plugin->start_processing...");
+    if (!plugin->start_processing(plugin)) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "plugin->start_processing failed");
+        plugin->deactivate(plugin);
+        io_free(out->io);
+        out->io = NULL;
+        return -1;
+    }
+    HOST_LOG(CLAP_HOST_LOG_DEBUG, "plugin->start_processing OK");
+
+    /* Per-instance event queues - needed to process anywhere but the main thread */
+    out->events = (clap_events_t *)calloc(1, sizeof(clap_events_t));
+    if (!out->events) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "event queue allocation failed");
+        plugin->stop_processing(plugin);
+        plugin->deactivate(plugin);
+        io_free(out->io);
+        out->io = NULL;
+        return -1;
+    }
+
+    out->midi_dialect = query_midi_dialect(plugin);
+
+    /* Workers only run while a plugin that can use them is loaded */
+    thread_pool_sync(out);
+
+    /* Query tail length - used to put the plugin to sleep on silence */
+    out->tail_gen = __atomic_load_n(&out->host->tail_gen, __ATOMIC_ACQUIRE);
+    out->tail_frames = query_tail(plugin);
+    out->latency_gen = __atomic_load_n(&out->host->latency_gen, __ATOMIC_ACQUIRE);
+    out->latency = query_latency(plugin);
+    out->mix = 1.0f;
+
+    /* Param table - NULL for plugins without params */
+    out->param_cache = param_cache_create(plugin, __atomic_load_n(&out->host->params_gen, __ATOMIC_ACQUIRE));
+
+    /* Knob pages - NULL for plugins without remote controls */
+    out->remote_gen = __atomic_load_n(&out->host->remote_gen, __ATOMIC_ACQUIRE);
+    out->remote = remote_pages_create(plugin, out->remote_gen);
+
+    out->plugin = plugin;
+    out->activated = true;
+    out->processing = true;
+    return 0;
+}
+
 int clap_load_plugin(const char *path, int plugin_index, clap_instance_t *out) {
     memset(out, 0, sizeof(*out));
-    fprintf(stderr, "[CLAP] Loading: %s index %d\n", path, plugin_index);
+    host_record_main_thread();
+    HOST_LOG(CLAP_HOST_LOG_INFO, "Loading: %s index %d", path, plugin_index);
 
     void *handle = dlopen(path, RTLD_LOCAL | RTLD_NOW);
     if (!handle) {
-        fprintf(stderr, "[CLAP] dlopen failed: %s\n", dlerror());
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "dlopen failed: %s", dlerror());
         return -1;
     }
-    fprintf(stderr, "[CLAP] dlopen OK\n");
+    HOST_LOG(CLAP_HOST_LOG_DEBUG, "dlopen OK");
 
     const clap_plugin_entry_t *entry = (const clap_plugin_entry_t *)dlsym(handle, "clap_entry");
     if (!entry) {
-        fprintf(stderr, "[CLAP] No clap_entry symbol\n");
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "No clap_entry symbol");
         dlclose(handle);
         return -1;
     }
-    fprintf(stderr, "[CLAP] entry OK\n");
+    HOST_LOG(CLAP_HOST_LOG_DEBUG, "entry OK");
 
     if (!entry->init(path)) {
-        fprintf(stderr, "[CLAP] entry->init failed\n");
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "entry->init failed");
         dlclose(handle);
         return -1;
     }
-    fprintf(stderr, "[CLAP] entry->init OK\n");
+    HOST_LOG(CLAP_HOST_LOG_DEBUG, "entry->init OK");
 
     const clap_plugin_factory_t *factory =
         (const clap_plugin_factory_t *)entry->get_factory(CLAP_PLUGIN_FACTORY_ID);
     if (!factory) {
-        fprintf(stderr, "[CLAP] No plugin factory\n");
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "No plugin factory");
         entry->deinit();
         dlclose(handle);
         return -1;
     }
-    fprintf(stderr, "[CLAP] factory OK\n");
+    HOST_LOG(CLAP_HOST_LOG_DEBUG, "factory OK");
 
     const clap_plugin_descriptor_t *desc = factory->get_plugin_descriptor(factory, plugin_index);
     if (!desc) {
-        fprintf(stderr, "[CLAP] Invalid plugin index\n");
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "Invalid plugin index");
         entry->deinit();
         dlclose(handle);
         return -1;
     }
-    fprintf(stderr, "[CLAP] descriptor OK: %s\n", desc->name ? desc->name : "(null)");
+    HOST_LOG(CLAP_HOST_LOG_DEBUG, "descriptor OK: %s", desc->name ? desc->name : "(null)");
 
-    const clap_plugin_t *plugin = factory->create_plugin(factory, &s_host, desc->id);
-    if (!plugin) {
-        fprintf(stderr, "[CLAP] create_plugin failed\n");
+    /* The plugin gets its own host - callbacks find the instance through host_data */
+    if (instance_host_create(out) != 0) {
         entry->deinit();
         dlclose(handle);
         return -1;
     }
-    fprintf(stderr, "[CLAP] create_plugin OK\n");
-
-    fprintf(stderr, "[CLAP] calling plugin->init...\n");
-    if (!plugin->init(plugin)) {
-        fprintf(stderr, "[CLAP] plugin->init failed\n");
-        plugin->destroy(plugin);
+    loop_acquire();
+    const clap_plugin_t *plugin = factory->create_plugin(factory, &out->host->host, desc->id);
+    if (!plugin) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "create_plugin failed");
+        loop_release(out);
+        instance_host_free(out);
         entry->deinit();
         dlclose(handle);
         return -1;
     }
-    fprintf(stderr, "[CLAP] plugin->init OK\n");
+    HOST_LOG(CLAP_HOST_LOG_DEBUG, "create_plugin OK");
 
-    /* Activate the plugin */
-    fprintf(stderr, "[CLAP] calling plugin->activate...\n");
-    if (!plugin->activate(plugin, HOST_SAMPLE_RATE, HOST_MIN_FRAMES, HOST_MAX_FRAMES)) {
-        fprintf(stderr, "[CLAP] plugin->activate failed\n");
+    HOST_LOG(CLAP_HOST_LOG_DEBUG, "calling plugin->init...");
+    if (!plugin->init(plugin)) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "plugin->init failed");
         plugin->destroy(plugin);
+        loop_release(out);
+        instance_host_free(out);
         entry->deinit();
         dlclose(handle);
         return -1;
     }
-    fprintf(stderr, "[CLAP] plugin->activate OK\n");
+    HOST_LOG(CLAP_HOST_LOG_DEBUG, "plugin->init OK");
 
-    /* Start processing */
-    fprintf(stderr, "[CLAP] calling plugin->start_processing...\n");
-    if (!plugin->start_processing(plugin)) {
-        fprintf(stderr, "[CLAP] plugin->start_processing failed\n");
-        plugin->deactivate(plugin);
+    if (instance_start(plugin, out) != 0) {
         plugin->destroy(plugin);
+        loop_release(out);
+        instance_host_free(out);
         entry->deinit();
         dlclose(handle);
         return -1;
     }
-    fprintf(stderr, "[CLAP] plugin->start_processing OK\n");
 
     out->handle = handle;
     out->entry = entry;
     out->factory = factory;
-    out->plugin = plugin;
-    out->activated = true;
-    out->processing = true;
     strncpy(out->path, path, sizeof(out->path) - 1);
+    out->plugin_index = plugin_index;
+    loop_add_inst(out);
 
     return 0;
 }
@@ -439,15 +2098,29 @@ void clap_unload_plugin(clap_instance_t *inst) {
     const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
     const clap_plugin_entry_t *entry = (const clap_plugin_entry_t *)inst->entry;
 
+    /* Sandboxed instances have no loop sources - their child runs its own loop */
+    bool in_loop = inst->handle != NULL;
+    if (in_loop) loop_remove_inst(inst);
+
     if (inst->processing) {
-        plugin->stop_processing(plugin);
+        if (!inst->sleeping) plugin->stop_processing(plugin);
         inst->processing = false;
     }
     if (inst->activated) {
         plugin->deactivate(plugin);
         inst->activated = false;
     }
+    preset_index_free(inst);
     plugin->destroy(plugin);
+    if (in_loop) loop_release(inst);
+    instance_host_free(inst);
+    io_free(inst->io);
+    param_cache_free(inst->param_cache);
+    remote_pages_free(inst->remote);
+    free(inst->events);
+    if (inst->thread_pool) pool_release();
+    if (inst->batch) pool_release();
+    dry_free(inst->dry);
 
     if (entry) entry->deinit();
     if (inst->handle) dlclose(inst->handle);
@@ -455,314 +2128,3171 @@ void clap_unload_plugin(clap_instance_t *inst) {
     memset(inst, 0, sizeof(*inst));
 }
 
-/* Static buffers for CLAP process (avoid per-call allocation) */
-static float *s_in_bufs[2] = {NULL, NULL};
-static float *s_out_bufs[2] = {NULL, NULL};
-static int s_buf_frames = 0;
-
-/* CLAP event storage for current process block */
-static clap_event_note_t s_note_events[MAX_MIDI_EVENTS];
-static int s_note_event_count = 0;
-
-/* Param event storage for current process block */
-#define MAX_PARAM_EVENTS 32
-static clap_event_param_value_t s_param_events[MAX_PARAM_EVENTS];
-static int s_param_event_count = 0;
-
-/* Event list callbacks - returns combined note + param events */
+/* Event list callbacks - returns the instance's combined MIDI + param events */
 static uint32_t s_events_size(const clap_input_events_t *list) {
-    return (uint32_t)(s_note_event_count + s_param_event_count);
+    const clap_events_t *ev = (const clap_events_t *)list->ctx;
+    return (uint32_t)(ev->in_event_count + ev->param_event_count);
 }
 
 static const clap_event_header_t *s_events_get(const clap_input_events_t *list, uint32_t index) {
-    /* Note events first */
-    if (index < (uint32_t)s_note_event_count) {
-        return &s_note_events[index].header;
+    const clap_events_t *ev = (const clap_events_t *)list->ctx;
+    /* MIDI-derived events first */
+    if (index < (uint32_t)ev->in_event_count) {
+        return &ev->in_events[index].header;
     }
     /* Then param events */
-    index -= s_note_event_count;
-    if (index < (uint32_t)s_param_event_count) {
-        return &s_param_events[index].header;
+    index -= ev->in_event_count;
+    if (index < (uint32_t)ev->param_event_count) {
+        return &ev->param_events[index].header;
     }
     return NULL;
 }
 
-static bool s_empty_push(const clap_output_events_t *list, const clap_event_header_t *event) { return true; }
-
-/* Convert MIDI queue to CLAP note events */
-static void prepare_midi_events(void) {
-    pthread_mutex_lock(&s_midi_mutex);
-
-    s_note_event_count = 0;
-    for (int i = 0; i < s_midi_queue_count && s_note_event_count < MAX_MIDI_EVENTS; i++) {
-        midi_event_t *m = &s_midi_queue[i];
-        if (m->len < 3) continue;
-
-        uint8_t status = m->data[0] & 0xF0;
-        uint8_t channel = m->data[0] & 0x0F;
-        uint8_t note = m->data[1];
-        uint8_t velocity = m->data[2];
-
-        clap_event_note_t *evt = &s_note_events[s_note_event_count];
-
-        if (status == 0x90 && velocity > 0) {
-            /* Note on */
-            evt->header.size = sizeof(clap_event_note_t);
-            evt->header.time = 0;
-            evt->header.space_id = CLAP_CORE_EVENT_SPACE_ID;
-            evt->header.type = CLAP_EVENT_NOTE_ON;
-            evt->header.flags = 0;
-            evt->note_id = -1;
-            evt->port_index = 0;
-            evt->channel = channel;
-            evt->key = note;
-            evt->velocity = velocity / 127.0;
-            s_note_event_count++;
-        } else if (status == 0x80 || (status == 0x90 && velocity == 0)) {
-            /* Note off */
-            evt->header.size = sizeof(clap_event_note_t);
-            evt->header.time = 0;
-            evt->header.space_id = CLAP_CORE_EVENT_SPACE_ID;
-            evt->header.type = CLAP_EVENT_NOTE_OFF;
-            evt->header.flags = 0;
-            evt->note_id = -1;
-            evt->port_index = 0;
-            evt->channel = channel;
-            evt->key = note;
-            evt->velocity = velocity / 127.0;
-            s_note_event_count++;
-        }
-    }
-
-    s_midi_queue_count = 0;
-    pthread_mutex_unlock(&s_midi_mutex);
-}
-
-/* Convert instance param queue to CLAP param events */
-static void prepare_param_events(clap_instance_t *inst) {
-    s_param_event_count = 0;
-
-    for (int i = 0; i < inst->param_queue_count && s_param_event_count < MAX_PARAM_EVENTS; i++) {
-        clap_event_param_value_t *evt = &s_param_events[s_param_event_count];
-        evt->header.size = sizeof(clap_event_param_value_t);
-        evt->header.time = 0;
-        evt->header.space_id = CLAP_CORE_EVENT_SPACE_ID;
-        evt->header.type = CLAP_EVENT_PARAM_VALUE;
-        evt->header.flags = 0;
-        evt->param_id = inst->param_queue[i].param_id;
-        evt->cookie = NULL;
-        evt->note_id = -1;
-        evt->port_index = -1;
-        evt->channel = -1;
-        evt->key = -1;
-        evt->value = inst->param_queue[i].value;
-        s_param_event_count++;
+/* Helper: mark a channel/key voice playing or finished, -1 matches all */
+static void voice_set(clap_events_t *ev, int channel, int key, bool on) {
+    int c0 = channel < 0 ? 0 : channel, c1 = channel < 0 ? 15 : channel;
+    int k0 = key < 0 ? 0 : key, k1 = key < 0 ? 127 : key;
+    if (c1 > 15 || k1 > 127) return;
+    int voices = ev->voices;
+    for (int c = c0; c <= c1; c++) {
+        for (int k = k0; k <= k1; k++) {
+            int slot = c * 128 + k;
+            uint64_t bit = 1ULL << (slot & 63);
+            bool was_on = (ev->voice_bits[slot >> 6] & bit) != 0;
+            if (on && !was_on) {
+                ev->voice_bits[slot >> 6] |= bit;
+                voices++;
+            } else if (!on && was_on) {
+                ev->voice_bits[slot >> 6] &= ~bit;
+                voices--;
+            }
+        }
     }
-
-    inst->param_queue_count = 0;
+    __atomic_store_n(&ev->voices, voices, __ATOMIC_RELAXED);
 }
 
-static void ensure_buffers(int frames) {
-    if (frames <= s_buf_frames) return;
+/* Helper: a note off ends the voice unless the plugin reports voice ends itself */
+static void voice_note_off(clap_events_t *ev, int channel, int key) {
+    if (!ev->note_ends) voice_set(ev, channel, key, false);
+}
 
-    for (int i = 0; i < 2; i++) {
-        free(s_in_bufs[i]);
-        free(s_out_bufs[i]);
-        s_in_bufs[i] = (float *)calloc(frames, sizeof(float));
-        s_out_bufs[i] = (float *)calloc(frames, sizeof(float));
-    }
-    s_buf_frames = frames;
+static void voices_clear(clap_events_t *ev) {
+    if (!ev) return;
+    memset(ev->voice_bits, 0, sizeof(ev->voice_bits));
+    __atomic_store_n(&ev->voices, 0, __ATOMIC_RELAXED);
 }
 
-int clap_process_block(clap_instance_t *inst, const float *in, float *out, int frames) {
-    if (!inst->plugin || !inst->processing) {
-        return -1;
-    }
+static bool midi_ring_push(clap_events_t *ev, uint8_t status, uint8_t d1, uint8_t d2) {
+    uint32_t head = ev->midi_head;
+    if (head - __atomic_load_n(&ev->midi_tail, __ATOMIC_ACQUIRE) >= HOST_EVENT_RING_SIZE) return false;
+    midi_event_t *evt = &ev->midi[head & (HOST_EVENT_RING_SIZE - 1)];
+    evt->data[0] = status;
+    evt->data[1] = d1;
+    evt->data[2] = d2;
+    evt->len = (status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0 ? 2 : 3;
+    __atomic_store_n(&ev->midi_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
 
-    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
+static int param_cache_find(const clap_param_cache_t *cache, clap_id id);
 
-    /* Check if plugin has audio output - if not, output silence */
-    const clap_plugin_audio_ports_t *audio_ports =
-        (const clap_plugin_audio_ports_t *)plugin->get_extension(plugin, CLAP_EXT_AUDIO_PORTS);
+/* Output event list: route plugin events to the mirror and rings (audio thread, no locks) */
+static bool host_try_push(const clap_output_events_t *list, const clap_event_header_t *event) {
+    clap_instance_t *inst = (clap_instance_t *)list->ctx;
+    clap_events_t *ev = inst ? inst->events : NULL;
+    if (!ev || event->space_id != CLAP_CORE_EVENT_SPACE_ID) return false;
 
-    uint32_t num_outputs = 0;
-    uint32_t num_inputs = 0;
-    if (audio_ports) {
-        num_outputs = audio_ports->count(plugin, false);
-        num_inputs = audio_ports->count(plugin, true);
+    switch (event->type) {
+        case CLAP_EVENT_PARAM_VALUE: {
+            const clap_event_param_value_t *pv = (const clap_event_param_value_t *)event;
+            clap_param_cache_t *cache = __atomic_load_n(&inst->param_cache, __ATOMIC_ACQUIRE);
+            int index = cache ? param_cache_find(cache, pv->param_id) : -1;
+            if (index < 0) return false;
+            double value = pv->value, old;
+            __atomic_load(&cache->values[index], &old, __ATOMIC_RELAXED);
+            if (old == value) return true;  /* Plugins often re-report unchanged values */
+            __atomic_store(&cache->values[index], &value, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&cache->values_gen, 1, __ATOMIC_RELEASE);
+            return true;
+        }
+        case CLAP_EVENT_PARAM_GESTURE_BEGIN:
+        case CLAP_EVENT_PARAM_GESTURE_END:
+            /* Values arrive as PARAM_VALUE events inside the gesture */
+            return true;
+        case CLAP_EVENT_NOTE_END: {
+            const clap_event_note_t *n = (const clap_event_note_t *)event;
+            ev->note_ends = true;
+            voice_set(ev, n->channel, n->key, false);
+            return true;
+        }
+        case CLAP_EVENT_NOTE_ON:
+        case CLAP_EVENT_NOTE_OFF: {
+            /* Notes from arpeggiators/sequencers go out as MIDI */
+            const clap_event_note_t *n = (const clap_event_note_t *)event;
+            if (n->channel < 0 || n->channel > 15 || n->key < 0 || n->key > 127) return false;
+            int vel = (int)(n->velocity * 127.0 + 0.5);
+            vel = vel < 0 ? 0 : (vel > 127 ? 127 : vel);
+            if (event->type == CLAP_EVENT_NOTE_ON) {
+                return midi_ring_push(ev, (uint8_t)(0x90 | n->channel), (uint8_t)n->key, (uint8_t)(vel ? vel : 1));
+            }
+            return midi_ring_push(ev, (uint8_t)(0x80 | n->channel), (uint8_t)n->key, (uint8_t)vel);
+        }
+        case CLAP_EVENT_MIDI: {
+            const clap_event_midi_t *m = (const clap_event_midi_t *)event;
+            if (m->data[0] < 0x80 || m->data[0] >= 0xF0) return false;
+            return midi_ring_push(ev, m->data[0], m->data[1], m->data[2]);
+        }
+        default:
+            return false;
     }
+}
 
-    /* If no audio output, just output silence */
-    if (num_outputs == 0) {
-        memset(out, 0, frames * 2 * sizeof(float));
-        return 0;
-    }
+/*
+ * MIDI to CLAP translation
+ *
+ * One table per dialect, indexed by status nibble (0x8..0xE). The dialect is picked
+ * at load from clap_plugin_note_ports, so per event it's a table lookup and one call.
+ */
+#define MIDI_BEND_RANGE_SEMITONES 2.0
 
-    ensure_buffers(frames);
+typedef bool (*midi_xlate_fn)(clap_instance_t *inst, const uint8_t *msg, midi_clap_event_t *evt);
 
-    /* De-interleave input if provided and plugin has inputs */
-    if (in && num_inputs > 0) {
-        for (int i = 0; i < frames; i++) {
-            s_in_bufs[0][i] = in[i * 2];
-            s_in_bufs[1][i] = in[i * 2 + 1];
-        }
+typedef struct {
+    uint8_t len;                     /* Message length the handler needs */
+    midi_xlate_fn fn;                /* NULL = not delivered in this dialect */
+} midi_xlate_t;
+
+static void xlate_header(midi_clap_event_t *evt, uint32_t size, uint16_t type) {
+    evt->header.size = size;
+    evt->header.time = 0;
+    evt->header.space_id = CLAP_CORE_EVENT_SPACE_ID;
+    evt->header.type = type;
+    evt->header.flags = 0;
+}
+
+static bool xlate_note(clap_instance_t *inst, const uint8_t *msg, midi_clap_event_t *evt, uint16_t type) {
+    xlate_header(evt, sizeof(clap_event_note_t), type);
+    evt->note.note_id = -1;
+    evt->note.port_index = 0;
+    evt->note.channel = msg[0] & 0x0F;
+    evt->note.key = msg[1];
+    evt->note.velocity = msg[2] / 127.0;
+    if (type == CLAP_EVENT_NOTE_ON) {
+        voice_set(inst->events, msg[0] & 0x0F, msg[1], true);
     } else {
-        memset(s_in_bufs[0], 0, frames * sizeof(float));
-        memset(s_in_bufs[1], 0, frames * sizeof(float));
+        voice_note_off(inst->events, msg[0] & 0x0F, msg[1]);
     }
+    return true;
+}
 
-    /* Clear output buffers */
-    memset(s_out_bufs[0], 0, frames * sizeof(float));
-    memset(s_out_bufs[1], 0, frames * sizeof(float));
+static bool xlate_note_off(clap_instance_t *inst, const uint8_t *msg, midi_clap_event_t *evt) {
+    return xlate_note(inst, msg, evt, CLAP_EVENT_NOTE_OFF);
+}
 
-    /* Setup audio buffers */
-    clap_audio_buffer_t audio_in = {
-        .data32 = s_in_bufs,
-        .data64 = NULL,
-        .channel_count = 2,
-        .latency = 0,
-        .constant_mask = 0
-    };
+static bool xlate_note_on(clap_instance_t *inst, const uint8_t *msg, midi_clap_event_t *evt) {
+    /* Velocity 0 note on is a note off */
+    return xlate_note(inst, msg, evt, msg[2] ? CLAP_EVENT_NOTE_ON : CLAP_EVENT_NOTE_OFF);
+}
 
-    clap_audio_buffer_t audio_out = {
-        .data32 = s_out_bufs,
-        .data64 = NULL,
-        .channel_count = 2,
-        .latency = 0,
-        .constant_mask = 0
-    };
+static bool xlate_expression(midi_clap_event_t *evt, const uint8_t *msg, clap_note_expression id,
+                             int16_t key, double value) {
+    xlate_header(evt, sizeof(clap_event_note_expression_t), CLAP_EVENT_NOTE_EXPRESSION);
+    evt->expr.expression_id = id;
+    evt->expr.note_id = -1;
+    evt->expr.port_index = 0;
+    evt->expr.channel = msg[0] & 0x0F;
+    evt->expr.key = key;
+    evt->expr.value = value;
+    return true;
+}
 
-    /* Prepare MIDI events from queue */
-    prepare_midi_events();
+static bool xlate_poly_pressure(clap_instance_t *inst, const uint8_t *msg, midi_clap_event_t *evt) {
+    return xlate_expression(evt, msg, CLAP_NOTE_EXPRESSION_PRESSURE, msg[1], msg[2] / 127.0);
+}
 
-    /* Prepare param events from instance queue */
-    prepare_param_events(inst);
+static bool xlate_channel_pressure(clap_instance_t *inst, const uint8_t *msg, midi_clap_event_t *evt) {
+    return xlate_expression(evt, msg, CLAP_NOTE_EXPRESSION_PRESSURE, -1, msg[1] / 127.0);
+}
 
-    /* Event lists with queued MIDI and param events */
-    clap_input_events_t in_events = {
-        .ctx = NULL,
-        .size = s_events_size,
-        .get = s_events_get
-    };
-    clap_output_events_t out_events = {
-        .ctx = NULL,
-        .try_push = s_empty_push
-    };
+static bool xlate_pitch_bend(clap_instance_t *inst, const uint8_t *msg, midi_clap_event_t *evt) {
+    int bend = ((msg[2] << 7) | msg[1]) - 8192;
+    return xlate_expression(evt, msg, CLAP_NOTE_EXPRESSION_TUNING, -1,
+                            bend * (MIDI_BEND_RANGE_SEMITONES / 8192.0));
+}
 
-    /* Setup process struct */
-    clap_process_t process = {
-        .steady_time = -1,
-        .frames_count = (uint32_t)frames,
-        .transport = NULL,
-        .audio_inputs = (num_inputs > 0) ? &audio_in : NULL,
-        .audio_outputs = &audio_out,
-        .audio_inputs_count = (num_inputs > 0) ? 1 : 0,
-        .audio_outputs_count = 1,
-        .in_events = &in_events,
-        .out_events = &out_events
-    };
+static bool xlate_raw(clap_instance_t *inst, const uint8_t *msg, midi_clap_event_t *evt) {
+    xlate_header(evt, sizeof(clap_event_midi_t), CLAP_EVENT_MIDI);
+    evt->midi.port_index = 0;
+    evt->midi.data[0] = msg[0];
+    evt->midi.data[1] = msg[1];
+    evt->midi.data[2] = msg[2];
+    return true;
+}
 
-    /* Process */
-    clap_process_status status = plugin->process(plugin, &process);
-    if (status == CLAP_PROCESS_ERROR) {
-        return -1;
+static bool xlate_raw_note_off(clap_instance_t *inst, const uint8_t *msg, midi_clap_event_t *evt) {
+    voice_note_off(inst->events, msg[0] & 0x0F, msg[1]);
+    return xlate_raw(inst, msg, evt);
+}
+
+static bool xlate_raw_note_on(clap_instance_t *inst, const uint8_t *msg, midi_clap_event_t *evt) {
+    if (msg[2]) {
+        voice_set(inst->events, msg[0] & 0x0F, msg[1], true);
+    } else {
+        voice_note_off(inst->events, msg[0] & 0x0F, msg[1]);
     }
+    return xlate_raw(inst, msg, evt);
+}
 
-    /* Interleave output */
-    for (int i = 0; i < frames; i++) {
-        out[i * 2] = s_out_bufs[0][i];
-        out[i * 2 + 1] = s_out_bufs[1][i];
+/* Rows: dialect. Columns: note off, note on, poly pressure, CC, program, channel pressure, pitch bend */
+static const midi_xlate_t k_midi_xlate[MIDI_DIALECT_COUNT][7] = {
+    {   /* MIDI_DIALECT_RAW */
+        { 3, xlate_raw_note_off }, { 3, xlate_raw_note_on }, { 3, xlate_raw }, { 3, xlate_raw },
+        { 2, xlate_raw }, { 2, xlate_raw }, { 3, xlate_raw }
+    },
+    {   /* MIDI_DIALECT_CLAP_MIDI */
+        { 3, xlate_note_off }, { 3, xlate_note_on }, { 3, xlate_poly_pressure }, { 3, xlate_raw },
+        { 2, xlate_raw }, { 2, xlate_raw }, { 3, xlate_raw }
+    },
+    {   /* MIDI_DIALECT_CLAP */
+        { 3, xlate_note_off }, { 3, xlate_note_on }, { 3, xlate_poly_pressure }, { 3, NULL },
+        { 2, NULL }, { 2, xlate_channel_pressure }, { 3, xlate_pitch_bend }
     }
+};
 
-    return 0;
-}
+/* Convert the instance's queued MIDI to CLAP events */
+static void prepare_midi_events(clap_instance_t *inst) {
+    clap_events_t *ev = inst->events;
+    const midi_xlate_t *table = k_midi_xlate[inst->midi_dialect];
+    int n = 0;
 
-int clap_param_count(clap_instance_t *inst) {
-    if (!inst->plugin) return 0;
+    uint32_t tail = ev->midi_in_tail;
+    uint32_t head = __atomic_load_n(&ev->midi_in_head, __ATOMIC_ACQUIRE);
+    for (; tail != head && n < MAX_MIDI_EVENTS; tail++) {
+        const midi_event_t *m = &ev->midi_in[tail & (HOST_EVENT_RING_SIZE - 1)];
+        uint8_t status = m->data[0];
+        if (status < 0x80 || status >= 0xF0) continue;
 
+        const midi_xlate_t *x = &table[(status >> 4) - 8];
+        if (!x->fn || m->len < x->len) continue;
+        if (x->fn(inst, m->data, &ev->in_events[n])) n++;
+    }
+    __atomic_store_n(&ev->midi_in_tail, tail, __ATOMIC_RELEASE);
+    ev->in_event_count = n;
+}
+
+/* Drain the instance's coalesced param changes into CLAP param events */
+static void prepare_param_events(clap_instance_t *inst) {
+    clap_events_t *ev = inst->events;
+    ev->param_events = NULL;
+    ev->param_event_count = 0;
+
+    clap_param_cache_t *cache = __atomic_load_n(&inst->param_cache, __ATOMIC_ACQUIRE);
+    if (!cache) return;
+
+    int n = 0;
+    for (uint32_t sw = 0; sw <= cache->dirty_words / 64; sw++) {
+        if (!__atomic_load_n(&cache->dirty_summary[sw], __ATOMIC_RELAXED)) continue;
+        uint64_t words = __atomic_exchange_n(&cache->dirty_summary[sw], 0, __ATOMIC_ACQUIRE);
+        while (words) {
+            uint32_t w = sw * 64 + (uint32_t)__builtin_ctzll(words);
+            words &= words - 1;
+            uint64_t bits = __atomic_exchange_n(&cache->dirty[w], 0, __ATOMIC_ACQUIRE);
+            while (bits) {
+                uint32_t i = w * 64 + (uint32_t)__builtin_ctzll(bits);
+                bits &= bits - 1;
+
+                clap_event_param_value_t *evt = &cache->events[n++];
+                evt->header.size = sizeof(clap_event_param_value_t);
+                evt->header.time = 0;
+                evt->header.space_id = CLAP_CORE_EVENT_SPACE_ID;
+                evt->header.type = CLAP_EVENT_PARAM_VALUE;
+                evt->header.flags = 0;
+                evt->param_id = cache->ids[i];
+                evt->cookie = cache->cookies[i];
+                evt->note_id = -1;
+                evt->port_index = -1;
+                evt->channel = -1;
+                evt->key = -1;
+                __atomic_load(&cache->pending[i], &evt->value, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    ev->param_events = cache->events;
+    ev->param_event_count = n;
+}
+
+/* Helper: true if every sample of a planar channel is exactly zero */
+static bool channel_is_silent(const float *buf, int frames) {
+    for (int i = 0; i < frames; i++) {
+        if (buf[i] != 0.0f) return false;
+    }
+    return true;
+}
+
+static bool channel_is_silent64(const double *buf, int frames) {
+    for (int i = 0; i < frames; i++) {
+        if (buf[i] != 0.0) return false;
+    }
+    return true;
+}
+
+/* Helper: bitmask with one bit per channel of a port */
+static uint64_t port_full_mask(const clap_audio_buffer_t *buf) {
+    return buf->channel_count >= 64 ? ~0ULL : ((1ULL << buf->channel_count) - 1);
+}
+
+/* Helper: mark silent channels of a port constant */
+static void port_update_constant(clap_audio_buffer_t *buf, int frames) {
+    buf->constant_mask = 0;
+    for (uint32_t c = 0; c < buf->channel_count && c < 64; c++) {
+        bool silent = buf->data64 ? channel_is_silent64(buf->data64[c], frames)
+                                  : channel_is_silent(buf->data32[c], frames);
+        if (silent) buf->constant_mask |= 1ULL << c;
+    }
+}
+
+/* Helper: zero channels [first, channel_count) of a port */
+static void port_zero(clap_audio_buffer_t *buf, uint32_t first, int frames) {
+    for (uint32_t c = first; c < buf->channel_count; c++) {
+        if (buf->data64) {
+            memset(buf->data64[c], 0, frames * sizeof(double));
+        } else {
+            memset(buf->data32[c], 0, frames * sizeof(float));
+        }
+    }
+}
+
+/* Helper: zero a port and mark it constant */
+static void port_clear(clap_audio_buffer_t *buf, int frames) {
+    port_zero(buf, 0, frames);
+    buf->constant_mask = port_full_mask(buf);
+}
+
+/* Feed interleaved float stereo into a port - mono ports get L+R, extra channels are zeroed */
+static void port_fill_f32(clap_audio_buffer_t *buf, const float *src, int frames) {
+    if (!src || buf->channel_count == 0) {
+        port_clear(buf, frames);
+        return;
+    }
+    if (buf->data64) {
+        if (buf->channel_count == 1) {
+            double *m = buf->data64[0];
+            for (int i = 0; i < frames; i++) m[i] = ((double)src[i * 2] + src[i * 2 + 1]) * 0.5;
+        } else {
+            double *l = buf->data64[0];
+            double *r = buf->data64[1];
+            for (int i = 0; i < frames; i++) {
+                l[i] = src[i * 2];
+                r[i] = src[i * 2 + 1];
+            }
+        }
+    } else if (buf->channel_count == 1) {
+        float *m = buf->data32[0];
+        for (int i = 0; i < frames; i++) m[i] = (src[i * 2] + src[i * 2 + 1]) * 0.5f;
+    } else {
+        float *l = buf->data32[0];
+        float *r = buf->data32[1];
+        for (int i = 0; i < frames; i++) {
+            l[i] = src[i * 2];
+            r[i] = src[i * 2 + 1];
+        }
+    }
+    port_zero(buf, 2, frames);
+    port_update_constant(buf, frames);
+}
+
+/* Feed interleaved int16 stereo into a port, converting and de-interleaving in one pass */
+static void port_fill_i16(clap_audio_buffer_t *buf, const int16_t *src, int frames) {
+    if (!src || buf->channel_count == 0) {
+        port_clear(buf, frames);
+        return;
+    }
+    if (buf->data64) {
+        const double scale = 1.0 / 32768.0;
+        if (buf->channel_count == 1) {
+            double *m = buf->data64[0];
+            for (int i = 0; i < frames; i++) m[i] = (src[i * 2] + src[i * 2 + 1]) * (scale * 0.5);
+        } else {
+            double *l = buf->data64[0];
+            double *r = buf->data64[1];
+            for (int i = 0; i < frames; i++) {
+                l[i] = src[i * 2] * scale;
+                r[i] = src[i * 2 + 1] * scale;
+            }
+        }
+    } else {
+        const float scale = 1.0f / 32768.0f;
+        if (buf->channel_count == 1) {
+            float *m = buf->data32[0];
+            for (int i = 0; i < frames; i++) m[i] = (src[i * 2] + src[i * 2 + 1]) * (scale * 0.5f);
+        } else {
+            float *l = buf->data32[0];
+            float *r = buf->data32[1];
+            for (int i = 0; i < frames; i++) {
+                l[i] = src[i * 2] * scale;
+                r[i] = src[i * 2 + 1] * scale;
+            }
+        }
+    }
+    port_zero(buf, 2, frames);
+    port_update_constant(buf, frames);
+}
+
+/* Fill every input port for this block: main from the host, sidechain from its route */
+static void fill_inputs_f32(clap_instance_t *inst, const float *in, int frames) {
+    clap_audio_io_t *io = inst->io;
+    for (uint32_t i = 0; i < io->in_count; i++) {
+        clap_audio_buffer_t *buf = &io->in[i];
+        if ((int)i == io->main_in) {
+            port_fill_f32(buf, in, frames);
+        } else if ((int)i == io->sidechain_in && io->in_active[i]) {
+            port_fill_i16(buf, inst->sidechain_src ? inst->sidechain_src + inst->chunk_offset * 2 : NULL, frames);
+        } else {
+            port_clear(buf, frames);
+        }
+    }
+}
+
+static void fill_inputs_i16(clap_instance_t *inst, const int16_t *in, int frames) {
+    clap_audio_io_t *io = inst->io;
+    for (uint32_t i = 0; i < io->in_count; i++) {
+        clap_audio_buffer_t *buf = &io->in[i];
+        if ((int)i == io->main_in) {
+            port_fill_i16(buf, in, frames);
+        } else if ((int)i == io->sidechain_in && io->in_active[i]) {
+            port_fill_i16(buf, inst->sidechain_src ? inst->sidechain_src + inst->chunk_offset * 2 : NULL, frames);
+        } else {
+            port_clear(buf, frames);
+        }
+    }
+}
+
+/* SIMD accumulate: dst += src (planar buffers are 16-byte aligned, frames padded to 4) */
+typedef float clap_v4f __attribute__((vector_size(16)));
+typedef double clap_v2d __attribute__((vector_size(16)));
+
+static void mix_add(float *dst, const float *src, int frames) {
+    int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        clap_v4f d, v;
+        memcpy(&d, dst + i, sizeof(d));
+        memcpy(&v, src + i, sizeof(v));
+        d += v;
+        memcpy(dst + i, &d, sizeof(d));
+    }
+    for (; i < frames; i++) dst[i] += src[i];
+}
+
+static void mix_add64(double *dst, const double *src, int frames) {
+    int i = 0;
+    for (; i + 2 <= frames; i += 2) {
+        clap_v2d d, v;
+        memcpy(&d, dst + i, sizeof(d));
+        memcpy(&v, src + i, sizeof(v));
+        d += v;
+        memcpy(dst + i, &d, sizeof(d));
+    }
+    for (; i < frames; i++) dst[i] += src[i];
+}
+
+/* Helper: true if the plugin flagged every channel constant at zero */
+static bool port_is_silent(const clap_audio_buffer_t *buf) {
+    uint64_t full = port_full_mask(buf);
+    if ((buf->constant_mask & full) != full) return false;
+    for (uint32_t c = 0; c < buf->channel_count; c++) {
+        double first = buf->data64 ? buf->data64[c][0] : buf->data32[c][0];
+        if (first != 0.0) return false;
+    }
+    return true;
+}
+
+/* Downmix auxiliary outputs into the first two channels of the main output */
+static void mix_aux_outputs(clap_instance_t *inst, int frames) {
+    clap_audio_io_t *io = inst->io;
+    if (!inst->aux_outputs || io->main_out < 0) return;
+
+    clap_audio_buffer_t *main_buf = &io->out[io->main_out];
+    if (main_buf->channel_count == 0) return;
+    uint32_t dr = main_buf->channel_count > 1 ? 1 : 0;
+
+    for (uint32_t i = 0; i < io->out_count; i++) {
+        const clap_audio_buffer_t *buf = &io->out[i];
+        if ((int)i == io->main_out || !io->out_active[i] || buf->channel_count == 0) continue;
+        if (port_is_silent(buf)) continue;
+
+        /* Mono sources go to both sides, stereo into a mono main sums both */
+        uint32_t sr = buf->channel_count > 1 ? 1 : 0;
+        if (io->use64) {
+            mix_add64(main_buf->data64[0], buf->data64[0], frames);
+            if (dr || sr) mix_add64(main_buf->data64[dr], buf->data64[sr], frames);
+        } else {
+            mix_add(main_buf->data32[0], buf->data32[0], frames);
+            if (dr || sr) mix_add(main_buf->data32[dr], buf->data32[sr], frames);
+        }
+    }
+}
+
+/* Helper: true if every output channel is below the quiet threshold */
+static bool output_is_quiet(const clap_audio_io_t *io, int frames) {
+    for (uint32_t p = 0; p < io->out_count; p++) {
+        const clap_audio_buffer_t *buf = &io->out[p];
+        for (uint32_t c = 0; c < buf->channel_count; c++) {
+            /* Constant channels only need their first sample checked */
+            int n = (c < 64 && (buf->constant_mask & (1ULL << c))) ? 1 : frames;
+            if (buf->data64) {
+                for (int i = 0; i < n; i++) {
+                    if (fabs(buf->data64[c][i]) > HOST_QUIET_THRESHOLD) return false;
+                }
+            } else {
+                for (int i = 0; i < n; i++) {
+                    if (fabsf(buf->data32[c][i]) > HOST_QUIET_THRESHOLD) return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/* Put plugin to sleep - processing is stopped until the next note or input */
+static void enter_sleep(clap_instance_t *inst) {
+    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
+    plugin->stop_processing(plugin);
+    inst->sleeping = true;
+    inst->quiet_frames = 0;
+    /* Nothing is sounding once the plugin asks to sleep */
+    voices_clear(inst->events);
+}
+
+/* Decide whether to sleep based on the status returned by process() */
+static void update_sleep_state(clap_instance_t *inst, clap_process_status status, bool active, int frames) {
+    /* A block is quiet when nothing came in and nothing came out; only quiet blocks
+       count towards the tail, so held notes and steady input never sleep */
+    bool quiet = false;
+    if (status == CLAP_PROCESS_CONTINUE_IF_NOT_QUIET || status == CLAP_PROCESS_TAIL) {
+        quiet = !active && output_is_quiet(inst->io, frames);
+    }
+    if (quiet) {
+        inst->quiet_frames += frames;
+    } else {
+        inst->quiet_frames = 0;
+    }
+
+    switch (status) {
+        case CLAP_PROCESS_SLEEP:
+            /* Plugin says it has nothing left to do until the next event */
+            enter_sleep(inst);
+            break;
+        case CLAP_PROCESS_CONTINUE_IF_NOT_QUIET:
+            if (quiet) enter_sleep(inst);
+            break;
+        case CLAP_PROCESS_TAIL: {
+            /* Re-query tail if the plugin reported a change */
+            int gen = __atomic_load_n(&inst->host->tail_gen, __ATOMIC_ACQUIRE);
+            if (gen != inst->tail_gen) {
+                inst->tail_gen = gen;
+                inst->tail_frames = query_tail((const clap_plugin_t *)inst->plugin);
+            }
+            if (quiet && inst->tail_frames != UINT32_MAX && inst->quiet_frames >= inst->tail_frames) {
+                enter_sleep(inst);
+            }
+            break;
+        }
+        default:
+            /* CLAP_PROCESS_CONTINUE - keep processing */
+            break;
+    }
+}
+
+#ifdef CLAP_HOST_PERF
+static void perf_hist_clear(perf_hist_t *h) {
+    __atomic_store_n(&h->count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->min_ns, UINT64_MAX, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->max_ns, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->sum_ns, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < HOST_PERF_BUCKETS; i++) __atomic_store_n(&h->buckets[i], 0, __ATOMIC_RELAXED);
+}
+
+static int perf_bucket(uint64_t ns) {
+    if (ns < (1u << HOST_PERF_MIN_SHIFT)) return 0;
+    int msb = 63 - __builtin_clzll(ns);
+    int b = (msb - HOST_PERF_MIN_SHIFT) * 4 + (int)((ns >> (msb - 2)) & 3) + 1;
+    return b < HOST_PERF_BUCKETS ? b : HOST_PERF_BUCKETS - 1;
+}
+
+/* Upper bound of a bucket */
+static uint64_t perf_bucket_top(int b) {
+    if (b == 0) return 1u << HOST_PERF_MIN_SHIFT;
+    int msb = (b - 1) / 4 + HOST_PERF_MIN_SHIFT;
+    return (uint64_t)(4 + (b - 1) % 4 + 1) << (msb - 2);
+}
+
+/* Audio thread only - stores are atomic so perf_stats can read while it runs */
+static void perf_record(perf_hist_t *h, uint64_t ns) {
+    __atomic_store_n(&h->count, h->count + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->sum_ns, h->sum_ns + ns, __ATOMIC_RELAXED);
+    if (ns < h->min_ns) __atomic_store_n(&h->min_ns, ns, __ATOMIC_RELAXED);
+    if (ns > h->max_ns) __atomic_store_n(&h->max_ns, ns, __ATOMIC_RELAXED);
+    uint32_t *bucket = &h->buckets[perf_bucket(ns)];
+    __atomic_store_n(bucket, *bucket + 1, __ATOMIC_RELAXED);
+}
+
+static void perf_clear(host_perf_t *perf) {
+    perf_hist_clear(&perf->plugin);
+    perf_hist_clear(&perf->host);
+    __atomic_store_n(&perf->over_budget, 0, __ATOMIC_RELAXED);
+}
+
+/* Start of a block - returns its start time */
+static inline uint64_t perf_block_begin(clap_instance_t *inst) {
+    host_perf_t *perf = &inst->host->perf;
+    if (__atomic_exchange_n(&perf->reset_requested, 0, __ATOMIC_ACQUIRE)) perf_clear(perf);
+    perf->block_plugin_ns = 0;
+    perf->block_ran = false;
+    return now_ns();
+}
+
+static inline uint64_t perf_plugin_begin(void) {
+    return now_ns();
+}
+
+static inline void perf_plugin_end(clap_instance_t *inst, uint64_t t0) {
+    inst->host->perf.block_plugin_ns += now_ns() - t0;
+    inst->host->perf.block_ran = true;
+}
+
+/* End of a block - blocks where the plugin slept aren't recorded */
+static inline void perf_block_end(clap_instance_t *inst, uint64_t t0, int frames) {
+    host_perf_t *perf = &inst->host->perf;
+    if (!perf->block_ran) return;
+    uint64_t total = now_ns() - t0;
+    uint64_t plugin = perf->block_plugin_ns < total ? perf->block_plugin_ns : total;
+    uint64_t budget = (uint64_t)(frames * 1e9 / inst->sample_rate);
+    perf_record(&perf->plugin, plugin);
+    perf_record(&perf->host, total - plugin);
+    __atomic_store_n(&perf->budget_ns, budget, __ATOMIC_RELAXED);
+    if (total > budget) __atomic_store_n(&perf->over_budget, perf->over_budget + 1, __ATOMIC_RELAXED);
+}
+#else
+static inline uint64_t perf_block_begin(clap_instance_t *inst) { (void)inst; return 0; }
+static inline uint64_t perf_plugin_begin(void) { return 0; }
+static inline void perf_plugin_end(clap_instance_t *inst, uint64_t t0) { (void)inst; (void)t0; }
+static inline void perf_block_end(clap_instance_t *inst, uint64_t t0, int frames) { (void)inst; (void)t0; (void)frames; }
+#endif
+
+/*
+ * Run one process() call on the instance's port buffers (inputs already filled).
+ *
+ * Returns 0 when the output ports hold the plugin output, 1 when the plugin is
+ * asleep (output is silence), -1 on error.
+ */
+static int process_planar(clap_instance_t *inst, int frames) {
+    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
+    clap_audio_io_t *io = inst->io;
+
+    /* Prepare MIDI events from queue */
+    prepare_midi_events(inst);
+
+    /* Prepare param events from instance queue */
+    prepare_param_events(inst);
+
+    /* Event lists with queued MIDI and param events */
+    clap_input_events_t in_events = {
+        .ctx = inst->events,
+        .size = s_events_size,
+        .get = s_events_get
+    };
+    clap_output_events_t out_events = {
+        .ctx = inst,
+        .try_push = host_try_push
+    };
+
+    /* Record the audio thread for thread-check - batch rendering can move an instance */
+    clap_instance_host_t *ctx = inst->host;
+    pthread_t self = pthread_self();
+    s_rt_thread = 1;
+    if (!ctx->audio_thread_set || !pthread_equal(ctx->audio_thread, self)) {
+        __atomic_store_n(&ctx->audio_thread, self, __ATOMIC_RELAXED);
+        __atomic_store_n(&ctx->audio_thread_set, 1, __ATOMIC_RELEASE);
+    }
+
+    /* Notes, non-silent input or request_process count as activity and wake a sleeping plugin */
+    bool active = inst->events->in_event_count > 0;
+    if (__atomic_load_n(&ctx->process_requested, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&ctx->process_requested, 0, __ATOMIC_RELAXED);
+        active = true;
+    }
+    for (uint32_t i = 0; i < io->in_count && !active; i++) {
+        uint64_t full = port_full_mask(&io->in[i]);
+        if ((io->in[i].constant_mask & full) != full) active = true;
+    }
+
+    if (inst->sleeping) {
+        if (!active) {
+            /* Still asleep - deliver param changes through flush so they aren't lost */
+            if (inst->events->param_event_count > 0) {
+                const clap_plugin_params_t *params =
+                    (const clap_plugin_params_t *)plugin->get_extension(plugin, CLAP_EXT_PARAMS);
+                if (params && params->flush) {
+                    s_processing_inst = inst;
+                    params->flush(plugin, &in_events, &out_events);
+                    s_processing_inst = NULL;
+                }
+            }
+            inst->sleep_frames += frames;
+            return 1;
+        }
+        if (!plugin->start_processing(plugin)) {
+            return -1;
+        }
+        inst->sleeping = false;
+    }
+
+    /* Clear output buffers (an in-place main output already holds the input) */
+    for (uint32_t i = 0; i < io->out_count; i++) {
+        clap_audio_buffer_t *buf = &io->out[i];
+        buf->constant_mask = 0;
+        if (inst->in_place && (int)i == io->main_out) continue;
+        port_zero(buf, 0, frames);
+    }
+
+    /* Setup process struct */
+    clap_process_t process = {
+        .steady_time = -1,
+        .frames_count = (uint32_t)frames,
+        .transport = NULL,
+        .audio_inputs = io->in_count > 0 ? io->in : NULL,
+        .audio_outputs = io->out,
+        .audio_inputs_count = io->in_count,
+        .audio_outputs_count = io->out_count,
+        .in_events = &in_events,
+        .out_events = &out_events
+    };
+
+    /* Process */
+    s_processing_inst = inst;
+    uint64_t perf_t0 = perf_plugin_begin();
+    clap_process_status status = plugin->process(plugin, &process);
+    perf_plugin_end(inst, perf_t0);
+    s_processing_inst = NULL;
+    if (status == CLAP_PROCESS_ERROR) {
+        return -1;
+    }
+
+    update_sleep_state(inst, status, active, frames);
+    mix_aux_outputs(inst, frames);
+    return 0;
+}
+
+/*
+ * Dry path for the dry/wet mix - host input delayed by the plugin's latency so dry
+ * and wet line up. Planar stereo ring sized at least latency + max_frames.
+ */
+typedef struct clap_dry_delay {
+    float *buf[2];
+    uint32_t mask;
+    uint32_t pos;                    /* Next write position */
+    uint32_t latency;
+} clap_dry_delay_t;
+
+static void dry_free(clap_dry_delay_t *dry) {
+    if (!dry) return;
+    free(dry->buf[0]);
+    free(dry);
+}
+
+static clap_dry_delay_t *dry_create(uint32_t latency, int max_frames) {
+    clap_dry_delay_t *dry = (clap_dry_delay_t *)calloc(1, sizeof(clap_dry_delay_t));
+    if (!dry) return NULL;
+    uint32_t cap = 64;
+    while (cap < latency + (uint32_t)max_frames) cap <<= 1;
+    void *mem = NULL;
+    if (posix_memalign(&mem, 16, cap * 2 * sizeof(float)) != 0) {
+        free(dry);
+        return NULL;
+    }
+    memset(mem, 0, cap * 2 * sizeof(float));
+    dry->buf[0] = (float *)mem;
+    dry->buf[1] = dry->buf[0] + cap;
+    dry->mask = cap - 1;
+    dry->latency = latency;
+    return dry;
+}
+
+/* Helper: the dry ring to use this chunk, NULL when the mix is fully wet or there's no input */
+static clap_dry_delay_t *dry_active(clap_instance_t *inst, const void *in) {
+    float mix;
+    __atomic_load(&inst->mix, &mix, __ATOMIC_RELAXED);
+    if (!in || mix >= 1.0f) return NULL;
+    return __atomic_load_n(&inst->dry, __ATOMIC_ACQUIRE);
+}
+
+static void dry_write_i16(clap_dry_delay_t *dry, const int16_t *in, int frames) {
+    const float scale = 1.0f / 32768.0f;
+    for (int i = 0; i < frames; i++) {
+        uint32_t p = (dry->pos + i) & dry->mask;
+        dry->buf[0][p] = in[i * 2] * scale;
+        dry->buf[1][p] = in[i * 2 + 1] * scale;
+    }
+    dry->pos = (dry->pos + frames) & dry->mask;
+}
+
+static void dry_write_f32(clap_dry_delay_t *dry, const float *in, int frames) {
+    for (int i = 0; i < frames; i++) {
+        uint32_t p = (dry->pos + i) & dry->mask;
+        dry->buf[0][p] = in[i * 2];
+        dry->buf[1][p] = in[i * 2 + 1];
+    }
+    dry->pos = (dry->pos + frames) & dry->mask;
+}
+
+/* SIMD crossfade: wet = dry + (wet - dry) * mix */
+static void mix_dry_f32(float *wet, const float *dry, int frames, float mix) {
+    clap_v4f m = { mix, mix, mix, mix };
+    int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        clap_v4f w, d;
+        memcpy(&w, wet + i, sizeof(w));
+        memcpy(&d, dry + i, sizeof(d));
+        w = d + (w - d) * m;
+        memcpy(wet + i, &w, sizeof(w));
+    }
+    for (; i < frames; i++) wet[i] = dry[i] + (wet[i] - dry[i]) * mix;
+}
+
+/* Same for double outputs - the float dry ring is widened two samples at a time */
+static void mix_dry_f64(double *wet, const float *dry, int frames, float mix) {
+    clap_v2d m = { mix, mix };
+    int i = 0;
+    for (; i + 2 <= frames; i += 2) {
+        clap_v2d w;
+        clap_v2d d = { dry[i], dry[i + 1] };
+        memcpy(&w, wet + i, sizeof(w));
+        w = d + (w - d) * m;
+        memcpy(wet + i, &w, sizeof(w));
+    }
+    for (; i < frames; i++) wet[i] = dry[i] + (wet[i] - dry[i]) * (double)mix;
+}
+
+/* Blend the delayed dry input into the main output (after dry_write for this chunk) */
+static void dry_mix(clap_instance_t *inst, clap_dry_delay_t *dry, int frames) {
+    clap_audio_io_t *io = inst->io;
+    clap_audio_buffer_t *main_buf = &io->out[io->main_out];
+    float mix;
+    __atomic_load(&inst->mix, &mix, __ATOMIC_RELAXED);
+    if (mix < 0.0f) mix = 0.0f;
+
+    /* Read position is this chunk's start, latency frames back - at most two runs */
+    uint32_t start = (dry->pos - (uint32_t)frames - dry->latency) & dry->mask;
+    int first = (int)(dry->mask + 1 - start);
+    if (first > frames) first = frames;
+
+    uint32_t channels = main_buf->channel_count > 1 ? 2 : 1;
+    for (uint32_t c = 0; c < channels; c++) {
+        /* A mono main output gets the left dry channel */
+        const float *d = dry->buf[c];
+        if (main_buf->data64) {
+            mix_dry_f64(main_buf->data64[c], d + start, first, mix);
+            mix_dry_f64(main_buf->data64[c] + first, d, frames - first, mix);
+        } else {
+            mix_dry_f32(main_buf->data32[c], d + start, first, mix);
+            mix_dry_f32(main_buf->data32[c] + first, d, frames - first, mix);
+        }
+    }
+    main_buf->constant_mask = 0;
+}
+
+/*
+ * Enter/leave the audio-thread section guarded against re-activation.
+ * Pairs with suspend_processing(): seq_cst on both sides so either the audio
+ * thread sees the suspend request or the main thread sees it in process().
+ */
+static bool process_enter(clap_instance_t *inst) {
+    __atomic_store_n(&inst->in_process, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&inst->suspend, __ATOMIC_SEQ_CST)) {
+        __atomic_store_n(&inst->in_process, 0, __ATOMIC_RELEASE);
+        return false;
+    }
+    return true;
+}
+
+static void process_leave(clap_instance_t *inst) {
+    __atomic_store_n(&inst->in_process, 0, __ATOMIC_RELEASE);
+}
+
+/* Process one chunk of at most max_frames from/to interleaved float */
+static int process_chunk_f32(clap_instance_t *inst, const float *in, float *out, int frames, int offset) {
+    clap_audio_io_t *io = inst->io;
+
+    inst->chunk_offset = offset;
+    fill_inputs_f32(inst, in, frames);
+    clap_dry_delay_t *dry = dry_active(inst, in);
+    if (dry) dry_write_f32(dry, in, frames);
+
+    int rc = process_planar(inst, frames);
+    if (rc < 0) return -1;
+    if (rc > 0) {
+        if (!dry) {
+            memset(out, 0, frames * 2 * sizeof(float));
+            return 0;
+        }
+        /* Asleep - the dry part still plays */
+        port_clear(&io->out[io->main_out], frames);
+    }
+    if (dry) dry_mix(inst, dry, frames);
+
+    /* Interleave main output - mono is sent to both sides */
+    const clap_audio_buffer_t *main_buf = &io->out[io->main_out];
+    uint32_t rc_idx = main_buf->channel_count > 1 ? 1 : 0;
+    if (main_buf->data64) {
+        const double *l = main_buf->data64[0];
+        const double *r = main_buf->data64[rc_idx];
+        for (int i = 0; i < frames; i++) {
+            out[i * 2] = (float)l[i];
+            out[i * 2 + 1] = (float)r[i];
+        }
+        return 0;
+    }
+    const float *l = main_buf->data32[0];
+    const float *r = main_buf->data32[rc_idx];
+    for (int i = 0; i < frames; i++) {
+        out[i * 2] = l[i];
+        out[i * 2 + 1] = r[i];
+    }
+    return 0;
+}
+
+/* Process one chunk of at most max_frames from/to interleaved int16 */
+static int process_chunk_i16(clap_instance_t *inst, const int16_t *in, int16_t *out, int frames, int offset) {
+    clap_audio_io_t *io = inst->io;
+
+    /* Convert and de-interleave straight into the plugin's input buffers */
+    inst->chunk_offset = offset;
+    fill_inputs_i16(inst, in, frames);
+    clap_dry_delay_t *dry = dry_active(inst, in);
+    if (dry) dry_write_i16(dry, in, frames);
+
+    int rc = process_planar(inst, frames);
+    if (rc < 0) return -1;
+    if (rc > 0) {
+        if (!dry) {
+            memset(out, 0, frames * 2 * sizeof(int16_t));
+            return 0;
+        }
+        port_clear(&io->out[io->main_out], frames);
+    }
+    if (dry) dry_mix(inst, dry, frames);
+
+    /* Clamp, convert and interleave straight from the plugin's main output */
+    const clap_audio_buffer_t *main_buf = &io->out[io->main_out];
+    uint32_t rc_idx = main_buf->channel_count > 1 ? 1 : 0;
+    if (main_buf->data64) {
+        const double *l = main_buf->data64[0];
+        const double *r = main_buf->data64[rc_idx];
+        for (int i = 0; i < frames; i++) {
+            double sl = l[i];
+            double sr = r[i];
+            sl = sl > 1.0 ? 1.0 : (sl < -1.0 ? -1.0 : sl);
+            sr = sr > 1.0 ? 1.0 : (sr < -1.0 ? -1.0 : sr);
+            out[i * 2] = (int16_t)(sl * 32767.0);
+            out[i * 2 + 1] = (int16_t)(sr * 32767.0);
+        }
+        return 0;
+    }
+    const float *l = main_buf->data32[0];
+    const float *r = main_buf->data32[rc_idx];
+    for (int i = 0; i < frames; i++) {
+        float sl = l[i];
+        float sr = r[i];
+        sl = sl > 1.0f ? 1.0f : (sl < -1.0f ? -1.0f : sl);
+        sr = sr > 1.0f ? 1.0f : (sr < -1.0f ? -1.0f : sr);
+        out[i * 2] = (int16_t)(sl * 32767.0f);
+        out[i * 2 + 1] = (int16_t)(sr * 32767.0f);
+    }
+    return 0;
+}
+
+int clap_process_block(clap_instance_t *inst, const float *in, float *out, int frames) {
+    if (!inst->plugin || !process_enter(inst)) {
+        return -1;
+    }
+    /* Checked inside - a restart on the main loop may have left it stopped */
+    if (!inst->processing) {
+        process_leave(inst);
+        return -1;
+    }
+
+    /* If no audio output, just output silence */
+    clap_audio_io_t *io = inst->io;
+    if (io->main_out < 0 || io->out[io->main_out].channel_count == 0) {
+        memset(out, 0, frames * 2 * sizeof(float));
+        process_leave(inst);
+        return 0;
+    }
+
+    uint64_t perf_t0 = perf_block_begin(inst);
+    io_apply_activation(inst);
+
+    /* Blocks longer than the activated maximum are split */
+    int rc = 0;
+    for (int done = 0; done < frames && rc == 0; ) {
+        int n = frames - done;
+        if (n > inst->max_frames) n = inst->max_frames;
+        rc = process_chunk_f32(inst, in ? in + done * 2 : NULL, out + done * 2, n, done);
+        done += n;
+    }
+    perf_block_end(inst, perf_t0, frames);
+
+    process_leave(inst);
+    return rc;
+}
+
+int clap_process_block_i16(clap_instance_t *inst, const int16_t *in, int16_t *out, int frames) {
+    if (!inst->plugin || !process_enter(inst)) {
+        return -1;
+    }
+    /* Checked inside - a restart on the main loop may have left it stopped */
+    if (!inst->processing) {
+        process_leave(inst);
+        return -1;
+    }
+
+    clap_audio_io_t *io = inst->io;
+    if (io->main_out < 0 || io->out[io->main_out].channel_count == 0) {
+        memset(out, 0, frames * 2 * sizeof(int16_t));
+        process_leave(inst);
+        return 0;
+    }
+
+    uint64_t perf_t0 = perf_block_begin(inst);
+    io_apply_activation(inst);
+
+    /* Blocks longer than the activated maximum are split */
+    int rc = 0;
+    for (int done = 0; done < frames && rc == 0; ) {
+        int n = frames - done;
+        if (n > inst->max_frames) n = inst->max_frames;
+        rc = process_chunk_i16(inst, in ? in + done * 2 : NULL, out + done * 2, n, done);
+        done += n;
+    }
+    perf_block_end(inst, perf_t0, frames);
+
+    process_leave(inst);
+    return rc;
+}
+
+/*
+ * Batch scheduler - independent instances rendered across the worker pool.
+ * Instances are ordered by recent cost, most expensive first; workers and the caller
+ * then pull the next instance as they free up, so cheap plugins fill in around the
+ * slowest one and the block takes about as long as that one plugin.
+ */
+#define HOST_BATCH_MAX 32
+
+typedef struct {
+    clap_batch_item_t *items;
+    int order[HOST_BATCH_MAX];
+} batch_ctx_t;
+
+static void batch_task(void *ctx, uint32_t index) {
+    batch_ctx_t *b = (batch_ctx_t *)ctx;
+    clap_batch_item_t *item = &b->items[b->order[index]];
+    clap_instance_t *inst = item->inst;
+
+    uint64_t t0 = now_ns();
+    item->result = clap_process_block_i16(inst, item->in, item->out, item->frames);
+    uint64_t ns = now_ns() - t0;
+    /* Running average over ~8 blocks */
+    inst->cost_ns = inst->cost_ns - (inst->cost_ns >> 3) + (ns >> 3);
+}
+
+int clap_process_batch_i16(clap_batch_item_t *items, int count) {
+    int rc = 0;
+    for (int base = 0; base < count; base += HOST_BATCH_MAX) {
+        batch_ctx_t b;
+        int n = count - base > HOST_BATCH_MAX ? HOST_BATCH_MAX : count - base;
+        b.items = items + base;
+
+        /* Insertion sort by cost, descending - batches are a handful of instances */
+        for (int i = 0; i < n; i++) {
+            int j = i;
+            while (j > 0 && b.items[b.order[j - 1]].inst->cost_ns < b.items[i].inst->cost_ns) {
+                b.order[j] = b.order[j - 1];
+                j--;
+            }
+            b.order[j] = i;
+        }
+
+        pool_exec(batch_task, &b, (uint32_t)n, NULL);
+        for (int i = 0; i < n; i++) {
+            if (b.items[i].result != 0) rc = -1;
+        }
+    }
+    return rc;
+}
+
+void clap_set_batch(clap_instance_t *inst, bool enabled) {
+    if (!inst || inst->batch == enabled) return;
+    inst->batch = enabled;
+    if (enabled) {
+        pool_acquire();
+    } else {
+        pool_release();
+    }
+}
+
+void clap_set_sidechain_input(clap_instance_t *inst, const int16_t *in) {
+    if (inst) inst->sidechain_src = in;
+}
+
+void clap_set_aux_outputs(clap_instance_t *inst, bool enabled) {
+    if (inst) inst->aux_outputs = enabled;
+}
+
+/* Shared sidechain buses - any instance can send its output for others to key from */
+static int16_t s_sidechain_bus[CLAP_SIDECHAIN_BUS_COUNT][CLAP_SIDECHAIN_BUS_FRAMES * 2];
+
+void clap_sidechain_bus_write(int bus, const int16_t *audio, int frames) {
+    if (bus < 0 || bus >= CLAP_SIDECHAIN_BUS_COUNT || !audio) return;
+    if (frames > CLAP_SIDECHAIN_BUS_FRAMES) frames = CLAP_SIDECHAIN_BUS_FRAMES;
+    memcpy(s_sidechain_bus[bus], audio, frames * 2 * sizeof(int16_t));
+}
+
+const int16_t *clap_sidechain_bus_read(int bus) {
+    if (bus < 0 || bus >= CLAP_SIDECHAIN_BUS_COUNT) return NULL;
+    return s_sidechain_bus[bus];
+}
+
+int clap_sidechain_parse(const char *val) {
+    if (!val) return CLAP_SIDECHAIN_OFF;
+    if (strcmp(val, "line_in") == 0) return CLAP_SIDECHAIN_LINE_IN;
+    if (strncmp(val, "bus_", 4) == 0) {
+        int bus = atoi(val + 4) - 1;
+        if (bus >= 0 && bus < CLAP_SIDECHAIN_BUS_COUNT) return bus;
+    }
+    return CLAP_SIDECHAIN_OFF;
+}
+
+int clap_sidechain_format(int source, char *buf, int buf_len) {
+    if (source == CLAP_SIDECHAIN_LINE_IN) return snprintf(buf, buf_len, "line_in");
+    if (source >= 0 && source < CLAP_SIDECHAIN_BUS_COUNT) return snprintf(buf, buf_len, "bus_%d", source + 1);
+    return snprintf(buf, buf_len, "off");
+}
+
+#ifdef CLAP_HOST_PERF
+/* Append one histogram's summary as a JSON object */
+static int perf_hist_format(const perf_hist_t *h, char *buf, int buf_len) {
+    uint64_t count = __atomic_load_n(&h->count, __ATOMIC_RELAXED);
+    uint64_t min_ns = __atomic_load_n(&h->min_ns, __ATOMIC_RELAXED);
+    uint64_t max_ns = __atomic_load_n(&h->max_ns, __ATOMIC_RELAXED);
+    uint64_t sum_ns = __atomic_load_n(&h->sum_ns, __ATOMIC_RELAXED);
+    if (count == 0) min_ns = 0;
+
+    /* Percentiles are the top of the bucket they fall in, clamped to the observed range */
+    uint64_t pct[2] = { 0, 0 };
+    const uint64_t rank[2] = { (count + 1) / 2, count - count / 100 };
+    uint64_t seen = 0;
+    int p = 0;
+    for (int b = 0; b < HOST_PERF_BUCKETS && p < 2 && count > 0; b++) {
+        seen += __atomic_load_n(&h->buckets[b], __ATOMIC_RELAXED);
+        while (p < 2 && seen >= rank[p]) {
+            uint64_t top = perf_bucket_top(b);
+            pct[p++] = top > max_ns ? max_ns : (top < min_ns ? min_ns : top);
+        }
+    }
+    return snprintf(buf, buf_len,
+                    "{\"min_us\":%.1f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f,\"mean_us\":%.1f}",
+                    min_ns / 1000.0, pct[0] / 1000.0, pct[1] / 1000.0, max_ns / 1000.0,
+                    count ? sum_ns / 1000.0 / count : 0.0);
+}
+#endif
+
+int clap_perf_stats(clap_instance_t *inst, char *buf, int buf_len) {
+#ifdef CLAP_HOST_PERF
+    if (!inst || !inst->host || !buf || buf_len <= 0) return -1;
+    const host_perf_t *perf = &inst->host->perf;
+    int n = snprintf(buf, buf_len, "{\"blocks\":%llu,\"over_budget\":%llu,\"budget_us\":%.1f,\"plugin\":",
+                     (unsigned long long)__atomic_load_n(&perf->plugin.count, __ATOMIC_RELAXED),
+                     (unsigned long long)__atomic_load_n(&perf->over_budget, __ATOMIC_RELAXED),
+                     __atomic_load_n(&perf->budget_ns, __ATOMIC_RELAXED) / 1000.0);
+    if (n < buf_len) n += perf_hist_format(&perf->plugin, buf + n, buf_len - n);
+    if (n < buf_len) n += snprintf(buf + n, buf_len - n, ",\"host\":");
+    if (n < buf_len) n += perf_hist_format(&perf->host, buf + n, buf_len - n);
+    if (n < buf_len) n += snprintf(buf + n, buf_len - n, "}");
+    return n < buf_len ? n : -1;
+#else
+    (void)inst; (void)buf; (void)buf_len;
+    return -1;
+#endif
+}
+
+void clap_perf_reset(clap_instance_t *inst) {
+#ifdef CLAP_HOST_PERF
+    if (inst && inst->host) __atomic_store_n(&inst->host->perf.reset_requested, 1, __ATOMIC_RELEASE);
+#else
+    (void)inst;
+#endif
+}
+
+double clap_sleep_ms(clap_instance_t *inst) {
+    if (!inst || inst->sample_rate <= 0.0) return 0.0;
+    return (double)inst->sleep_frames * 1000.0 / inst->sample_rate;
+}
+
+void clap_host_set_audio_config(double sample_rate, int max_frames) {
+    if (sample_rate > 0.0) s_sample_rate = sample_rate;
+    if (max_frames > 0) s_max_frames = max_frames > HOST_MAX_FRAMES ? HOST_MAX_FRAMES : max_frames;
+}
+
+/* Stop the audio thread from entering process() and wait for it to leave */
+/* Nests - the main loop can restart a plugin while the caller's thread swaps its param table */
+/* Returns false, with nothing suspended, if process() doesn't return in time - the
+   caller must then leave everything the audio thread uses in place */
+static bool suspend_processing(clap_instance_t *inst) {
+    __atomic_add_fetch(&inst->suspend, 1, __ATOMIC_SEQ_CST);
+    for (int waited = 0; __atomic_load_n(&inst->in_process, __ATOMIC_SEQ_CST); waited += 100) {
+        if (waited >= HOST_SUSPEND_TIMEOUT_US) {
+            __atomic_sub_fetch(&inst->suspend, 1, __ATOMIC_SEQ_CST);
+            HOST_LOG(CLAP_HOST_LOG_ERROR, "process() did not return within %d ms",
+                     HOST_SUSPEND_TIMEOUT_US / 1000);
+            return false;
+        }
+        usleep(100);
+    }
+    return true;
+}
+
+static void resume_processing(clap_instance_t *inst) {
+    __atomic_sub_fetch(&inst->suspend, 1, __ATOMIC_SEQ_CST);
+}
+
+static int reconfigure(clap_instance_t *inst, double sample_rate, int max_frames) {
+    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
+    HOST_LOG(CLAP_HOST_LOG_INFO, "Re-activating at %.0f Hz, %d frames", sample_rate, max_frames);
+
+    /* The buffers are freed below - give up rather than pull them from under process() */
+    if (!suspend_processing(inst)) return -1;
+
+    if (inst->processing) {
+        if (!inst->sleeping) plugin->stop_processing(plugin);
+        inst->processing = false;
+        inst->sleeping = false;
+    }
+    if (inst->activated) {
+        plugin->deactivate(plugin);
+        inst->activated = false;
+    }
+
+    /* Buffers are sized to the new maximum block */
+    io_free(inst->io);
+    inst->io = NULL;
+    inst->sample_rate = sample_rate;
+    inst->max_frames = max_frames;
+    /* On failure processing stays false, which keeps the audio thread out */
+    if (io_create(inst, plugin, max_frames) != 0) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "audio port setup failed");
+        resume_processing(inst);
+        return -1;
+    }
+
+    if (!plugin->activate(plugin, sample_rate, HOST_MIN_FRAMES, (uint32_t)max_frames)) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "plugin->activate failed");
+        resume_processing(inst);
+        return -1;
+    }
+    inst->activated = true;
+
+    if (!plugin->start_processing(plugin)) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "plugin->start_processing failed");
+        resume_processing(inst);
+        return -1;
+    }
+    inst->processing = true;
+    inst->quiet_frames = 0;
+
+    /* Latency may change with the rate; the dry ring also depends on max_frames */
+    inst->latency_gen = __atomic_load_n(&inst->host->latency_gen, __ATOMIC_ACQUIRE);
+    inst->latency = query_latency(plugin);
+    if (inst->dry) {
+        dry_free(inst->dry);
+        inst->dry = dry_create(inst->latency, inst->max_frames);
+    }
+
+    resume_processing(inst);
+    return 0;
+}
+
+int clap_reconfigure(clap_instance_t *inst, double sample_rate, int max_frames) {
+    if (!inst || !inst->plugin) return -1;
+    if (max_frames > HOST_MAX_FRAMES) max_frames = HOST_MAX_FRAMES;
+    if (sample_rate <= 0.0) sample_rate = inst->sample_rate;
+    if (max_frames <= 0) max_frames = inst->max_frames;
+    if (sample_rate == inst->sample_rate && max_frames == inst->max_frames) return 0;
+
+    /* Not while the main loop is calling into a plugin */
+    pthread_mutex_lock(&s_loop_mutex);
+    int rc = reconfigure(inst, sample_rate, max_frames);
+    pthread_mutex_unlock(&s_loop_mutex);
+    return rc;
+}
+
+/*
+ * Helper: re-query latency after latency_changed and realign the dry ring (main thread)
+ * Holds s_loop_mutex - a restart on the main loop replaces the ring and latency too.
+ */
+static void latency_sync(clap_instance_t *inst) {
+    pthread_mutex_lock(&s_loop_mutex);
+    int gen = __atomic_load_n(&inst->host->latency_gen, __ATOMIC_ACQUIRE);
+    if (gen == inst->latency_gen) {
+        pthread_mutex_unlock(&s_loop_mutex);
+        return;
+    }
+    uint32_t latency = query_latency((const clap_plugin_t *)inst->plugin);
+    if (latency != inst->latency && inst->dry) {
+        /* Keep the old ring and retry on the next call if process() is stuck */
+        clap_dry_delay_t *fresh = dry_create(latency, inst->max_frames);
+        if (!suspend_processing(inst)) {
+            pthread_mutex_unlock(&s_loop_mutex);
+            dry_free(fresh);
+            return;
+        }
+        clap_dry_delay_t *old = inst->dry;
+        __atomic_store_n(&inst->dry, fresh, __ATOMIC_RELEASE);
+        resume_processing(inst);
+        dry_free(old);
+    }
+    inst->latency_gen = gen;
+    inst->latency = latency;
+    pthread_mutex_unlock(&s_loop_mutex);
+}
+
+uint32_t clap_latency(clap_instance_t *inst) {
+    if (!inst || !inst->plugin) return 0;
+    latency_sync(inst);
+    pthread_mutex_lock(&s_loop_mutex);
+    uint32_t latency = inst->latency;
+    pthread_mutex_unlock(&s_loop_mutex);
+    return latency;
+}
+
+int clap_set_mix(clap_instance_t *inst, float mix) {
+    if (!inst || !inst->plugin) return -1;
+    mix = mix < 0.0f ? 0.0f : (mix > 1.0f ? 1.0f : mix);
+
+    /* The dry ring is created on first use and kept - not while a restart replaces it */
+    pthread_mutex_lock(&s_loop_mutex);
+    latency_sync(inst);
+    if (mix < 1.0f && !inst->dry) {
+        clap_dry_delay_t *dry = dry_create(inst->latency, inst->max_frames);
+        if (!dry) {
+            pthread_mutex_unlock(&s_loop_mutex);
+            return -1;
+        }
+        __atomic_store_n(&inst->dry, dry, __ATOMIC_RELEASE);
+    }
+    __atomic_store(&inst->mix, &mix, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&s_loop_mutex);
+    return 0;
+}
+
+int clap_param_count(clap_instance_t *inst) {
+    if (!inst->plugin) return 0;
+
+    clap_param_cache_t *cache = param_cache_sync(inst);
+    return cache ? (int)cache->count : 0;
+}
+
+int clap_param_info(clap_instance_t *inst, int index, char *name, int name_len, double *min, double *max, double *def) {
+    if (!inst->plugin) return -1;
+
+    clap_param_cache_t *cache = param_cache_sync(inst);
+    if (!cache || index < 0 || (uint32_t)index >= cache->count) return -1;
+    if (cache->ids[index] == CLAP_INVALID_ID) return -1;
+
+    if (name && name_len > 0) {
+        strncpy(name, cache->names[index], name_len - 1);
+        name[name_len - 1] = '\0';
+    }
+    if (min) *min = cache->min[index];
+    if (max) *max = cache->max[index];
+    if (def) *def = cache->def[index];
+
+    return 0;
+}
+
+int clap_param_module(clap_instance_t *inst, int index, char *buf, int buf_len) {
+    if (!inst->plugin || !buf || buf_len <= 0) return -1;
+
+    clap_param_cache_t *cache = param_cache_sync(inst);
+    if (!cache || index < 0 || (uint32_t)index >= cache->count) return -1;
+    if (cache->ids[index] == CLAP_INVALID_ID) return -1;
+
+    const char *module = cache->module_off[index] ? cache->module_pool + cache->module_off[index] : "";
+    return snprintf(buf, buf_len, "%s", module);
+}
+
+int clap_param_set(clap_instance_t *inst, int index, double value) {
+    if (!inst || !inst->plugin) return -1;
+
+    clap_param_cache_t *cache = param_cache_sync(inst);
+    if (!cache || index < 0 || (uint32_t)index >= cache->count) return -1;
+    if (cache->ids[index] == CLAP_INVALID_ID) return -1;
+
+    /* Queue the param change for next process block */
+    param_queue_push(cache, (uint32_t)index, value);
+
+    __atomic_store(&cache->values[index], &value, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&cache->values_gen, 1, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+uint32_t clap_param_generation(clap_instance_t *inst) {
+    if (!inst || !inst->plugin) return 0;
+
+    /* Each part only grows, so the sum changes whenever any of them does */
+    clap_param_cache_t *cache = param_cache_sync(inst);
+    remote_pages_sync(inst);
+    uint32_t gen = (uint32_t)__atomic_load_n(&inst->host->params_gen, __ATOMIC_ACQUIRE) +
+                   (uint32_t)__atomic_load_n(&inst->host->remote_gen, __ATOMIC_ACQUIRE);
+    if (cache) gen += __atomic_load_n(&cache->values_gen, __ATOMIC_ACQUIRE);
+    return gen;
+}
+
+/* Render a param's display string, reusing the last one while the value is unchanged */
+static int param_text_render(clap_instance_t *inst, clap_param_cache_t *cache, uint32_t index,
+                             char *buf, int buf_len) {
+    double value;
+    __atomic_load(&cache->values[index], &value, __ATOMIC_RELAXED);
+
+    if (!cache->text) {
+        cache->text = (char (*)[HOST_PARAM_TEXT_SIZE])calloc(cache->count + 1, HOST_PARAM_TEXT_SIZE);
+        cache->text_value = (double *)calloc(cache->count + 1, sizeof(double));
+        cache->text_valid = (uint8_t *)calloc(cache->count + 1, 1);
+        if (!cache->text || !cache->text_value || !cache->text_valid) {
+            free(cache->text);
+            free(cache->text_value);
+            free(cache->text_valid);
+            cache->text = NULL;
+            cache->text_value = NULL;
+            cache->text_valid = NULL;
+        }
+    }
+    if (cache->text && cache->text_valid[index] && cache->text_value[index] == value) {
+        return snprintf(buf, buf_len, "%s", cache->text[index]);
+    }
+
+    char text[HOST_PARAM_TEXT_SIZE] = "";
+    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
+    if (!cache->params->value_to_text ||
+        !cache->params->value_to_text(plugin, cache->ids[index], value, text, sizeof(text)) || !text[0]) {
+        snprintf(text, sizeof(text), "%.3f", value);
+    }
+    text[sizeof(text) - 1] = '\0';
+    if (cache->text) {
+        memcpy(cache->text[index], text, sizeof(text));
+        cache->text_value[index] = value;
+        cache->text_valid[index] = 1;
+    }
+    return snprintf(buf, buf_len, "%s", text);
+}
+
+int clap_param_text(clap_instance_t *inst, int index, char *buf, int buf_len) {
+    if (!inst || !inst->plugin || !buf || buf_len <= 0) return -1;
+
+    /* value_to_text is a main-thread call - keep it off the loop's dispatch */
+    pthread_mutex_lock(&s_loop_mutex);
+    int rc = -1;
+    clap_param_cache_t *cache = param_cache_sync(inst);
+    if (cache && index >= 0 && (uint32_t)index < cache->count && cache->ids[index] != CLAP_INVALID_ID) {
+        rc = param_text_render(inst, cache, (uint32_t)index, buf, buf_len);
+    }
+    pthread_mutex_unlock(&s_loop_mutex);
+    return rc;
+}
+
+double clap_param_get(clap_instance_t *inst, int index) {
+    if (!inst->plugin) return 0.0;
+
+    /* Mirror holds what we sent plus what the plugin reported - no plugin call needed */
+    clap_param_cache_t *cache = param_cache_sync(inst);
+    if (!cache || index < 0 || (uint32_t)index >= cache->count) return 0.0;
+
+    double value;
+    __atomic_load(&cache->values[index], &value, __ATOMIC_RELAXED);
+    return value;
+}
+
+int clap_send_midi(clap_instance_t *inst, const uint8_t *msg, int len) {
+    if (!msg || len < 1 || len > 3) return -1;
+
+    clap_events_t *ev = inst ? inst->events : NULL;
+    if (!ev) return -1;
+
+    /* Dropped when the audio thread is a full ring behind */
+    uint32_t head = ev->midi_in_head;
+    if (head - __atomic_load_n(&ev->midi_in_tail, __ATOMIC_ACQUIRE) >= HOST_EVENT_RING_SIZE) return -1;
+    midi_event_t *evt = &ev->midi_in[head & (HOST_EVENT_RING_SIZE - 1)];
+    evt->len = len;
+    for (int i = 0; i < 3; i++) {
+        evt->data[i] = i < len ? msg[i] : 0;
+    }
+    __atomic_store_n(&ev->midi_in_head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int clap_midi_out_read(clap_instance_t *inst, uint8_t msg[3]) {
+    clap_events_t *ev = inst ? inst->events : NULL;
+    if (!ev) return 0;
+
+    uint32_t tail = ev->midi_tail;
+    if (tail == __atomic_load_n(&ev->midi_head, __ATOMIC_ACQUIRE)) return 0;
+    const midi_event_t *evt = &ev->midi[tail & (HOST_EVENT_RING_SIZE - 1)];
+    int len = evt->len;
+    memcpy(msg, evt->data, 3);
+    __atomic_store_n(&ev->midi_tail, tail + 1, __ATOMIC_RELEASE);
+    return len;
+}
+
+int clap_active_voices(clap_instance_t *inst) {
+    if (!inst || !inst->events) return 0;
+    return __atomic_load_n(&inst->events->voices, __ATOMIC_RELAXED);
+}
+
+double clap_thread_pool_speedup(clap_instance_t *inst) {
+    if (!inst) return 0.0;
+    uint64_t wall = __atomic_load_n(&inst->pool_wall_ns, __ATOMIC_RELAXED);
+    uint64_t task = __atomic_load_n(&inst->pool_task_ns, __ATOMIC_RELAXED);
+    return wall > 0 ? (double)task / (double)wall : 0.0;
+}
+
+/*
+ * Plugin state (clap_plugin_state)
+ *
+ * Saves go into the instance's preallocated buffers: the main loop takes a snapshot after
+ * the plugin marks itself dirty, so saving a patch usually copies the last snapshot
+ * instead of calling into the plugin. A blob is a small header naming the plugin,
+ * followed by the plugin's own state bytes.
+ */
+#define STATE_MAGIC 0x54534c43u          /* "CLST" */
+#define STATE_VERSION 1
+#define STATE_FILE_EXT ".clapstate"
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t id_len;                 /* Plugin id bytes after the header, then the state */
+    uint32_t state_len;
+} state_header_t;
+
+/* Helper: make room for size more bytes, doubling the capacity */
+static bool state_buf_reserve(state_buf_t *buf, size_t size) {
+    if (size <= buf->cap - buf->len) return true;
+    size_t cap = buf->cap ? buf->cap : HOST_STATE_PREALLOC;
+    while (cap - buf->len < size) cap *= 2;
+    uint8_t *data = (uint8_t *)realloc(buf->data, cap);
+    if (!data) return false;
+    buf->data = data;
+    buf->cap = cap;
+    return true;
+}
+
+static int64_t state_ostream_write(const clap_ostream_t *stream, const void *buffer, uint64_t size) {
+    state_buf_t *buf = (state_buf_t *)stream->ctx;
+    if (!state_buf_reserve(buf, (size_t)size)) {
+        buf->failed = true;
+        return -1;
+    }
+    memcpy(buf->data + buf->len, buffer, (size_t)size);
+    buf->len += (size_t)size;
+    return (int64_t)size;
+}
+
+static int64_t state_istream_read(const clap_istream_t *stream, void *buffer, uint64_t size) {
+    state_buf_t *buf = (state_buf_t *)stream->ctx;
+    size_t n = buf->len - buf->pos < size ? buf->len - buf->pos : (size_t)size;
+    memcpy(buffer, buf->data + buf->pos, n);
+    buf->pos += n;
+    return (int64_t)n;
+}
+
+static const clap_plugin_state_t *state_ext(const clap_plugin_t *plugin) {
+    return (const clap_plugin_state_t *)plugin->get_extension(plugin, CLAP_EXT_STATE);
+}
+
+/* Save the state into the scratch buffer and swap it in (main thread, s_loop_mutex held) */
+static int state_snapshot(clap_instance_t *inst) {
+    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
+    const clap_plugin_state_t *state = state_ext(plugin);
+    if (!state) return -1;
+
+    clap_instance_host_t *ctx = inst->host;
+    state_buf_t *scratch = &ctx->state_scratch;
+    scratch->len = 0;
+    scratch->failed = false;
+    clap_ostream_t stream = { scratch, state_ostream_write };
+    if (!state->save(plugin, &stream) || scratch->failed) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "state save failed for %s", inst->path);
+        return -1;
+    }
+
+    state_buf_t snap = ctx->state_snap;
+    ctx->state_snap = *scratch;
+    *scratch = snap;
+    ctx->state_valid = true;
+    return 0;
+}
+
+int clap_state_save(clap_instance_t *inst, uint8_t **data, size_t *len) {
+    if (!inst || !inst->plugin || !data || !len) return -1;
+    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
+    const char *id = plugin->desc->id;
+    size_t id_len = strlen(id);
+
+    pthread_mutex_lock(&s_loop_mutex);
+    clap_instance_host_t *ctx = inst->host;
+    /* Save now only if no snapshot is current - a sandboxed plugin marks itself dirty
+       in the child, so it is always asked */
+    if ((__atomic_exchange_n(&ctx->state_dirty, 0, __ATOMIC_ACQ_REL) || !ctx->state_valid || inst->sandbox) &&
+        state_snapshot(inst) != 0) {
+        pthread_mutex_unlock(&s_loop_mutex);
+        return -1;
+    }
+
+    state_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = STATE_MAGIC;
+    header.version = STATE_VERSION;
+    header.id_len = (uint16_t)id_len;
+    header.state_len = (uint32_t)ctx->state_snap.len;
+    size_t total = sizeof(header) + id_len + ctx->state_snap.len;
+    uint8_t *blob = (uint8_t *)malloc(total);
+    if (blob) {
+        memcpy(blob, &header, sizeof(header));
+        memcpy(blob + sizeof(header), id, id_len);
+        memcpy(blob + sizeof(header) + id_len, ctx->state_snap.data, ctx->state_snap.len);
+    }
+    pthread_mutex_unlock(&s_loop_mutex);
+
+    if (!blob) return -1;
+    *data = blob;
+    *len = total;
+    return 0;
+}
+
+int clap_state_load(clap_instance_t *inst, const uint8_t *data, size_t len) {
+    if (!inst || !inst->plugin || !data) return -1;
+    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
+    const clap_plugin_state_t *state = state_ext(plugin);
+
+    state_header_t header;
+    if (!state || len < sizeof(header)) return -1;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != STATE_MAGIC || header.version != STATE_VERSION ||
+        len != sizeof(header) + header.id_len + header.state_len) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "not a state blob");
+        return -1;
+    }
+    const char *id = plugin->desc->id;
+    if (strlen(id) != header.id_len || memcmp(data + sizeof(header), id, header.id_len) != 0) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "state blob is for another plugin");
+        return -1;
+    }
+
+    state_buf_t buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.data = (uint8_t *)(data + sizeof(header) + header.id_len);
+    buf.len = header.state_len;
+    clap_istream_t stream = { &buf, state_istream_read };
+
+    pthread_mutex_lock(&s_loop_mutex);
+    bool ok = state->load(plugin, &stream);
+    inst->host->state_valid = false;
+    pthread_mutex_unlock(&s_loop_mutex);
+    if (!ok) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "state load failed for %s", inst->path);
+        return -1;
+    }
+
+    /* Every value may have changed - re-read them into the param table */
+    __atomic_add_fetch(&inst->host->params_gen, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/* Helper: FNV-1a, names state files after their contents */
+static uint64_t state_hash(const uint8_t *data, size_t len) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+int clap_state_write_file(clap_instance_t *inst, const char *dir, char *path, int path_len) {
+    uint8_t *blob;
+    size_t len;
+    if (!dir || !path || path_len <= 0 || clap_state_save(inst, &blob, &len) != 0) return -1;
+
+    /* Same state, same file - nothing to write if it already exists */
+    mkdir(dir, 0755);
+    int n = snprintf(path, path_len, "%s/%016llx" STATE_FILE_EXT, dir,
+                     (unsigned long long)state_hash(blob, len));
+    if (n < 0 || n >= path_len) {
+        free(blob);
+        return -1;
+    }
+    int rc = 0;
+    if (access(path, F_OK) != 0) {
+        char tmp[PATH_MAX];
+        n = snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+        if (n < 0 || n >= (int)sizeof(tmp)) {
+            free(blob);
+            return -1;
+        }
+        FILE *f = fopen(tmp, "wb");
+        rc = f && fwrite(blob, 1, len, f) == len ? 0 : -1;
+        if (f && fclose(f) != 0) rc = -1;
+        if (rc == 0 && rename(tmp, path) != 0) rc = -1;
+        if (rc != 0) {
+            HOST_LOG(CLAP_HOST_LOG_ERROR, "cannot write %s", path);
+            unlink(tmp);
+        }
+    }
+    free(blob);
+    return rc;
+}
+
+int clap_state_read_file(clap_instance_t *inst, const char *path) {
+    FILE *f = path ? fopen(path, "rb") : NULL;
+    if (!f) return -1;
+    uint8_t *blob = NULL;
+    long len = -1;
+    if (fseek(f, 0, SEEK_END) == 0 && (len = ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0) {
+        blob = (uint8_t *)malloc((size_t)len);
+        if (blob && fread(blob, 1, (size_t)len, f) != (size_t)len) len = -1;
+    }
+    fclose(f);
+    int rc = blob && len > 0 ? clap_state_load(inst, blob, (size_t)len) : -1;
+    free(blob);
+    return rc;
+}
+
+/*
+ * Preset catalog (preset-discovery factory)
+ *
+ * A background thread asks the bundle's preset providers for every preset of the
+ * instance's plugin and writes a compact index file: header, fixed-size entries, then a
+ * string pool. The file is memory-mapped and reused until the bundle's mtime changes,
+ * so stepping through presets is an array lookup plus one preset-load call.
+ */
+#define PRESET_MAGIC 0x49504c43u         /* "CLPI" */
+#define PRESET_VERSION 1
+#define PRESET_FILE_EXT ".clappresets"
+#define PRESET_NO_STRING UINT32_MAX
+#define PRESET_MAX_LOCATIONS 32
+#define PRESET_MAX_FILETYPES 16
+#define PRESET_MAX_DEPTH 8               /* Directory levels crawled below a location */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t bundle_mtime;
+    uint32_t count;
+    uint32_t size;                   /* Whole file, checked against the mapping */
+} preset_file_header_t;
+
+typedef struct {
+    uint32_t name;                   /* String pool offsets, PRESET_NO_STRING = none */
+    uint32_t location;
+    uint32_t load_key;
+    uint32_t kind;                   /* clap_preset_discovery_location_kind */
+    uint32_t flags;                  /* clap_preset_discovery_flags */
+} preset_file_entry_t;
+
+typedef struct clap_preset_index {
+    const clap_plugin_entry_t *entry;
+    char plugin_id[256];
+    char file[1024];
+    int64_t mtime;
+    pthread_t thread;
+    bool thread_started;
+    int stop;
+    const uint8_t *map;              /* Published by the indexing thread, NULL until ready */
+    size_t map_size;
+    int current;                     /* Last preset loaded, -1 = none */
+} clap_preset_index_t;
+
+/* Crawl state shared by the indexer and metadata receiver callbacks */
+typedef struct {
+    clap_preset_index_t *index;
+    state_buf_t entries;
+    state_buf_t strings;
+    clap_preset_discovery_location_t locations[PRESET_MAX_LOCATIONS];
+    int location_count;
+    char *filetypes[PRESET_MAX_FILETYPES];   /* Extensions without the dot */
+    int filetype_count;
+    uint32_t kind;                   /* Location being crawled */
+    const char *location;
+    bool open;                       /* A preset is being described */
+    bool matches;                    /* It names our plugin (or no plugin at all) */
+    bool any_id;
+    preset_file_entry_t cur;
+} preset_crawl_t;
+
+static uint32_t preset_add_string(preset_crawl_t *crawl, const char *str) {
+    if (!str) return PRESET_NO_STRING;
+    uint32_t offset = (uint32_t)crawl->strings.len;
+    size_t len = strlen(str) + 1;
+    if (!state_buf_reserve(&crawl->strings, len)) return PRESET_NO_STRING;
+    memcpy(crawl->strings.data + crawl->strings.len, str, len);
+    crawl->strings.len += len;
+    return offset;
+}
+
+/* Helper: keep the preset being described if it is for our plugin */
+static void preset_close(preset_crawl_t *crawl) {
+    if (!crawl->open) return;
+    crawl->open = false;
+    if (!crawl->matches && crawl->any_id) return;
+    if (!state_buf_reserve(&crawl->entries, sizeof(preset_file_entry_t))) return;
+    memcpy(crawl->entries.data + crawl->entries.len, &crawl->cur, sizeof(preset_file_entry_t));
+    crawl->entries.len += sizeof(preset_file_entry_t);
+}
+
+static void preset_on_error(const clap_preset_discovery_metadata_receiver_t *receiver,
+                            int32_t os_error, const char *error_message) {
+    HOST_LOG(CLAP_HOST_LOG_WARN, "preset discovery: %s", error_message ? error_message : "error");
+}
+
+static bool preset_begin(const clap_preset_discovery_metadata_receiver_t *receiver,
+                         const char *name, const char *load_key) {
+    preset_crawl_t *crawl = (preset_crawl_t *)receiver->receiver_data;
+    preset_close(crawl);
+    if (__atomic_load_n(&crawl->index->stop, __ATOMIC_ACQUIRE)) return false;
+    crawl->open = true;
+    crawl->matches = false;
+    crawl->any_id = false;
+    crawl->cur.name = preset_add_string(crawl, name ? name : "");
+    crawl->cur.location = preset_add_string(crawl, crawl->location);
+    crawl->cur.load_key = preset_add_string(crawl, load_key);
+    crawl->cur.kind = crawl->kind;
+    crawl->cur.flags = 0;
+    return true;
+}
+
+static void preset_add_plugin_id(const clap_preset_discovery_metadata_receiver_t *receiver,
+                                 const clap_universal_plugin_id_t *plugin_id) {
+    preset_crawl_t *crawl = (preset_crawl_t *)receiver->receiver_data;
+    crawl->any_id = true;
+    if (plugin_id && plugin_id->abi && plugin_id->id && !strcmp(plugin_id->abi, "clap") &&
+        !strcmp(plugin_id->id, crawl->index->plugin_id)) {
+        crawl->matches = true;
+    }
+}
+
+static void preset_set_flags(const clap_preset_discovery_metadata_receiver_t *receiver, uint32_t flags) {
+    preset_crawl_t *crawl = (preset_crawl_t *)receiver->receiver_data;
+    crawl->cur.flags = flags;
+}
+
+/* Metadata the index doesn't keep */
+static void preset_ignore_string(const clap_preset_discovery_metadata_receiver_t *receiver, const char *str) {}
+static void preset_ignore_timestamps(const clap_preset_discovery_metadata_receiver_t *receiver,
+                                     clap_timestamp creation_time, clap_timestamp modification_time) {}
+static void preset_ignore_extra_info(const clap_preset_discovery_metadata_receiver_t *receiver,
+                                     const char *key, const char *value) {}
+
+static bool preset_declare_filetype(const clap_preset_discovery_indexer_t *indexer,
+                                    const clap_preset_discovery_filetype_t *filetype) {
+    preset_crawl_t *crawl = (preset_crawl_t *)indexer->indexer_data;
+    if (!filetype || crawl->filetype_count >= PRESET_MAX_FILETYPES) return false;
+    const char *ext = filetype->file_extension ? filetype->file_extension : "";
+    if (*ext == '.') ext++;
+    crawl->filetypes[crawl->filetype_count++] = strdup(ext);
+    return true;
+}
+
+static bool preset_declare_location(const clap_preset_discovery_indexer_t *indexer,
+                                    const clap_preset_discovery_location_t *location) {
+    preset_crawl_t *crawl = (preset_crawl_t *)indexer->indexer_data;
+    if (!location || crawl->location_count >= PRESET_MAX_LOCATIONS) return false;
+    clap_preset_discovery_location_t *copy = &crawl->locations[crawl->location_count++];
+    copy->flags = location->flags;
+    copy->name = strdup(location->name ? location->name : "");
+    copy->kind = location->kind;
+    copy->location = location->location ? strdup(location->location) : NULL;
+    return true;
+}
+
+static bool preset_declare_soundpack(const clap_preset_discovery_indexer_t *indexer,
+                                     const clap_preset_discovery_soundpack_t *soundpack) {
+    return true;
+}
+
+static const void *preset_indexer_get_extension(const clap_preset_discovery_indexer_t *indexer,
+                                                const char *extension_id) {
+    return NULL;
+}
+
+/* Helper: does a file have one of the declared extensions (any file if none were declared) */
+static bool preset_filetype_matches(preset_crawl_t *crawl, const char *name) {
+    if (crawl->filetype_count == 0) return true;
+    const char *dot = strrchr(name, '.');
+    for (int i = 0; i < crawl->filetype_count; i++) {
+        if (crawl->filetypes[i][0] == '\0') return true;
+        if (dot && !strcmp(dot + 1, crawl->filetypes[i])) return true;
+    }
+    return false;
+}
+
+static void preset_crawl_path(preset_crawl_t *crawl, const clap_preset_discovery_provider_t *provider,
+                              const clap_preset_discovery_metadata_receiver_t *receiver,
+                              const char *path, int depth) {
+    if (__atomic_load_n(&crawl->index->stop, __ATOMIC_ACQUIRE)) return;
+    struct stat st;
+    if (stat(path, &st) != 0) return;
+    if (!S_ISDIR(st.st_mode)) {
+        crawl->location = path;
+        provider->get_metadata(provider, CLAP_PRESET_DISCOVERY_LOCATION_FILE, path, receiver);
+        preset_close(crawl);
+        return;
+    }
+    if (depth >= PRESET_MAX_DEPTH) return;
+    DIR *dir = opendir(path);
+    if (!dir) return;
+    struct dirent *de;
+    char child[1024];
+    while ((de = readdir(dir)) != NULL) {
+        if (de->d_name[0] == '.') continue;
+        snprintf(child, sizeof(child), "%s/%s", path, de->d_name);
+        if (de->d_type == DT_REG && !preset_filetype_matches(crawl, de->d_name)) continue;
+        preset_crawl_path(crawl, provider, receiver, child, depth + 1);
+    }
+    closedir(dir);
+}
+
+/* Helper: map an index file, only if it is valid and was built from this bundle version */
+static int preset_map(clap_preset_index_t *index) {
+    int fd = open(index->file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(preset_file_header_t)) {
+        map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const preset_file_header_t *header = (const preset_file_header_t *)map;
+    size_t pool = sizeof(*header) + (size_t)header->count * sizeof(preset_file_entry_t);
+    bool valid = header->magic == PRESET_MAGIC && header->version == PRESET_VERSION &&
+                 header->bundle_mtime == index->mtime && header->size == (uint32_t)st.st_size &&
+                 pool <= (size_t)st.st_size;
+    if (valid) {
+        /* Every string must start inside the pool, and the pool must end in a NUL */
+        size_t pool_size = (size_t)st.st_size - pool;
+        const preset_file_entry_t *entries = (const preset_file_entry_t *)((const uint8_t *)map + sizeof(*header));
+        if (pool_size > 0 && ((const char *)map)[st.st_size - 1] != '\0') valid = false;
+        for (uint32_t i = 0; i < header->count && valid; i++) {
+            const preset_file_entry_t *e = &entries[i];
+            if ((e->name != PRESET_NO_STRING && e->name >= pool_size) ||
+                (e->location != PRESET_NO_STRING && e->location >= pool_size) ||
+                (e->load_key != PRESET_NO_STRING && e->load_key >= pool_size)) valid = false;
+        }
+    }
+    if (!valid) {
+        munmap(map, (size_t)st.st_size);
+        return -1;
+    }
+    index->map_size = (size_t)st.st_size;
+    __atomic_store_n(&index->map, (const uint8_t *)map, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static int preset_write(clap_preset_index_t *index, preset_crawl_t *crawl) {
+    preset_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = PRESET_MAGIC;
+    header.version = PRESET_VERSION;
+    header.bundle_mtime = index->mtime;
+    header.count = (uint32_t)(crawl->entries.len / sizeof(preset_file_entry_t));
+    header.size = (uint32_t)(sizeof(header) + crawl->entries.len + crawl->strings.len);
+
+    char tmp[1100];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", index->file);
+    FILE *f = fopen(tmp, "wb");
+    int rc = f &&
+        fwrite(&header, sizeof(header), 1, f) == 1 &&
+        (crawl->entries.len == 0 || fwrite(crawl->entries.data, crawl->entries.len, 1, f) == 1) &&
+        (crawl->strings.len == 0 || fwrite(crawl->strings.data, crawl->strings.len, 1, f) == 1) ? 0 : -1;
+    if (f && fclose(f) != 0) rc = -1;
+    if (rc == 0 && rename(tmp, index->file) != 0) rc = -1;
+    if (rc != 0) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "cannot write preset index %s", index->file);
+        unlink(tmp);
+    }
+    return rc;
+}
+
+static void *preset_index_thread(void *arg) {
+    clap_preset_index_t *index = (clap_preset_index_t *)arg;
+    const clap_preset_discovery_factory_t *factory =
+        (const clap_preset_discovery_factory_t *)index->entry->get_factory(CLAP_PRESET_DISCOVERY_FACTORY_ID);
+    if (!factory) {
+        factory = (const clap_preset_discovery_factory_t *)
+            index->entry->get_factory(CLAP_PRESET_DISCOVERY_FACTORY_ID_COMPAT);
+    }
+
+    preset_crawl_t crawl;
+    memset(&crawl, 0, sizeof(crawl));
+    crawl.index = index;
+
+    clap_preset_discovery_indexer_t indexer;
+    memset(&indexer, 0, sizeof(indexer));
+    indexer.clap_version = CLAP_VERSION;
+    indexer.name = s_host.name;
+    indexer.vendor = s_host.vendor;
+    indexer.url = s_host.url;
+    indexer.version = s_host.version;
+    indexer.indexer_data = &crawl;
+    indexer.declare_filetype = preset_declare_filetype;
+    indexer.declare_location = preset_declare_location;
+    indexer.declare_soundpack = preset_declare_soundpack;
+    indexer.get_extension = preset_indexer_get_extension;
+
+    clap_preset_discovery_metadata_receiver_t receiver;
+    memset(&receiver, 0, sizeof(receiver));
+    receiver.receiver_data = &crawl;
+    receiver.on_error = preset_on_error;
+    receiver.begin_preset = preset_begin;
+    receiver.add_plugin_id = preset_add_plugin_id;
+    receiver.set_soundpack_id = preset_ignore_string;
+    receiver.set_flags = preset_set_flags;
+    receiver.add_creator = preset_ignore_string;
+    receiver.set_description = preset_ignore_string;
+    receiver.set_timestamps = preset_ignore_timestamps;
+    receiver.add_feature = preset_ignore_string;
+    receiver.add_extra_info = preset_ignore_extra_info;
+
+    /* Every provider in the bundle; presets for other plugins are dropped */
+    uint32_t providers = factory ? factory->count(factory) : 0;
+    for (uint32_t p = 0; p < providers && !__atomic_load_n(&index->stop, __ATOMIC_ACQUIRE); p++) {
+        const clap_preset_discovery_provider_descriptor_t *desc = factory->get_descriptor(factory, p);
+        const clap_preset_discovery_provider_t *provider =
+            desc ? factory->create(factory, &indexer, desc->id) : NULL;
+        if (!provider) continue;
+        int first = crawl.location_count;
+        if (provider->init(provider)) {
+            for (int l = first; l < crawl.location_count; l++) {
+                const clap_preset_discovery_location_t *loc = &crawl.locations[l];
+                if (loc->kind == CLAP_PRESET_DISCOVERY_LOCATION_PLUGIN) {
+                    crawl.kind = loc->kind;
+                    crawl.location = NULL;
+                    provider->get_metadata(provider, loc->kind, NULL, &receiver);
+                    preset_close(&crawl);
+                } else if (loc->location) {
+                    crawl.kind = CLAP_PRESET_DISCOVERY_LOCATION_FILE;
+                    preset_crawl_path(&crawl, provider, &receiver, loc->location, 0);
+                }
+            }
+        }
+        provider->destroy(provider);
+    }
+
+    if (!__atomic_load_n(&index->stop, __ATOMIC_ACQUIRE) && preset_write(index, &crawl) == 0) {
+        preset_map(index);
+        HOST_LOG(CLAP_HOST_LOG_INFO, "Indexed %u presets for %s",
+                (unsigned)(crawl.entries.len / sizeof(preset_file_entry_t)), index->plugin_id);
+    }
+
+    for (int i = 0; i < crawl.location_count; i++) {
+        free((void *)crawl.locations[i].name);
+        free((void *)crawl.locations[i].location);
+    }
+    for (int i = 0; i < crawl.filetype_count; i++) free(crawl.filetypes[i]);
+    free(crawl.entries.data);
+    free(crawl.strings.data);
+    return NULL;
+}
+
+static void preset_index_free(clap_instance_t *inst) {
+    clap_preset_index_t *index = inst->presets;
+    if (!index) return;
+    if (index->thread_started) {
+        __atomic_store_n(&index->stop, 1, __ATOMIC_RELEASE);
+        pthread_join(index->thread, NULL);
+    }
+    if (index->map) munmap((void *)index->map, index->map_size);
+    free(index);
+    inst->presets = NULL;
+}
+
+int clap_presets_index(clap_instance_t *inst, const char *cache_dir) {
+    if (!inst || !inst->plugin || !inst->entry || !cache_dir) return -1;
+    const clap_plugin_entry_t *entry = (const clap_plugin_entry_t *)inst->entry;
+    if (!entry->get_factory(CLAP_PRESET_DISCOVERY_FACTORY_ID) &&
+        !entry->get_factory(CLAP_PRESET_DISCOVERY_FACTORY_ID_COMPAT)) {
+        return -1;
+    }
+    struct stat st;
+    if (stat(inst->path, &st) != 0) return -1;
+
+    preset_index_free(inst);
+    clap_preset_index_t *index = (clap_preset_index_t *)calloc(1, sizeof(clap_preset_index_t));
+    if (!index) return -1;
     const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
-    const clap_plugin_params_t *params =
-        (const clap_plugin_params_t *)plugin->get_extension(plugin, CLAP_EXT_PARAMS);
-    if (!params) return 0;
+    index->entry = entry;
+    snprintf(index->plugin_id, sizeof(index->plugin_id), "%s", plugin->desc->id);
+    index->mtime = (int64_t)st.st_mtime;
+    index->current = -1;
 
-    return params->count(plugin);
+    /* One file per plugin, named after the bundle path and plugin id */
+    char key[1400];
+    int key_len = snprintf(key, sizeof(key), "%s|%s", inst->path, index->plugin_id);
+    mkdir(cache_dir, 0755);
+    snprintf(index->file, sizeof(index->file), "%s/%016llx" PRESET_FILE_EXT, cache_dir,
+             (unsigned long long)state_hash((const uint8_t *)key, (size_t)key_len));
+    inst->presets = index;
+
+    if (preset_map(index) == 0) return 0;
+    if (pthread_create(&index->thread, NULL, preset_index_thread, index) != 0) {
+        preset_index_free(inst);
+        return -1;
+    }
+    index->thread_started = true;
+    return 0;
 }
 
-int clap_param_info(clap_instance_t *inst, int index, char *name, int name_len, double *min, double *max, double *def) {
-    if (!inst->plugin) return -1;
+/* Helper: entry at index in the published map, NULL if not indexed (yet) or out of range */
+static const preset_file_entry_t *preset_entry(clap_instance_t *inst, int i, const char **pool) {
+    if (!inst || !inst->presets || i < 0) return NULL;
+    const uint8_t *map = __atomic_load_n(&inst->presets->map, __ATOMIC_ACQUIRE);
+    if (!map) return NULL;
+    const preset_file_header_t *header = (const preset_file_header_t *)map;
+    if ((uint32_t)i >= header->count) return NULL;
+    *pool = (const char *)(map + sizeof(*header) + header->count * sizeof(preset_file_entry_t));
+    return (const preset_file_entry_t *)(map + sizeof(*header)) + i;
+}
 
-    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
-    const clap_plugin_params_t *params =
-        (const clap_plugin_params_t *)plugin->get_extension(plugin, CLAP_EXT_PARAMS);
-    if (!params) return -1;
+int clap_preset_count(clap_instance_t *inst) {
+    if (!inst || !inst->presets) return 0;
+    const uint8_t *map = __atomic_load_n(&inst->presets->map, __ATOMIC_ACQUIRE);
+    return map ? (int)((const preset_file_header_t *)map)->count : 0;
+}
 
-    clap_param_info_t info;
-    if (!params->get_info(plugin, index, &info)) return -1;
+int clap_preset_name(clap_instance_t *inst, int index, char *buf, int buf_len) {
+    const char *pool;
+    const preset_file_entry_t *e = preset_entry(inst, index, &pool);
+    if (!e || !buf || buf_len <= 0) return -1;
+    return snprintf(buf, buf_len, "%s", e->name != PRESET_NO_STRING ? pool + e->name : "");
+}
 
-    if (name && name_len > 0) {
-        strncpy(name, info.name, name_len - 1);
-        name[name_len - 1] = '\0';
+int clap_preset_current(clap_instance_t *inst) {
+    return inst && inst->presets ? inst->presets->current : -1;
+}
+
+int clap_preset_load(clap_instance_t *inst, int index) {
+    const char *pool;
+    const preset_file_entry_t *e = preset_entry(inst, index, &pool);
+    if (!e) return -1;
+    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
+    const clap_plugin_preset_load_t *load =
+        (const clap_plugin_preset_load_t *)plugin->get_extension(plugin, CLAP_EXT_PRESET_LOAD);
+    if (!load) {
+        load = (const clap_plugin_preset_load_t *)plugin->get_extension(plugin, CLAP_EXT_PRESET_LOAD_COMPAT);
     }
-    if (min) *min = info.min_value;
-    if (max) *max = info.max_value;
-    if (def) *def = info.default_value;
+    if (!load) return -1;
+
+    pthread_mutex_lock(&s_loop_mutex);
+    bool ok = load->from_location(plugin, e->kind,
+                                  e->location != PRESET_NO_STRING ? pool + e->location : NULL,
+                                  e->load_key != PRESET_NO_STRING ? pool + e->load_key : NULL);
+    inst->host->state_valid = false;
+    pthread_mutex_unlock(&s_loop_mutex);
+    if (!ok) return -1;
 
+    inst->presets->current = index;
+    __atomic_add_fetch(&inst->host->params_gen, 1, __ATOMIC_RELEASE);
     return 0;
 }
 
-int clap_param_set(clap_instance_t *inst, int index, double value) {
-    if (!inst || !inst->plugin) return -1;
+/*
+ * Sandboxed hosting - the plugin runs in a child process (clap_sandbox_child_main) so a
+ * crash takes down the child, not the audio process. The instance drives a proxy plugin
+ * whose process() hands the block to the child through shared memory and waits for it
+ * with a futex, within a deadline. A supervisor thread restarts a dead or hung child,
+ * which reloads the state it last saved into the shared memory; blocks in between and
+ * blocks that miss their deadline pass the input through. One block is with the child
+ * at a time: until a late one is answered, later blocks pass through and their events
+ * are held back for the next block the child gets.
+ */
+#define SANDBOX_MAGIC 0x42534c43u         /* "CLSB" */
+#define SANDBOX_MAX_FRAMES HOST_MAX_FRAMES
+#define SANDBOX_MAX_EVENTS 256
+#define SANDBOX_MAX_PARAMS 1024
+#define SANDBOX_STATE_MAX (1 << 20)
+#define SANDBOX_SPIN_NS 20000             /* Spin before sleeping on the futex */
+#define SANDBOX_DEADLINE_PERCENT 80       /* Share of the block the child gets */
+#define SANDBOX_START_TIMEOUT_MS 5000
+#define SANDBOX_HANG_MS 500               /* No answer for this long with a block pending = hung child */
+#define SANDBOX_STATE_INTERVAL_MS 1000
+#define SANDBOX_STATE_TIMEOUT_MS 2000      /* For a state save/load the proxy asks the child for */
+#define SANDBOX_RESTART_DELAY_MS 100
+#define SANDBOX_POLL_MS 10
+
+typedef struct {
+    uint32_t index;
+    double value;
+} sandbox_param_t;
+
+typedef struct {
+    char name[CLAP_NAME_SIZE];
+    char module[CLAP_NAME_SIZE];     /* Module path, truncated - enough for navigation */
+    uint32_t flags;
+    double min, max, def;
+} sandbox_param_info_t;
+
+/* A voice the child's plugin finished, forwarded as CLAP_EVENT_NOTE_END */
+typedef struct {
+    uint8_t channel;
+    uint8_t key;
+} sandbox_note_t;
+
+/* State requests from the proxy */
+#define SANDBOX_STATE_SAVE 0
+#define SANDBOX_STATE_LOAD 1
+
+/* One block in flight - written by the parent, answered by the child */
+typedef struct {
+    int frames;                      /* 0 = events only (params flush) */
+    uint32_t midi_count;
+    uint32_t param_count;
+    uint32_t midi_out_count;
+    uint32_t param_out_count;
+    uint32_t note_end_count;
+    uint64_t process_ns;             /* Child-side time, the rest of the round trip is IPC */
+    midi_event_t midi[SANDBOX_MAX_EVENTS];
+    sandbox_param_t params[SANDBOX_MAX_EVENTS];
+    midi_event_t midi_out[SANDBOX_MAX_EVENTS];
+    sandbox_param_t params_out[SANDBOX_MAX_EVENTS];
+    sandbox_note_t note_ends[SANDBOX_MAX_EVENTS];
+    float in[SANDBOX_MAX_FRAMES * 2];    /* Interleaved stereo */
+    float out[SANDBOX_MAX_FRAMES * 2];
+} sandbox_slot_t;
+
+typedef struct {
+    uint32_t magic;
+    int parent_pid;
+    /* Plugin and audio config, written by the parent */
+    char path[1024];
+    int plugin_index;
+    int config_seq;                  /* Bumped when the parent re-activates */
+    double sample_rate;
+    int max_frames;
+    /* futex words */
+    int ready;                       /* Generation of the child that finished loading, -1 = load failed */
+    int quit;
+    int req_seq;                     /* Last block requested */
+    int ack_seq;                     /* Last block answered */
+    /* Plugin description, written by the child once loaded */
+    char plugin_id[CLAP_NAME_SIZE];  /* The proxy's descriptor reports these */
+    char plugin_name[CLAP_NAME_SIZE];
+    int has_input;
+    uint32_t latency;
+    uint32_t param_count;
+    sandbox_param_info_t param_info[SANDBOX_MAX_PARAMS];
+    double param_values[SANDBOX_MAX_PARAMS];
+    /* Last saved plugin state, loaded by a restarted child */
+    int state_slot;                  /* -1 = none yet */
+    uint32_t state_len[2];
+    uint8_t state[2][SANDBOX_STATE_MAX];
+    /* State save/load for the proxy's state extension, served by the child's main thread */
+    int state_req;                   /* futex: bumped per request */
+    int state_ack;                   /* futex: last request served */
+    int state_cmd;                   /* SANDBOX_STATE_* */
+    int state_ok;
+    uint32_t state_io_len;
+    uint8_t state_io[SANDBOX_STATE_MAX];
+    /* The block in flight - the parent only refills it once ack_seq == req_seq */
+    sandbox_slot_t slot;
+} sandbox_shm_t;
+
+typedef struct clap_sandbox {
+    clap_plugin_t proxy;
+    clap_plugin_descriptor_t desc;   /* The sandboxed plugin's id and name */
+    sandbox_shm_t *shm;
+    int shm_fd;
+    char helper[1024];
+    pthread_t supervisor;
+    int pid;
+    int gen;                         /* Children spawned */
+    int alive;                       /* Current child is loaded and serving blocks */
+    int stop;
+    int restarts;
+    int seq;                         /* Audio thread: last block sent */
+    bool late;                       /* Audio thread: that block missed its deadline, outputs not forwarded yet */
+    /* Audio thread: events waiting for the next block the child gets */
+    uint32_t pending_midi_count;
+    uint32_t pending_param_count;
+    midi_event_t pending_midi[SANDBOX_MAX_EVENTS];
+    sandbox_param_t pending_params[SANDBOX_MAX_EVENTS];
+    uint64_t ipc_ns;                 /* Round trip minus child time, smoothed */
+    uint32_t missed;                 /* Blocks passed through on a missed deadline */
+} clap_sandbox_t;
+
+static void futex_wait_shared(int *addr, int val, uint64_t timeout_ns) {
+    struct timespec ts = { (time_t)(timeout_ns / 1000000000ULL), (long)(timeout_ns % 1000000000ULL) };
+    syscall(SYS_futex, addr, FUTEX_WAIT, val, timeout_ns ? &ts : NULL, NULL, 0);
+}
+
+static void futex_wake_shared(int *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+}
+
+/* Helper: wait until *addr moves off val, spinning first - false once deadline_ns passes */
+static bool sandbox_wait(int *addr, int val, uint64_t deadline_ns) {
+    uint64_t t = now_ns();
+    uint64_t spin_end = t + SANDBOX_SPIN_NS;
+    while (__atomic_load_n(addr, __ATOMIC_ACQUIRE) == val) {
+        t = now_ns();
+        if (deadline_ns && t >= deadline_ns) return false;
+        if (t < spin_end) {
+            sched_yield();
+            continue;
+        }
+        futex_wait_shared(addr, val, deadline_ns ? deadline_ns - t : 0);
+    }
+    return true;
+}
+
+/* ---- Child side ---- */
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t len;
+    uint32_t cap;
+} sandbox_stream_t;
 
+static int64_t sandbox_ostream_write(const clap_ostream_t *stream, const void *buffer, uint64_t size) {
+    sandbox_stream_t *s = (sandbox_stream_t *)stream->ctx;
+    if (size > s->cap - s->len) return -1;
+    memcpy(s->buf + s->len, buffer, size);
+    s->len += (uint32_t)size;
+    return (int64_t)size;
+}
+
+static int64_t sandbox_istream_read(const clap_istream_t *stream, void *buffer, uint64_t size) {
+    sandbox_stream_t *s = (sandbox_stream_t *)stream->ctx;
+    uint64_t n = s->cap - s->len < size ? s->cap - s->len : size;
+    memcpy(buffer, s->buf + s->len, n);
+    s->len += (uint32_t)n;
+    return (int64_t)n;
+}
+
+/* Save the plugin state into the slot not holding the latest copy, then publish it */
+static void sandbox_state_save(sandbox_shm_t *shm, const clap_plugin_t *plugin) {
+    const clap_plugin_state_t *state =
+        (const clap_plugin_state_t *)plugin->get_extension(plugin, CLAP_EXT_STATE);
+    if (!state) return;
+
+    int slot = __atomic_load_n(&shm->state_slot, __ATOMIC_RELAXED) == 0 ? 1 : 0;
+    sandbox_stream_t s = { shm->state[slot], 0, SANDBOX_STATE_MAX };
+    clap_ostream_t stream = { &s, sandbox_ostream_write };
+    /* Not concurrently with the child's own main loop snapshotting it */
+    pthread_mutex_lock(&s_loop_mutex);
+    bool ok = state->save(plugin, &stream);
+    pthread_mutex_unlock(&s_loop_mutex);
+    if (!ok) return;
+    shm->state_len[slot] = s.len;
+    __atomic_store_n(&shm->state_slot, slot, __ATOMIC_RELEASE);
+}
+
+static void sandbox_state_load(sandbox_shm_t *shm, const clap_plugin_t *plugin) {
+    int slot = __atomic_load_n(&shm->state_slot, __ATOMIC_ACQUIRE);
+    const clap_plugin_state_t *state =
+        (const clap_plugin_state_t *)plugin->get_extension(plugin, CLAP_EXT_STATE);
+    if (slot < 0 || !state) return;
+
+    sandbox_stream_t s = { shm->state[slot], 0, shm->state_len[slot] };
+    clap_istream_t stream = { &s, sandbox_istream_read };
+    if (!state->load(plugin, &stream)) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "sandbox: saved state did not load");
+    }
+}
+
+/* Serve a state request from the proxy through state_io (child main thread) */
+static bool sandbox_state_serve(sandbox_shm_t *shm, clap_instance_t *inst) {
     const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
-    const clap_plugin_params_t *params =
-        (const clap_plugin_params_t *)plugin->get_extension(plugin, CLAP_EXT_PARAMS);
-    if (!params) return -1;
+    const clap_plugin_state_t *state = state_ext(plugin);
+    if (!state) return false;
 
-    /* Get param info to find the actual param_id */
-    clap_param_info_t info;
-    if (!params->get_info(plugin, index, &info)) return -1;
+    bool ok;
+    pthread_mutex_lock(&s_loop_mutex);
+    if (shm->state_cmd == SANDBOX_STATE_SAVE) {
+        sandbox_stream_t s = { shm->state_io, 0, SANDBOX_STATE_MAX };
+        clap_ostream_t stream = { &s, sandbox_ostream_write };
+        ok = state->save(plugin, &stream);
+        shm->state_io_len = ok ? s.len : 0;
+    } else {
+        sandbox_stream_t s = { shm->state_io, 0, shm->state_io_len };
+        clap_istream_t stream = { &s, sandbox_istream_read };
+        ok = state->load(plugin, &stream);
+        inst->host->state_valid = false;
 
-    /* Queue the param change for next process block */
-    if (inst->param_queue_count < CLAP_MAX_PARAM_CHANGES) {
-        inst->param_queue[inst->param_queue_count].param_id = info.id;
-        inst->param_queue[inst->param_queue_count].value = value;
-        inst->param_queue_count++;
+        /* The proxy re-reads its values once the load returns - publish them first */
+        const clap_plugin_params_t *params =
+            (const clap_plugin_params_t *)plugin->get_extension(plugin, CLAP_EXT_PARAMS);
+        for (uint32_t i = 0; ok && params && i < shm->param_count; i++) {
+            clap_param_info_t info;
+            double v;
+            if (params->get_info(plugin, i, &info) && params->get_value(plugin, info.id, &v)) {
+                __atomic_store(&shm->param_values[i], &v, __ATOMIC_RELAXED);
+            }
+        }
+    }
+    pthread_mutex_unlock(&s_loop_mutex);
+    if (ok && shm->state_cmd == SANDBOX_STATE_LOAD) {
+        __atomic_add_fetch(&inst->host->params_gen, 1, __ATOMIC_RELEASE);
+    }
+    return ok;
+}
+
+typedef struct {
+    sandbox_shm_t *shm;
+    clap_instance_t *inst;
+} sandbox_child_t;
+
+/* Child audio thread - answer blocks until told to quit */
+static void *sandbox_child_audio(void *arg) {
+    sandbox_child_t *child = (sandbox_child_t *)arg;
+    sandbox_shm_t *shm = child->shm;
+    clap_instance_t *inst = child->inst;
+    int config_seq = __atomic_load_n(&shm->config_seq, __ATOMIC_ACQUIRE);
+    int seen = __atomic_load_n(&shm->req_seq, __ATOMIC_ACQUIRE);
+    uint32_t count = shm->param_count;
+
+    /* Run at the parent's audio priority where allowed */
+    struct sched_param sp;
+    sp.sched_priority = sched_get_priority_max(SCHED_FIFO) - HOST_POOL_PRIORITY_BELOW_MAX + 1;
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+
+    for (;;) {
+        uint64_t spin_end = now_ns() + SANDBOX_SPIN_NS;
+        while (__atomic_load_n(&shm->req_seq, __ATOMIC_ACQUIRE) == seen &&
+               !__atomic_load_n(&shm->quit, __ATOMIC_ACQUIRE)) {
+            if (now_ns() < spin_end) sched_yield();
+            else futex_wait_shared(&shm->req_seq, seen, 0);
+        }
+        if (__atomic_load_n(&shm->quit, __ATOMIC_ACQUIRE)) break;
+
+        /* The parent waits for each answer before the next block, so none is skipped */
+        int seq = __atomic_load_n(&shm->req_seq, __ATOMIC_ACQUIRE);
+        seen = seq;
+        sandbox_slot_t *slot = &shm->slot;
+        uint64_t t0 = now_ns();
+
+        int cfg = __atomic_load_n(&shm->config_seq, __ATOMIC_ACQUIRE);
+        if (cfg != config_seq) {
+            config_seq = cfg;
+            clap_reconfigure(inst, shm->sample_rate, shm->max_frames);
+        }
+
+        /* Voices playing before the block or started in it - the ones that aren't
+           afterwards ended, and the parent's voice count hears about it */
+        uint64_t playing[HOST_VOICE_SLOTS / 64];
+        memcpy(playing, inst->events->voice_bits, sizeof(playing));
+        for (uint32_t i = 0; i < slot->midi_count; i++) {
+            const uint8_t *m = slot->midi[i].data;
+            if ((m[0] & 0xF0) == 0x90 && m[2]) {
+                int v = (m[0] & 0x0F) * 128 + (m[1] & 0x7F);
+                playing[v >> 6] |= 1ULL << (v & 63);
+            }
+            clap_send_midi(inst, slot->midi[i].data, slot->midi[i].len);
+        }
+        for (uint32_t i = 0; i < slot->param_count; i++) {
+            clap_param_set(inst, (int)slot->params[i].index, slot->params[i].value);
+        }
+        if (slot->frames > 0) {
+            clap_process_block(inst, shm->has_input ? slot->in : NULL, slot->out, slot->frames);
+        }
+
+        uint32_t n = 0;
+        for (int w = 0; w < HOST_VOICE_SLOTS / 64; w++) {
+            uint64_t ended = playing[w] & ~inst->events->voice_bits[w];
+            for (; ended && n < SANDBOX_MAX_EVENTS; ended &= ended - 1) {
+                int v = w * 64 + __builtin_ctzll(ended);
+                slot->note_ends[n].channel = (uint8_t)(v >> 7);
+                slot->note_ends[n++].key = (uint8_t)(v & 127);
+            }
+        }
+        slot->note_end_count = n;
+
+        uint8_t msg[3];
+        int len;
+        n = 0;
+        while (n < SANDBOX_MAX_EVENTS && (len = clap_midi_out_read(inst, msg)) > 0) {
+            memcpy(slot->midi_out[n].data, msg, 3);
+            slot->midi_out[n++].len = (uint8_t)len;
+        }
+        slot->midi_out_count = n;
+
+        /* Report values the plugin changed */
+        n = 0;
+        for (uint32_t i = 0; i < count && n < SANDBOX_MAX_EVENTS; i++) {
+            double v = clap_param_get(inst, (int)i), last;
+            __atomic_load(&shm->param_values[i], &last, __ATOMIC_RELAXED);
+            if (v == last) continue;
+            __atomic_store(&shm->param_values[i], &v, __ATOMIC_RELAXED);
+            slot->params_out[n].index = i;
+            slot->params_out[n++].value = v;
+        }
+        slot->param_out_count = n;
+
+        slot->process_ns = now_ns() - t0;
+        __atomic_store_n(&shm->ack_seq, seq, __ATOMIC_RELEASE);
+        futex_wake_shared(&shm->ack_seq);
+    }
+    return NULL;
+}
+
+int clap_sandbox_child_main(int argc, char **argv) {
+    if (argc < 4 || strcmp(argv[1], CLAP_SANDBOX_ARG) != 0) return 2;
+
+    /* Die with the parent's supervisor thread, and bail if it is already gone */
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    int fd = atoi(argv[2]);
+    int gen = atoi(argv[3]);
+    sandbox_shm_t *shm = (sandbox_shm_t *)mmap(NULL, sizeof(sandbox_shm_t), PROT_READ | PROT_WRITE,
+                                               MAP_SHARED, fd, 0);
+    if (shm == MAP_FAILED) return 2;
+    if (shm->magic != SANDBOX_MAGIC || getppid() != shm->parent_pid) return 2;
+
+    /* This thread is the plugin's main thread; the audio thread is started below */
+    host_record_main_thread();
+    /* Logs go through the writer thread like the parent's, to the stderr it inherited */
+    clap_log_open(NULL, 0, NULL);
+    clap_host_set_audio_config(shm->sample_rate, shm->max_frames);
+    clap_instance_t inst;
+    if (clap_load_plugin(shm->path, shm->plugin_index, &inst) != 0) {
+        __atomic_store_n(&shm->ready, -1, __ATOMIC_RELEASE);
+        futex_wake_shared(&shm->ready);
+        clap_log_close();
+        return 1;
     }
+    const clap_plugin_t *plugin = (const clap_plugin_t *)inst.plugin;
+    sandbox_state_load(shm, plugin);
 
+    /* Describe the plugin for the proxy */
+    snprintf(shm->plugin_id, sizeof(shm->plugin_id), "%s", plugin->desc->id);
+    snprintf(shm->plugin_name, sizeof(shm->plugin_name), "%s", plugin->desc->name ? plugin->desc->name : "");
+    shm->has_input = inst.io->main_in >= 0;
+    shm->latency = clap_latency(&inst);
+    uint32_t count = (uint32_t)clap_param_count(&inst);
+    if (count > SANDBOX_MAX_PARAMS) count = SANDBOX_MAX_PARAMS;
+    for (uint32_t i = 0; i < count; i++) {
+        sandbox_param_info_t *info = &shm->param_info[i];
+        clap_param_info(&inst, (int)i, info->name, sizeof(info->name), &info->min, &info->max, &info->def);
+        clap_param_module(&inst, (int)i, info->module, sizeof(info->module));
+        info->flags = inst.param_cache->flags[i];
+        shm->param_values[i] = clap_param_get(&inst, (int)i);
+    }
+    shm->param_count = count;
+
+    /* Answer the block a previous child died on, empty - the parent waits for it before
+       sending more, and its events may be what crashed the plugin */
+    int req = __atomic_load_n(&shm->req_seq, __ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&shm->ack_seq, __ATOMIC_ACQUIRE) != req) {
+        shm->slot.midi_out_count = 0;
+        shm->slot.param_out_count = 0;
+        shm->slot.note_end_count = 0;
+        __atomic_store_n(&shm->ack_seq, req, __ATOMIC_RELEASE);
+        futex_wake_shared(&shm->ack_seq);
+    }
+
+    /* A state request a previous child didn't serve has been given up on */
+    int served = __atomic_load_n(&shm->state_req, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&shm->state_ack, served, __ATOMIC_RELEASE);
+
+    sandbox_child_t child = { shm, &inst };
+    pthread_t audio;
+    if (pthread_create(&audio, NULL, sandbox_child_audio, &child) != 0) {
+        clap_unload_plugin(&inst);
+        __atomic_store_n(&shm->ready, -1, __ATOMIC_RELEASE);
+        futex_wake_shared(&shm->ready);
+        clap_log_close();
+        return 1;
+    }
+    __atomic_store_n(&shm->ready, gen, __ATOMIC_RELEASE);
+    futex_wake_shared(&shm->ready);
+
+    /* Main thread - serve the proxy's state requests, and keep a recent state copy for a restart */
+    uint64_t next_save = now_ns() + SANDBOX_STATE_INTERVAL_MS * 1000000ULL;
+    while (!__atomic_load_n(&shm->quit, __ATOMIC_ACQUIRE)) {
+        uint64_t now = now_ns();
+        futex_wait_shared(&shm->state_req, served, next_save > now ? next_save - now : 1);
+        if (__atomic_load_n(&shm->quit, __ATOMIC_ACQUIRE)) break;
+
+        int req = __atomic_load_n(&shm->state_req, __ATOMIC_ACQUIRE);
+        bool loaded = false;
+        if (req != served) {
+            served = req;
+            bool ok = sandbox_state_serve(shm, &inst);
+            loaded = ok && shm->state_cmd == SANDBOX_STATE_LOAD;
+            shm->state_ok = ok;
+            __atomic_store_n(&shm->state_ack, req, __ATOMIC_RELEASE);
+            futex_wake_shared(&shm->state_ack);
+        }
+        if (loaded || now_ns() >= next_save) {
+            sandbox_state_save(shm, plugin);
+            next_save = now_ns() + SANDBOX_STATE_INTERVAL_MS * 1000000ULL;
+        }
+    }
+
+    futex_wake_shared(&shm->req_seq);
+    pthread_join(audio, NULL);
+    clap_unload_plugin(&inst);
+    clap_log_close();
     return 0;
 }
 
-double clap_param_get(clap_instance_t *inst, int index) {
-    if (!inst->plugin) return 0.0;
+/* ---- Parent side ---- */
 
-    const clap_plugin_t *plugin = (const clap_plugin_t *)inst->plugin;
-    const clap_plugin_params_t *params =
-        (const clap_plugin_params_t *)plugin->get_extension(plugin, CLAP_EXT_PARAMS);
-    if (!params) return 0.0;
+static int sandbox_spawn(clap_sandbox_t *sb) {
+    char fd_arg[16], gen_arg[16];
+    snprintf(fd_arg, sizeof(fd_arg), "%d", sb->shm_fd);
+    snprintf(gen_arg, sizeof(gen_arg), "%d", sb->gen);
+    char arg0[] = "clap-sandbox";
+    char arg1[] = CLAP_SANDBOX_ARG;
+    char *argv[] = { arg0, arg1, fd_arg, gen_arg, NULL };
+
+    pid_t pid;
+    if (posix_spawn(&pid, sb->helper, NULL, NULL, argv, environ) != 0) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "sandbox: cannot start %s", sb->helper);
+        return -1;
+    }
+    sb->pid = pid;
+    return 0;
+}
+
+/* Helper: has the child exited? Reaps it. */
+static bool sandbox_exited(clap_sandbox_t *sb) {
+    int status;
+    pid_t rc = waitpid(sb->pid, &status, WNOHANG);
+    return rc == sb->pid || (rc < 0 && errno == ECHILD);
+}
+
+/* Supervisor thread - spawns the child, and respawns it when it dies or hangs */
+static void *sandbox_supervisor(void *arg) {
+    clap_sandbox_t *sb = (clap_sandbox_t *)arg;
+    sandbox_shm_t *shm = sb->shm;
+
+    while (!__atomic_load_n(&sb->stop, __ATOMIC_ACQUIRE)) {
+        sb->gen++;
+        if (sandbox_spawn(sb) != 0) {
+            __atomic_store_n(&shm->ready, -1, __ATOMIC_RELEASE);
+            futex_wake_shared(&shm->ready);
+            break;
+        }
+
+        /* Wait for the load, a failed load is not retried */
+        uint64_t deadline = now_ns() + SANDBOX_START_TIMEOUT_MS * 1000000ULL;
+        int ready;
+        while ((ready = __atomic_load_n(&shm->ready, __ATOMIC_ACQUIRE)) != sb->gen && ready >= 0) {
+            if (now_ns() >= deadline || sandbox_exited(sb)) {
+                ready = -1;
+                break;
+            }
+            futex_wait_shared(&shm->ready, ready, SANDBOX_POLL_MS * 1000000ULL);
+        }
+        if (ready < 0) {
+            kill(sb->pid, SIGKILL);
+            waitpid(sb->pid, NULL, 0);
+            __atomic_store_n(&shm->ready, -1, __ATOMIC_RELEASE);
+            futex_wake_shared(&shm->ready);
+            break;
+        }
+        if (sb->gen > 1) {
+            __atomic_add_fetch(&sb->restarts, 1, __ATOMIC_RELAXED);
+            HOST_LOG(CLAP_HOST_LOG_INFO, "sandbox: restarted %s", shm->path);
+        }
+        __atomic_store_n(&sb->alive, 1, __ATOMIC_RELEASE);
+
+        /* Watch for a crash, or a child that stops answering - one that answers
+           every block late is slow, not hung, and keeps running */
+        int acked = __atomic_load_n(&shm->ack_seq, __ATOMIC_ACQUIRE);
+        uint64_t acked_ns = now_ns();
+        while (!sandbox_exited(sb)) {
+            if (__atomic_load_n(&sb->stop, __ATOMIC_ACQUIRE)) {
+                __atomic_store_n(&shm->quit, 1, __ATOMIC_RELEASE);
+                futex_wake_shared(&shm->quit);
+                futex_wake_shared(&shm->state_req);
+                futex_wake_shared(&shm->req_seq);
+                waitpid(sb->pid, NULL, 0);
+                break;
+            }
+            int ack = __atomic_load_n(&shm->ack_seq, __ATOMIC_ACQUIRE);
+            uint64_t now = now_ns();
+            if (ack != acked || ack == __atomic_load_n(&shm->req_seq, __ATOMIC_ACQUIRE)) {
+                acked = ack;
+                acked_ns = now;
+            } else if (now - acked_ns > SANDBOX_HANG_MS * 1000000ULL) {
+                HOST_LOG(CLAP_HOST_LOG_WARN, "sandbox: child hung, killing it");
+                kill(sb->pid, SIGKILL);
+            }
+            usleep(SANDBOX_POLL_MS * 1000);
+        }
+        __atomic_store_n(&sb->alive, 0, __ATOMIC_RELEASE);
+        if (!__atomic_load_n(&sb->stop, __ATOMIC_ACQUIRE)) {
+            HOST_LOG(CLAP_HOST_LOG_WARN, "sandbox: child exited, restarting");
+            usleep(SANDBOX_RESTART_DELAY_MS * 1000);
+        }
+    }
+    return NULL;
+}
 
-    clap_param_info_t info;
-    if (!params->get_info(plugin, index, &info)) return 0.0;
+/* Helper: copy the main input to the main output, or silence it */
+static void sandbox_pass_through(const clap_process_t *process) {
+    const clap_audio_buffer_t *out = &process->audio_outputs[0];
+    const clap_audio_buffer_t *in = process->audio_inputs_count > 0 ? &process->audio_inputs[0] : NULL;
+    for (uint32_t c = 0; c < out->channel_count; c++) {
+        if (in && c < in->channel_count) {
+            memmove(out->data32[c], in->data32[c], process->frames_count * sizeof(float));
+        } else {
+            memset(out->data32[c], 0, process->frames_count * sizeof(float));
+        }
+    }
+}
 
-    double value = 0.0;
-    if (params->get_value(plugin, info.id, &value)) {
-        return value;
+/* Helper: hold a block's events for the child - params coalesce by id, MIDI past the limit is dropped */
+static void sandbox_queue_events(clap_sandbox_t *sb, const clap_input_events_t *in_events) {
+    /* MIDI comes as CLAP_EVENT_MIDI (the proxy only takes the MIDI dialect), params by index */
+    uint32_t n = in_events->size(in_events);
+    for (uint32_t i = 0; i < n; i++) {
+        const clap_event_header_t *hdr = in_events->get(in_events, i);
+        if (hdr->space_id != CLAP_CORE_EVENT_SPACE_ID) continue;
+        if (hdr->type == CLAP_EVENT_MIDI && sb->pending_midi_count < SANDBOX_MAX_EVENTS) {
+            const clap_event_midi_t *m = (const clap_event_midi_t *)hdr;
+            midi_event_t *e = &sb->pending_midi[sb->pending_midi_count++];
+            memcpy(e->data, m->data, 3);
+            e->len = 3;
+        } else if (hdr->type == CLAP_EVENT_PARAM_VALUE) {
+            const clap_event_param_value_t *p = (const clap_event_param_value_t *)hdr;
+            uint32_t j = 0;
+            while (j < sb->pending_param_count && sb->pending_params[j].index != p->param_id) j++;
+            if (j == SANDBOX_MAX_EVENTS) continue;
+            sb->pending_params[j].index = p->param_id;
+            sb->pending_params[j].value = p->value;
+            if (j == sb->pending_param_count) sb->pending_param_count++;
+        }
     }
-    return info.default_value;
 }
 
-int clap_send_midi(clap_instance_t *inst, const uint8_t *msg, int len) {
-    if (!msg || len < 1 || len > 3) return -1;
+/* Helper: pass MIDI, param changes and ended voices from the child's answer on to the host */
+static void sandbox_forward_outputs(const sandbox_slot_t *slot, const clap_output_events_t *out_events) {
+    for (uint32_t i = 0; i < slot->midi_out_count; i++) {
+        clap_event_midi_t m = {
+            { sizeof(clap_event_midi_t), 0, CLAP_CORE_EVENT_SPACE_ID, CLAP_EVENT_MIDI, 0 }, 0,
+            { slot->midi_out[i].data[0], slot->midi_out[i].data[1], slot->midi_out[i].data[2] }
+        };
+        out_events->try_push(out_events, &m.header);
+    }
+    for (uint32_t i = 0; i < slot->param_out_count; i++) {
+        clap_event_param_value_t p;
+        memset(&p, 0, sizeof(p));
+        p.header.size = sizeof(p);
+        p.header.space_id = CLAP_CORE_EVENT_SPACE_ID;
+        p.header.type = CLAP_EVENT_PARAM_VALUE;
+        p.param_id = slot->params_out[i].index;
+        p.note_id = -1;
+        p.port_index = -1;
+        p.channel = -1;
+        p.key = -1;
+        p.value = slot->params_out[i].value;
+        out_events->try_push(out_events, &p.header);
+    }
+    for (uint32_t i = 0; i < slot->note_end_count; i++) {
+        clap_event_note_t e;
+        memset(&e, 0, sizeof(e));
+        e.header.size = sizeof(e);
+        e.header.space_id = CLAP_CORE_EVENT_SPACE_ID;
+        e.header.type = CLAP_EVENT_NOTE_END;
+        e.note_id = -1;
+        e.port_index = 0;
+        e.channel = slot->note_ends[i].channel;
+        e.key = slot->note_ends[i].key;
+        out_events->try_push(out_events, &e.header);
+    }
+}
+
+/* Hand one block (or just events, frames == 0) to the child - false if it didn't answer in time */
+static bool sandbox_exchange(clap_sandbox_t *sb, const clap_process_t *process,
+                             const clap_input_events_t *in_events, const clap_output_events_t *out_events) {
+    sandbox_shm_t *shm = sb->shm;
+    sandbox_slot_t *slot = &shm->slot;
+    sandbox_queue_events(sb, in_events);
+    if (!__atomic_load_n(&sb->alive, __ATOMIC_ACQUIRE)) return false;
+
+    /* The last block is still with the child - its slot can't be refilled yet */
+    if (__atomic_load_n(&shm->ack_seq, __ATOMIC_ACQUIRE) != sb->seq) {
+        sb->missed++;
+        return false;
+    }
+    if (sb->late) {
+        /* Answered after its deadline - the audio was passed through, the events still count */
+        sandbox_forward_outputs(slot, out_events);
+        sb->late = false;
+    }
+
+    int seq = sb->seq + 1;
+    uint32_t frames = process ? process->frames_count : 0;
+    memcpy(slot->midi, sb->pending_midi, sb->pending_midi_count * sizeof(midi_event_t));
+    memcpy(slot->params, sb->pending_params, sb->pending_param_count * sizeof(sandbox_param_t));
+    slot->midi_count = sb->pending_midi_count;
+    slot->param_count = sb->pending_param_count;
+    sb->pending_midi_count = 0;
+    sb->pending_param_count = 0;
 
-    pthread_mutex_lock(&s_midi_mutex);
-    if (s_midi_queue_count < MAX_MIDI_EVENTS) {
-        midi_event_t *evt = &s_midi_queue[s_midi_queue_count++];
-        evt->len = len;
-        for (int i = 0; i < len; i++) {
-            evt->data[i] = msg[i];
+    if (process && shm->has_input && process->audio_inputs_count > 0) {
+        const clap_audio_buffer_t *in = &process->audio_inputs[0];
+        float *dst = slot->in;
+        for (uint32_t i = 0; i < frames; i++) {
+            dst[i * 2] = in->data32[0][i];
+            dst[i * 2 + 1] = in->data32[in->channel_count > 1 ? 1 : 0][i];
         }
     }
-    pthread_mutex_unlock(&s_midi_mutex);
+    slot->frames = (int)frames;
 
-    (void)inst;
+    /* Deadline is a share of the block, or of the largest block for an events-only exchange */
+    uint32_t budget_frames = frames > 0 ? frames : (uint32_t)shm->max_frames;
+    uint64_t budget_ns = (uint64_t)(budget_frames * 1e9 / shm->sample_rate) * SANDBOX_DEADLINE_PERCENT / 100;
+    uint64_t t0 = now_ns();
+    __atomic_store_n(&shm->req_seq, seq, __ATOMIC_RELEASE);
+    futex_wake_shared(&shm->req_seq);
+    sb->seq = seq;
+
+    if (!sandbox_wait(&shm->ack_seq, seq - 1, t0 + budget_ns)) {
+        sb->late = true;
+        sb->missed++;
+        return false;
+    }
+    uint64_t rtt = now_ns() - t0;
+
+    if (process) {
+        const clap_audio_buffer_t *out = &process->audio_outputs[0];
+        const float *src = slot->out;
+        for (uint32_t i = 0; i < frames; i++) {
+            out->data32[0][i] = src[i * 2];
+            if (out->channel_count > 1) out->data32[1][i] = src[i * 2 + 1];
+        }
+    }
+    sandbox_forward_outputs(slot, out_events);
+
+    uint64_t child_ns = slot->process_ns < rtt ? slot->process_ns : rtt;
+    uint64_t ipc = __atomic_load_n(&sb->ipc_ns, __ATOMIC_RELAXED);
+    ipc = ipc ? ipc - (ipc >> 4) + ((rtt - child_ns) >> 4) : rtt - child_ns;
+    __atomic_store_n(&sb->ipc_ns, ipc, __ATOMIC_RELAXED);
+    return true;
+}
+
+/* Proxy plugin - what the host instance drives in place of the sandboxed plugin */
+static clap_sandbox_t *proxy_sandbox(const clap_plugin_t *plugin) {
+    return (clap_sandbox_t *)plugin->plugin_data;
+}
+
+static clap_process_status proxy_process(const clap_plugin_t *plugin, const clap_process_t *process) {
+    if (!sandbox_exchange(proxy_sandbox(plugin), process, process->in_events, process->out_events)) {
+        sandbox_pass_through(process);
+    }
+    return CLAP_PROCESS_CONTINUE;
+}
+
+static bool proxy_activate(const clap_plugin_t *plugin, double sample_rate, uint32_t min_frames, uint32_t max_frames) {
+    sandbox_shm_t *shm = proxy_sandbox(plugin)->shm;
+    if (max_frames > SANDBOX_MAX_FRAMES) return false;
+    if (sample_rate != shm->sample_rate || (int)max_frames != shm->max_frames) {
+        /* Picked up by the child before its next block */
+        shm->sample_rate = sample_rate;
+        shm->max_frames = (int)max_frames;
+        __atomic_add_fetch(&shm->config_seq, 1, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+static bool proxy_init(const clap_plugin_t *plugin) { return true; }
+static void proxy_deactivate(const clap_plugin_t *plugin) {}
+static bool proxy_start_processing(const clap_plugin_t *plugin) { return true; }
+static void proxy_stop_processing(const clap_plugin_t *plugin) {}
+static void proxy_reset(const clap_plugin_t *plugin) {}
+static void proxy_on_main_thread(const clap_plugin_t *plugin) {}
+
+static void proxy_destroy(const clap_plugin_t *plugin) {
+    clap_sandbox_t *sb = proxy_sandbox(plugin);
+    __atomic_store_n(&sb->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(sb->supervisor, NULL);
+    munmap(sb->shm, sizeof(sandbox_shm_t));
+    close(sb->shm_fd);
+    free(sb);
+}
+
+static uint32_t proxy_ports_count(const clap_plugin_t *plugin, bool is_input) {
+    return is_input ? (proxy_sandbox(plugin)->shm->has_input ? 1 : 0) : 1;
+}
+
+static bool proxy_ports_get(const clap_plugin_t *plugin, uint32_t index, bool is_input, clap_audio_port_info_t *info) {
+    if (index != 0) return false;
+    memset(info, 0, sizeof(*info));
+    info->id = 0;
+    snprintf(info->name, sizeof(info->name), "%s", is_input ? "In" : "Out");
+    info->flags = CLAP_AUDIO_PORT_IS_MAIN;
+    info->channel_count = 2;
+    info->port_type = CLAP_PORT_STEREO;
+    info->in_place_pair = proxy_sandbox(plugin)->shm->has_input ? 0 : CLAP_INVALID_ID;
+    return true;
+}
+
+static const clap_plugin_audio_ports_t s_proxy_audio_ports = { proxy_ports_count, proxy_ports_get };
+
+static uint32_t proxy_note_ports_count(const clap_plugin_t *plugin, bool is_input) {
+    return is_input ? 1 : 0;
+}
+
+static bool proxy_note_ports_get(const clap_plugin_t *plugin, uint32_t index, bool is_input, clap_note_port_info_t *info) {
+    if (index != 0 || !is_input) return false;
+    memset(info, 0, sizeof(*info));
+    info->supported_dialects = CLAP_NOTE_DIALECT_MIDI;
+    info->preferred_dialect = CLAP_NOTE_DIALECT_MIDI;
+    snprintf(info->name, sizeof(info->name), "MIDI In");
+    return true;
+}
+
+static const clap_plugin_note_ports_t s_proxy_note_ports = { proxy_note_ports_count, proxy_note_ports_get };
+
+static uint32_t proxy_params_count(const clap_plugin_t *plugin) {
+    return proxy_sandbox(plugin)->shm->param_count;
+}
+
+static bool proxy_params_info(const clap_plugin_t *plugin, uint32_t index, clap_param_info_t *info) {
+    const sandbox_shm_t *shm = proxy_sandbox(plugin)->shm;
+    if (index >= shm->param_count) return false;
+    const sandbox_param_info_t *p = &shm->param_info[index];
+    memset(info, 0, sizeof(*info));
+    info->id = index;
+    info->flags = p->flags;
+    memcpy(info->name, p->name, sizeof(info->name));
+    memcpy(info->module, p->module, sizeof(p->module));
+    info->min_value = p->min;
+    info->max_value = p->max;
+    info->default_value = p->def;
+    return true;
+}
+
+static bool proxy_params_value(const clap_plugin_t *plugin, clap_id id, double *value) {
+    const sandbox_shm_t *shm = proxy_sandbox(plugin)->shm;
+    if (id >= shm->param_count) return false;
+    *value = shm->param_values[id];
+    return true;
+}
+
+static bool proxy_params_to_text(const clap_plugin_t *plugin, clap_id id, double value, char *out, uint32_t size) {
+    return false;
+}
+
+static bool proxy_params_to_value(const clap_plugin_t *plugin, clap_id id, const char *text, double *value) {
+    return false;
+}
+
+static void proxy_params_flush(const clap_plugin_t *plugin, const clap_input_events_t *in,
+                               const clap_output_events_t *out) {
+    sandbox_exchange(proxy_sandbox(plugin), NULL, in, out);
+}
+
+static const clap_plugin_params_t s_proxy_params = {
+    proxy_params_count, proxy_params_info, proxy_params_value,
+    proxy_params_to_text, proxy_params_to_value, proxy_params_flush
+};
+
+static uint32_t proxy_latency_get(const clap_plugin_t *plugin) {
+    return proxy_sandbox(plugin)->shm->latency;
+}
+
+static const clap_plugin_latency_t s_proxy_latency = { proxy_latency_get };
+
+/* Helper: have the child's main thread save or load its plugin's state through state_io */
+static bool sandbox_state_request(clap_sandbox_t *sb, int cmd) {
+    sandbox_shm_t *shm = sb->shm;
+    if (!__atomic_load_n(&sb->alive, __ATOMIC_ACQUIRE)) return false;
+
+    shm->state_cmd = cmd;
+    int req = __atomic_add_fetch(&shm->state_req, 1, __ATOMIC_RELEASE);
+    futex_wake_shared(&shm->state_req);
+    uint64_t deadline = now_ns() + SANDBOX_STATE_TIMEOUT_MS * 1000000ULL;
+    int ack;
+    while ((ack = __atomic_load_n(&shm->state_ack, __ATOMIC_ACQUIRE)) != req) {
+        if (now_ns() >= deadline || !__atomic_load_n(&sb->alive, __ATOMIC_ACQUIRE)) {
+            HOST_LOG(CLAP_HOST_LOG_ERROR, "sandbox: state request not answered");
+            return false;
+        }
+        futex_wait_shared(&shm->state_ack, ack, SANDBOX_POLL_MS * 1000000ULL);
+    }
+    return shm->state_ok != 0;
+}
+
+static bool proxy_state_save(const clap_plugin_t *plugin, const clap_ostream_t *stream) {
+    clap_sandbox_t *sb = proxy_sandbox(plugin);
+    if (!sandbox_state_request(sb, SANDBOX_STATE_SAVE)) return false;
+    const uint8_t *data = sb->shm->state_io;
+    uint32_t len = sb->shm->state_io_len;
+    while (len > 0) {
+        int64_t n = stream->write(stream, data, len);
+        if (n <= 0) return false;
+        data += n;
+        len -= (uint32_t)n;
+    }
+    return true;
+}
+
+static bool proxy_state_load(const clap_plugin_t *plugin, const clap_istream_t *stream) {
+    clap_sandbox_t *sb = proxy_sandbox(plugin);
+    sandbox_shm_t *shm = sb->shm;
+    uint32_t len = 0;
+    int64_t n;
+    while ((n = stream->read(stream, shm->state_io + len, SANDBOX_STATE_MAX - len)) > 0) {
+        len += (uint32_t)n;
+        if (len == SANDBOX_STATE_MAX) {
+            uint8_t more;
+            if (stream->read(stream, &more, 1) != 0) return false;  /* Larger than the child takes */
+            break;
+        }
+    }
+    if (n < 0) return false;
+    shm->state_io_len = len;
+    return sandbox_state_request(sb, SANDBOX_STATE_LOAD);
+}
+
+static const clap_plugin_state_t s_proxy_state = { proxy_state_save, proxy_state_load };
+
+static const void *proxy_get_extension(const clap_plugin_t *plugin, const char *id) {
+    if (!strcmp(id, CLAP_EXT_AUDIO_PORTS)) return &s_proxy_audio_ports;
+    if (!strcmp(id, CLAP_EXT_NOTE_PORTS)) return &s_proxy_note_ports;
+    if (!strcmp(id, CLAP_EXT_PARAMS)) return &s_proxy_params;
+    if (!strcmp(id, CLAP_EXT_LATENCY)) return &s_proxy_latency;
+    if (!strcmp(id, CLAP_EXT_STATE)) return &s_proxy_state;
+    return NULL;
+}
+
+static const clap_plugin_descriptor_t s_proxy_desc = {
+    CLAP_VERSION_INIT, "move-anything.clap-sandbox", "Sandboxed plugin", "", "", "", "", "", "", NULL
+};
+
+int clap_load_plugin_sandboxed(const char *helper, const char *path, int plugin_index, clap_instance_t *out) {
+    memset(out, 0, sizeof(*out));
+    HOST_LOG(CLAP_HOST_LOG_INFO, "Loading sandboxed: %s index %d", path, plugin_index);
+
+    clap_sandbox_t *sb = (clap_sandbox_t *)calloc(1, sizeof(clap_sandbox_t));
+    if (!sb) return -1;
+    snprintf(sb->helper, sizeof(sb->helper), "%s", helper);
+
+    /* Shared memory the child maps through the inherited descriptor */
+    sb->shm_fd = (int)syscall(SYS_memfd_create, "clap-sandbox", 0);
+    if (sb->shm_fd < 0 || ftruncate(sb->shm_fd, sizeof(sandbox_shm_t)) != 0) {
+        if (sb->shm_fd >= 0) close(sb->shm_fd);
+        free(sb);
+        return -1;
+    }
+    void *mem = mmap(NULL, sizeof(sandbox_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, sb->shm_fd, 0);
+    if (mem == MAP_FAILED) {
+        close(sb->shm_fd);
+        free(sb);
+        return -1;
+    }
+    sb->shm = (sandbox_shm_t *)mem;
+    sandbox_shm_t *shm = sb->shm;
+    shm->magic = SANDBOX_MAGIC;
+    shm->parent_pid = getpid();
+    snprintf(shm->path, sizeof(shm->path), "%s", path);
+    shm->plugin_index = plugin_index;
+    shm->sample_rate = s_sample_rate;
+    shm->max_frames = s_max_frames;
+    shm->state_slot = -1;
+
+    clap_plugin_t *proxy = &sb->proxy;
+    sb->desc = s_proxy_desc;
+    proxy->desc = &sb->desc;
+    proxy->plugin_data = sb;
+    proxy->init = proxy_init;
+    proxy->destroy = proxy_destroy;
+    proxy->activate = proxy_activate;
+    proxy->deactivate = proxy_deactivate;
+    proxy->start_processing = proxy_start_processing;
+    proxy->stop_processing = proxy_stop_processing;
+    proxy->reset = proxy_reset;
+    proxy->process = proxy_process;
+    proxy->get_extension = proxy_get_extension;
+    proxy->on_main_thread = proxy_on_main_thread;
+
+    /* The supervisor spawns the child - it has to outlive it (PR_SET_PDEATHSIG) */
+    if (pthread_create(&sb->supervisor, NULL, sandbox_supervisor, sb) != 0) {
+        munmap(mem, sizeof(sandbox_shm_t));
+        close(sb->shm_fd);
+        free(sb);
+        return -1;
+    }
+    while (!__atomic_load_n(&sb->alive, __ATOMIC_ACQUIRE) && __atomic_load_n(&shm->ready, __ATOMIC_ACQUIRE) >= 0) {
+        usleep(1000);
+    }
+    if (!__atomic_load_n(&sb->alive, __ATOMIC_ACQUIRE) || instance_host_create(out) != 0) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "sandboxed load failed");
+        proxy_destroy(proxy);
+        return -1;
+    }
+    /* Report the sandboxed plugin's id - state blobs and caches are keyed by it */
+    sb->desc.id = shm->plugin_id;
+    sb->desc.name = shm->plugin_name;
+    if (instance_start(proxy, out) != 0) {
+        HOST_LOG(CLAP_HOST_LOG_ERROR, "sandboxed load failed");
+        instance_host_free(out);
+        proxy_destroy(proxy);
+        return -1;
+    }
+
+    out->sandbox = sb;
+    strncpy(out->path, path, sizeof(out->path) - 1);
+    out->plugin_index = plugin_index;
+    return 0;
+}
+
+int clap_sandbox_restarts(clap_instance_t *inst) {
+    if (!inst || !inst->sandbox) return 0;
+    return __atomic_load_n(&inst->sandbox->restarts, __ATOMIC_RELAXED);
+}
+
+double clap_sandbox_ipc_us(clap_instance_t *inst) {
+    if (!inst || !inst->sandbox) return 0.0;
+    return __atomic_load_n(&inst->sandbox->ipc_ns, __ATOMIC_RELAXED) / 1000.0;
+}
+
+/* Defined last - a sandboxed source is cloned into a sandbox too */
+int clap_clone_plugin(clap_instance_t *src, clap_instance_t *out) {
+    if (!src || !src->plugin || !out) return -1;
+    int rc = src->sandbox
+        ? clap_load_plugin_sandboxed(src->sandbox->helper, src->path, src->plugin_index, out)
+        : clap_load_plugin(src->path, src->plugin_index, out);
+    if (rc != 0) return -1;
+
+    uint8_t *blob;
+    size_t len;
+    if (clap_state_save(src, &blob, &len) == 0) {
+        rc = clap_state_load(out, blob, len);
+        free(blob);
+    } else {
+        rc = -1;
+    }
+    /* Without a state extension the param values are the next best thing */
+    if (rc != 0) {
+        int count = clap_param_count(src);
+        for (int i = 0; i < count; i++) clap_param_set(out, i, clap_param_get(src, i));
+    }
+    clap_set_mix(out, src->mix);
     return 0;
 }
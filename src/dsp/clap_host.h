@@ -9,6 +9,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,12 +38,11 @@ typedef struct clap_host_list {
     int capacity;
 } clap_host_list_t;
 
-/* Per-instance param change queue */
-#define CLAP_MAX_PARAM_CHANGES 32
-typedef struct {
-    uint32_t param_id;
-    double value;
-} clap_param_change_t;
+/* Sidechain routing sources */
+#define CLAP_SIDECHAIN_OFF      -1
+#define CLAP_SIDECHAIN_LINE_IN  -2
+#define CLAP_SIDECHAIN_BUS_COUNT 4     /* Shared buses, sources 0..3 ("bus_1".."bus_4") */
+#define CLAP_SIDECHAIN_BUS_FRAMES 1024
 
 /* Loaded plugin instance */
 typedef struct clap_instance {
@@ -51,11 +51,55 @@ typedef struct clap_instance {
     const void *factory;             /* clap_plugin_factory_t* */
     const void *entry;               /* clap_plugin_entry_t* */
     char path[1024];
+    int plugin_index;                /* Index within the .clap bundle */
     bool activated;
     bool processing;
-    /* Per-instance param change queue */
-    clap_param_change_t param_queue[CLAP_MAX_PARAM_CHANGES];
-    int param_queue_count;
+    double sample_rate;              /* Rate the plugin is activated at */
+    int max_frames;                  /* Largest block passed to process(), longer blocks are split */
+    int suspend;                     /* Nonzero while re-activating, audio thread skips the plugin */
+    int in_process;                  /* Audio thread is inside clap_process_block* */
+    int chunk_offset;                /* Frame offset of the chunk being processed */
+    /* Audio port layout and buffers, read at load */
+    struct clap_audio_io *io;
+    uint32_t audio_in_ports;
+    uint32_t audio_out_ports;
+    bool in_place;                   /* Main input/output share one buffer (in_place_pair) */
+    bool use64;                      /* Audio is passed as double (CLAP_AUDIO_PORT_PREFERS_64BITS) */
+    /* Audio routing */
+    const int16_t *sidechain_src;    /* Interleaved stereo fed to the sidechain port, NULL = off */
+    bool aux_outputs;                /* Mix auxiliary output ports into the main output */
+    int midi_dialect;                /* How incoming MIDI is translated, from the plugin's note ports */
+    /* Thread pool extension - plugin fans tasks out to the host's workers */
+    bool thread_pool;
+    uint64_t pool_wall_ns;           /* Time spent in request_exec */
+    uint64_t pool_task_ns;           /* Summed task time inside it */
+    /* Latency and dry/wet mix */
+    uint32_t latency;                /* Plugin latency in frames, from clap_plugin_latency */
+    int latency_gen;
+    float mix;                       /* 1 = fully wet */
+    struct clap_dry_delay *dry;      /* Latency-aligned dry input, created when mix < 1 */
+    /* Batch rendering */
+    bool batch;                      /* Holds a worker pool reference for clap_process_batch_i16 */
+    uint64_t cost_ns;                /* Recent process time, schedules expensive instances first */
+    /* Plugin output events (note end, MIDI out) and the param table (value mirror, change queue) */
+    struct clap_events *events;
+    struct clap_param_cache *param_cache;
+    /* Remote-control knob pages, NULL if the plugin has none */
+    struct clap_remote_pages *remote;
+    int remote_gen;
+    /* The plugin's host (host_data = this instance) and its pending requests */
+    struct clap_instance_host *host;
+    int callback_requested;          /* request_callback pending, serviced by the main loop */
+    /* Preset catalog, built by clap_presets_index */
+    struct clap_preset_index *presets;
+    /* Out-of-process hosting - plugin points at a proxy forwarding to the child */
+    struct clap_sandbox *sandbox;
+    /* Sleep state - plugin is not processed while asleep */
+    bool sleeping;
+    int tail_gen;                    /* Tail generation the cached tail was read at */
+    uint32_t tail_frames;            /* From clap_plugin_tail, UINT32_MAX = infinite */
+    uint32_t quiet_frames;           /* Consecutive frames with no input/notes and quiet output */
+    uint64_t sleep_frames;           /* Total frames skipped while asleep */
 } clap_instance_t;
 
 /*
@@ -72,6 +116,14 @@ int clap_scan_plugins(const char *dir, clap_host_list_t *out);
  */
 void clap_free_plugin_list(clap_host_list_t *list);
 
+/*
+ * Set the sample rate and maximum block size used to activate plugins
+ *
+ * Applies to plugins loaded afterwards; use clap_reconfigure() for loaded ones.
+ * Defaults are 44100 Hz and 128 frames.
+ */
+void clap_host_set_audio_config(double sample_rate, int max_frames);
+
 /*
  * Load a plugin instance
  *
@@ -82,11 +134,111 @@ void clap_free_plugin_list(clap_host_list_t *list);
  */
 int clap_load_plugin(const char *path, int plugin_index, clap_instance_t *out);
 
+/*
+ * Load a plugin instance into a sandbox child process
+ *
+ * helper: Executable that calls clap_sandbox_child_main (the clap-sandbox binary)
+ * The instance is used like an in-process one. Audio and events go through shared
+ * memory each block; if the child crashes or hangs it is restarted with its last
+ * saved state, and the input passes through until it is back. The instance reports
+ * the sandboxed plugin's id, and state saves and loads are served by the child.
+ * Returns: 0 on success, -1 on error
+ */
+int clap_load_plugin_sandboxed(const char *helper, const char *path, int plugin_index, clap_instance_t *out);
+
+/* Sandbox child entry point - argv as passed by clap_load_plugin_sandboxed */
+#define CLAP_SANDBOX_ARG "--clap-sandbox"
+#define CLAP_SANDBOX_HELPER "clap-sandbox"  /* Installed next to the module */
+int clap_sandbox_child_main(int argc, char **argv);
+
+/* Times the sandbox child was restarted after a crash or hang */
+int clap_sandbox_restarts(clap_instance_t *inst);
+
+/* Per-block IPC overhead (round trip minus child processing time), smoothed */
+double clap_sandbox_ipc_us(clap_instance_t *inst);
+
 /*
  * Unload a plugin instance
  */
 void clap_unload_plugin(clap_instance_t *inst);
 
+/*
+ * Save the plugin's state (clap_plugin_state) as a blob tagged with the plugin id
+ *
+ * Usually returns the snapshot the main loop took after the plugin last marked itself
+ * dirty; saves on the calling thread only if there is none. Call off the audio thread.
+ * data: Set to a malloc'd blob, free() it
+ * Returns: 0 on success, -1 on error (no state extension, save failed)
+ */
+int clap_state_save(clap_instance_t *inst, uint8_t **data, size_t *len);
+
+/*
+ * Restore a blob from clap_state_save into an instance of the same plugin
+ *
+ * One state->load call; the param table is re-read afterwards. Call off the audio thread.
+ * Returns: 0 on success, -1 on error (other plugin, bad blob, load failed)
+ */
+int clap_state_load(clap_instance_t *inst, const uint8_t *data, size_t len);
+
+/*
+ * Save the state to dir/<content hash>.clapstate, for referencing from a patch
+ *
+ * Identical states share a file. path receives the file's full path. Files are never
+ * removed - any saved patch may still reference one, and the host doesn't say which.
+ * Returns: 0 on success, -1 on error (including a path that doesn't fit)
+ */
+int clap_state_write_file(clap_instance_t *inst, const char *dir, char *path, int path_len);
+
+/*
+ * Restore a state file written by clap_state_write_file
+ * Returns: 0 on success, -1 on error
+ */
+int clap_state_read_file(clap_instance_t *inst, const char *path);
+
+/*
+ * Index the plugin's presets (preset-discovery factory) into cache_dir
+ *
+ * A fresh index file for the bundle is mapped right away; otherwise the presets are
+ * indexed on a background thread and clap_preset_count() stays 0 until it is done.
+ * Not available for sandboxed instances.
+ * Returns: 0 if indexing started or the cached index was loaded, -1 if the plugin has no presets
+ */
+int clap_presets_index(clap_instance_t *inst, const char *cache_dir);
+
+/* Number of indexed presets, 0 while indexing */
+int clap_preset_count(clap_instance_t *inst);
+
+/* Name of an indexed preset; returns its length, -1 if out of range */
+int clap_preset_name(clap_instance_t *inst, int index, char *buf, int buf_len);
+
+/*
+ * Load an indexed preset through the plugin's preset-load extension
+ * Returns: 0 on success, -1 on error
+ */
+int clap_preset_load(clap_instance_t *inst, int index);
+
+/* Last preset loaded with clap_preset_load, -1 if none */
+int clap_preset_current(clap_instance_t *inst);
+
+/*
+ * Load another instance of src's plugin with src's state, e.g. for layering
+ *
+ * Sandboxed sources are cloned into a sandbox. Without a state extension the
+ * param values are copied instead.
+ * Returns: 0 on success, -1 on error
+ */
+int clap_clone_plugin(clap_instance_t *src, clap_instance_t *out);
+
+/*
+ * Re-activate a loaded plugin at a new sample rate / maximum block size
+ *
+ * Call off the audio thread. Waits for an in-flight process call to finish;
+ * the audio thread skips the plugin until re-activation completes.
+ * Returns: 0 on success (or nothing to change), -1 on error - including a process
+ * call that doesn't return within a second, in which case nothing is changed
+ */
+int clap_reconfigure(clap_instance_t *inst, double sample_rate, int max_frames);
+
 /*
  * Process an audio block
  *
@@ -98,6 +250,115 @@ void clap_unload_plugin(clap_instance_t *inst);
  */
 int clap_process_block(clap_instance_t *inst, const float *in, float *out, int frames);
 
+/*
+ * Process an audio block directly from/to int16
+ *
+ * Converts straight into and out of the plugin's planar buffers, skipping the
+ * interleaved float stage. in may equal out for in-place FX.
+ *
+ * inst: Loaded plugin instance
+ * in: Input audio (int16 stereo interleaved), or NULL for synths
+ * out: Output audio (int16 stereo interleaved)
+ * frames: Number of frames to process
+ * Returns: 0 on success, -1 on error (out is left untouched)
+ */
+int clap_process_block_i16(clap_instance_t *inst, const int16_t *in, int16_t *out, int frames);
+
+/*
+ * Render several independent instances in parallel
+ *
+ * Instances are spread over the worker pool and the calling thread; returns when all
+ * are done. Instances must not depend on each other's output in the same block
+ * (e.g. through sidechain buses). Each item's result is clap_process_block_i16()'s.
+ * Returns: 0 if every instance succeeded, -1 otherwise
+ */
+typedef struct {
+    clap_instance_t *inst;
+    const int16_t *in;
+    int16_t *out;
+    int frames;
+    int result;
+} clap_batch_item_t;
+
+int clap_process_batch_i16(clap_batch_item_t *items, int count);
+
+/*
+ * Mark an instance as rendered through batches, keeping the worker pool running for it
+ */
+void clap_set_batch(clap_instance_t *inst, bool enabled);
+
+/*
+ * Route audio into the plugin's sidechain input (first non-main input port)
+ *
+ * in: Interleaved int16 stereo read on every following block, NULL for none.
+ *     The sidechain port is deactivated while nothing is routed, when the plugin allows it.
+ */
+void clap_set_sidechain_input(clap_instance_t *inst, const int16_t *in);
+
+/*
+ * Enable or disable mixing auxiliary output ports into the main output
+ *
+ * Disabled ports are deactivated so the plugin can skip rendering them.
+ */
+void clap_set_aux_outputs(clap_instance_t *inst, bool enabled);
+
+/*
+ * Shared sidechain buses
+ *
+ * An instance writes its output to a bus; others read it as sidechain input.
+ * A reader that runs before the writer in a block gets the previous block.
+ */
+void clap_sidechain_bus_write(int bus, const int16_t *audio, int frames);
+const int16_t *clap_sidechain_bus_read(int bus);
+
+/*
+ * Parse/format a sidechain source value ("off", "line_in", "bus_1".."bus_4")
+ */
+int clap_sidechain_parse(const char *val);
+int clap_sidechain_format(int source, char *buf, int buf_len);
+
+/*
+ * Get total time the plugin has spent asleep, in milliseconds
+ */
+double clap_sleep_ms(clap_instance_t *inst);
+
+/*
+ * Process-time stats as JSON, in builds with CLAP_HOST_PERF (-1 otherwise)
+ *
+ * Blocks processed and blocks over budget (took longer than they last), and
+ * min/p50/p99/max/mean microseconds for the time inside plugin->process and the host's
+ * time around it (conversion, events, mixing). Percentiles come from log buckets and
+ * are within 25%. Blocks the plugin slept through are not counted. Without
+ * CLAP_HOST_PERF the process path has no timing code at all.
+ */
+int clap_perf_stats(clap_instance_t *inst, char *buf, int buf_len);
+
+/* Clear the stats - takes effect at the instance's next block */
+void clap_perf_reset(clap_instance_t *inst);
+
+/*
+ * Get the plugin's latency in frames, re-queried after the plugin reports a change
+ *
+ * Use it to delay parallel paths (chain-level compensation). Call off the audio thread.
+ */
+uint32_t clap_latency(clap_instance_t *inst);
+
+/*
+ * Set the dry/wet mix, 0 = dry .. 1 = wet (default)
+ *
+ * The dry signal is the block input delayed by the plugin's latency, so both line up.
+ * Only affects instances fed with input (FX). Call off the audio thread.
+ * Returns: 0 on success, -1 on error
+ */
+int clap_set_mix(clap_instance_t *inst, float mix);
+
+/*
+ * Get the thread pool speedup: summed task time / wall time of request_exec calls
+ *
+ * 1.0 means no parallelism (tasks ran inline), 0 if the plugin never used the pool.
+ */
+double clap_thread_pool_speedup(clap_instance_t *inst);
+
 /*
  * Get parameter count
  */
@@ -108,6 +369,13 @@ int clap_param_count(clap_instance_t *inst);
  */
 int clap_param_info(clap_instance_t *inst, int index, char *name, int name_len, double *min, double *max, double *def);
 
+/*
+ * Get a parameter's module path ("Osc 1/Filter"), "" for top-level params
+ *
+ * Returns the path length, -1 for an unknown index.
+ */
+int clap_param_module(clap_instance_t *inst, int index, char *buf, int buf_len);
+
 /*
  * Set parameter value
  */
@@ -115,14 +383,106 @@ int clap_param_set(clap_instance_t *inst, int index, double value);
 
 /*
  * Get parameter value
+ *
+ * Reads the host's value mirror (last value sent or reported by the plugin),
+ * never calls into the plugin. Safe while the audio thread is processing.
  */
 double clap_param_get(clap_instance_t *inst, int index);
 
+/*
+ * Parameter generation - changes whenever a value, the param list or the knob pages
+ * change, so a UI can skip re-reading params while it stays the same
+ */
+uint32_t clap_param_generation(clap_instance_t *inst);
+
+/*
+ * Get a parameter's current value as display text ("440 Hz", "-6.0 dB")
+ *
+ * Formatted by the plugin's value_to_text and kept until the value changes, so
+ * polling an unchanged knob is a cache hit. Falls back to "%.3f". Call off the
+ * audio thread. Returns the text length, -1 for an unknown index.
+ */
+int clap_param_text(clap_instance_t *inst, int index, char *buf, int buf_len);
+
+/*
+ * Remote-control pages: 8 knobs per page, from the plugin's remote controls
+ *
+ * Plugins without them get pages of 8 params in index order ("Params 1-8", ...).
+ * The table is read at load and again only after the plugin reports a change,
+ * so knob lookups are cheap. Call off the audio thread.
+ */
+#define CLAP_KNOBS_PER_PAGE 8
+int clap_remote_page_count(clap_instance_t *inst);
+int clap_remote_page_name(clap_instance_t *inst, int page, char *buf, int buf_len);
+
+/* Param index on a page's knob (0..7), -1 if the knob is unassigned */
+int clap_remote_param(clap_instance_t *inst, int page, int knob);
+
+/*
+ * Read the next MIDI message the plugin emitted (call after processing a block)
+ *
+ * Note on/off and raw MIDI output events are converted to MIDI bytes.
+ * Returns: message length, 0 if none are pending
+ */
+int clap_midi_out_read(clap_instance_t *inst, uint8_t msg[3]);
+
+/*
+ * Get the number of voices still sounding (note on sent, no CLAP_EVENT_NOTE_END yet)
+ */
+int clap_active_voices(clap_instance_t *inst);
+
 /*
  * Send MIDI event to plugin
  */
 int clap_send_midi(clap_instance_t *inst, const uint8_t *msg, int len);
 
+/*
+ * Logging
+ *
+ * Records are formatted into a preallocated lock-free ring and written out by a
+ * background thread (stderr, an optional size-capped file and an optional sink), at
+ * most CLAP_HOST_LOG_RATE records per second - errors are exempt. Safe from any
+ * thread, the audio thread included: a full ring drops the record rather than block.
+ * Without an open logger, records go straight to stderr - except on threads that have
+ * processed audio, where they are only counted, and reported once a logger is open.
+ *
+ * Levels above CLAP_HOST_LOG_LEVEL_MAX are compiled out of CLAP_HOST_LOG; the runtime level
+ * defaults to info, or $CLAP_LOG_LEVEL ("error", "warn", "info", "debug").
+ */
+#define CLAP_HOST_LOG_ERROR 0
+#define CLAP_HOST_LOG_WARN  1
+#define CLAP_HOST_LOG_INFO  2
+#define CLAP_HOST_LOG_DEBUG 3
+
+#ifndef CLAP_HOST_LOG_LEVEL_MAX
+#define CLAP_HOST_LOG_LEVEL_MAX CLAP_HOST_LOG_DEBUG
+#endif
+
+#define CLAP_HOST_LOG_RATE 200
+
+#define CLAP_HOST_LOG(level, tag, ...) \
+    do { if ((level) <= CLAP_HOST_LOG_LEVEL_MAX) clap_log((level), (tag), __VA_ARGS__); } while (0)
+
+void clap_log(int level, const char *tag, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+/*
+ * Start the writer thread for one more user (main thread)
+ *
+ * The first user's file and sink are used. file (NULL for none) is rotated to
+ * <file>.1 when it passes max_bytes. sink is called on the writer thread, not the
+ * thread that logged, so it must be safe to call from any thread.
+ */
+void clap_log_open(const char *file, long max_bytes, void (*sink)(const char *msg));
+
+/* Drop a user; the last one flushes the ring and stops the writer */
+void clap_log_close(void);
+
+/* Runtime level, and its names for param values */
+void clap_log_set_level(int level);
+int clap_log_get_level(void);
+int clap_log_level_parse(const char *val);
+int clap_log_level_format(int level, char *buf, int buf_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
 
 /* Include plugin API */
 extern "C" {
@@ -62,6 +63,9 @@ typedef plugin_api_v2_t* (*move_plugin_init_v2_fn)(const host_api_v1_t *host);
 #include "clap_host.h"
 }
 
+#include "param_keys.h"
+#include "module_shared.h"
+
 /* Constants */
 #define MAX_PLUGINS 512
 #define PLUGINS_SUBDIR "plugins"
@@ -85,12 +89,9 @@ static void plugin_log(const char *msg);
 static void scan_plugins(void);
 static void load_selected_plugin(void);
 
-/* Log helper */
+/* Log helper - through the host logger (stderr and the host's log, off this thread) */
 static void plugin_log(const char *msg) {
-    if (g_host && g_host->log) {
-        g_host->log(msg);
-    }
-    fprintf(stderr, "[CLAP] %s\n", msg);
+    CLAP_HOST_LOG(CLAP_HOST_LOG_INFO, "CLAP", "%s", msg);
 }
 
 /* Scan for plugins in the plugins subdirectory */
@@ -137,6 +138,8 @@ static void load_selected_plugin(void) {
 /* === Plugin API Implementation === */
 
 static int on_load(const char *module_dir, const char *json_defaults) {
+    /* The host's log runs on the writer thread - it is also called from v2's UI-thread keys */
+    clap_log_open(NULL, 0, g_host ? g_host->log : NULL);
     plugin_log("CLAP Host module loading");
 
     strncpy(g_module_dir, module_dir, sizeof(g_module_dir) - 1);
@@ -161,21 +164,21 @@ static void on_unload(void) {
         clap_unload_plugin(&g_current_plugin);
     }
     clap_free_plugin_list(&g_plugin_list);
+    clap_log_close();
 }
 
 static void on_midi(const uint8_t *msg, int len, int source) {
-    if (!g_current_plugin.plugin || len < 3) return;
+    if (!g_current_plugin.plugin || len < 1) return;
 
+    /* Program change and channel pressure are 2 bytes - only notes need data1/data2 here */
     uint8_t status = msg[0] & 0xF0;
-    uint8_t data1 = msg[1];
-    uint8_t data2 = msg[2];
 
     /* Apply octave transpose to note messages */
-    if (status == 0x90 || status == 0x80) {
-        int note = data1 + (g_octave_transpose * 12);
+    if ((status == 0x90 || status == 0x80 || status == 0xA0) && len >= 3) {
+        int note = msg[1] + (g_octave_transpose * 12);
         if (note < 0) note = 0;
         if (note > 127) note = 127;
-        uint8_t transposed[3] = {msg[0], (uint8_t)note, data2};
+        uint8_t transposed[3] = {msg[0], (uint8_t)note, msg[2]};
         clap_send_midi(&g_current_plugin, transposed, 3);
     } else {
         clap_send_midi(&g_current_plugin, msg, len);
@@ -273,21 +276,9 @@ static void render_block(int16_t *out_interleaved_lr, int frames) {
         return;
     }
 
-    /* Process through CLAP plugin */
-    float float_out[MOVE_FRAMES_PER_BLOCK * 2];
-
-    if (clap_process_block(&g_current_plugin, NULL, float_out, frames) != 0) {
+    /* Process through CLAP plugin, converting straight into the output */
+    if (clap_process_block_i16(&g_current_plugin, NULL, out_interleaved_lr, frames) != 0) {
         memset(out_interleaved_lr, 0, frames * 2 * sizeof(int16_t));
-        return;
-    }
-
-    /* Convert float to int16 */
-    for (int i = 0; i < frames * 2; i++) {
-        float sample = float_out[i];
-        /* Clamp to [-1, 1] */
-        if (sample > 1.0f) sample = 1.0f;
-        if (sample < -1.0f) sample = -1.0f;
-        out_interleaved_lr[i] = (int16_t)(sample * 32767.0f);
     }
 }
 
@@ -295,6 +286,7 @@ static void render_block(int16_t *out_interleaved_lr, int frames) {
 
 extern "C" plugin_api_v1_t* move_plugin_init_v1(const host_api_v1_t *host) {
     g_host = host;
+    clap_host_set_audio_config(host->sample_rate, host->frames_per_block);
 
     g_plugin_api.api_version = MOVE_PLUGIN_API_VERSION;
     g_plugin_api.on_load = on_load;
@@ -311,6 +303,10 @@ extern "C" plugin_api_v1_t* move_plugin_init_v1(const host_api_v1_t *host) {
  * Plugin API v2 - Instance-based API
  * ===================================================================== */
 
+/* Batch rendering limits */
+#define BATCH_MAX_INSTANCES 16
+#define BATCH_MAX_FRAMES    256
+
 typedef struct {
     char module_dir[256];
     clap_host_list_t plugin_list;
@@ -318,14 +314,41 @@ typedef struct {
     int selected_index;
     int octave_transpose;
     int param_bank;
+    /* Audio routing */
+    int sidechain_source;           /* CLAP_SIDECHAIN_* source fed to the sidechain port */
+    int sidechain_send;             /* Bus our output is sent to, CLAP_SIDECHAIN_OFF if none */
+    bool aux_outputs;               /* Mix auxiliary output buses into the main output */
+    int midi_out;                   /* MIDI_OUT_* destination for MIDI the plugin emits */
+    bool sandbox;                   /* Host plugins out of process */
+    int plugin_loads;               /* Bumped per load, tells snapshots of different plugins apart */
+    v2_snapshot_t snapshot;         /* params_snapshot, rebuilt when the param generation, page or plugin changes */
+    /* Batch rendering */
+    bool batch;                     /* Opted in to batch rendering */
+    uint32_t block;                 /* g_batch_block this instance last rendered in */
+    uint32_t batch_block;           /* Block batch_out was rendered for, 0 if none */
+    int batch_rc;
+    int16_t batch_out[BATCH_MAX_FRAMES * 2];
 } clap_host_instance_t;
 
-/* v2 helper: Log with host */
+/*
+ * Instances rendered together (opt-in, batch = 1): a generator has no audio input,
+ * so the first render_block of a block renders every batched instance across the
+ * worker pool and the others just copy their output. MIDI for an instance that
+ * arrives after that first call is picked up in the next block - a block of latency
+ * traded for parallel rendering.
+ *
+ * The host gives no block clock, so g_batch_block counts blocks: it moves on when
+ * an instance renders a second time. Output is only used in the block it was
+ * rendered for; an instance the host skipped drops it.
+ */
+static clap_host_instance_t *g_batch_instances[BATCH_MAX_INSTANCES];
+static int g_batch_count = 0;
+static uint32_t g_batch_block = 1;
+static pthread_mutex_t g_batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* v2 helper: Log through the host logger (stderr and the host's log, off this thread) */
 static void v2_plugin_log(const char *msg) {
-    if (g_host && g_host->log) {
-        g_host->log(msg);
-    }
-    fprintf(stderr, "[CLAP v2] %s\n", msg);
+    CLAP_HOST_LOG(CLAP_HOST_LOG_INFO, "CLAP v2", "%s", msg);
 }
 
 /* v2 helper: Scan for plugins */
@@ -351,6 +374,7 @@ static void v2_load_selected_plugin(clap_host_instance_t *inst) {
     if (inst->current_plugin.plugin) {
         clap_unload_plugin(&inst->current_plugin);
     }
+    inst->plugin_loads++;
 
     if (inst->selected_index < 0 || inst->selected_index >= inst->plugin_list.count) {
         return;
@@ -362,20 +386,113 @@ static void v2_load_selected_plugin(clap_host_instance_t *inst) {
     snprintf(msg, sizeof(msg), "Loading plugin: %s", info->name);
     v2_plugin_log(msg);
 
-    if (clap_load_plugin(info->path, info->plugin_index, &inst->current_plugin) != 0) {
+    int rc;
+    if (inst->sandbox) {
+        char helper[512];
+        snprintf(helper, sizeof(helper), "%s/%s", inst->module_dir, CLAP_SANDBOX_HELPER);
+        rc = clap_load_plugin_sandboxed(helper, info->path, info->plugin_index, &inst->current_plugin);
+    } else {
+        rc = clap_load_plugin(info->path, info->plugin_index, &inst->current_plugin);
+    }
+    if (rc != 0) {
         v2_plugin_log("Failed to load plugin");
         inst->selected_index = -1;
+        return;
+    }
+    clap_set_aux_outputs(&inst->current_plugin, inst->aux_outputs);
+    clap_set_batch(&inst->current_plugin, inst->batch);
+
+    /* Presets are indexed in the background, preset_count grows from 0 once done */
+    char presets_dir[512];
+    snprintf(presets_dir, sizeof(presets_dir), "%s/presets", inst->module_dir);
+    clap_presets_index(&inst->current_plugin, presets_dir);
+}
+
+/* v2 helper: Re-activate the plugin if the host's rate or block size changed (UI thread) */
+static void v2_check_audio_config(clap_host_instance_t *inst) {
+    if (!g_host || !inst->current_plugin.plugin || g_host->sample_rate <= 0) return;
+    if (g_host->sample_rate == (int)inst->current_plugin.sample_rate &&
+        (g_host->frames_per_block <= 0 || g_host->frames_per_block == inst->current_plugin.max_frames)) return;
+    clap_host_set_audio_config(g_host->sample_rate, g_host->frames_per_block);
+    clap_reconfigure(&inst->current_plugin, g_host->sample_rate, g_host->frames_per_block);
+}
+
+/* v2 helper: Rebuild params_snapshot if anything shown changed, returns its generation */
+static uint32_t v2_params_snapshot(clap_host_instance_t *inst) {
+    clap_instance_t *plugin = &inst->current_plugin;
+    v2_snapshot_t *s = &inst->snapshot;
+    uint32_t gen = clap_param_generation(plugin);
+    if (v2_snapshot_fresh(s, gen, inst->param_bank, inst->plugin_loads)) return s->seq;
+
+    char text[64];
+    if (clap_remote_page_name(plugin, inst->param_bank, text, sizeof(text)) < 0) text[0] = '\0';
+    v2_snapshot_begin(s, inst->param_bank, clap_remote_page_count(plugin), text);
+    for (int knob = 0; knob < CLAP_KNOBS_PER_PAGE; knob++) {
+        int idx = clap_remote_param(plugin, inst->param_bank, knob);
+        char name[64] = "";
+        if (idx < 0 || clap_param_info(plugin, idx, name, sizeof(name), NULL, NULL, NULL) != 0) continue;
+        double value = clap_param_get(plugin, idx);
+        if (clap_param_text(plugin, idx, text, sizeof(text)) < 0) text[0] = '\0';
+        v2_snapshot_knob(s, knob, name, &value, text);
+    }
+    return v2_snapshot_commit(s, gen, inst->param_bank, inst->plugin_loads);
+}
+
+static void v2_set_param(void *instance, const char *key, const char *val);
+
+/* v2 helper: Instances that can be rendered in a batch (opted in, no sidechain bus dependencies) */
+static bool v2_batch_eligible(clap_host_instance_t *inst, int frames) {
+    return inst->batch && inst->current_plugin.plugin && frames <= BATCH_MAX_FRAMES &&
+           inst->sidechain_source == CLAP_SIDECHAIN_OFF && inst->sidechain_send == CLAP_SIDECHAIN_OFF;
+}
+
+/*
+ * v2 helper: Render self and every eligible instance still due this block (audio thread).
+ * Due means rendered in the previous block and not yet in this one - an instance
+ * the host stopped calling isn't rendered ahead again.
+ */
+static void v2_render_batch(clap_host_instance_t *self, int frames) {
+    if (pthread_mutex_trylock(&g_batch_mutex) != 0) return;
+
+    clap_batch_item_t items[BATCH_MAX_INSTANCES];
+    clap_host_instance_t *owners[BATCH_MAX_INSTANCES];
+    int n = 0;
+    for (int i = 0; i < g_batch_count; i++) {
+        clap_host_instance_t *inst = g_batch_instances[i];
+        if (inst->batch_block == g_batch_block || !v2_batch_eligible(inst, frames)) continue;
+        if (inst != self && inst->block + 1 != g_batch_block) continue;
+        items[n].inst = &inst->current_plugin;
+        items[n].in = NULL;
+        items[n].out = inst->batch_out;
+        items[n].frames = frames;
+        items[n].result = 0;
+        owners[n++] = inst;
+    }
+
+    /* A single instance renders directly */
+    if (n > 1) {
+        clap_process_batch_i16(items, n);
+        for (int i = 0; i < n; i++) {
+            owners[i]->batch_rc = items[i].result;
+            owners[i]->batch_block = g_batch_block;
+        }
     }
+    pthread_mutex_unlock(&g_batch_mutex);
 }
 
 /* v2 API: Create instance */
 static void* v2_create_instance(const char *module_dir, const char *json_defaults) {
     clap_host_instance_t *inst = (clap_host_instance_t*)calloc(1, sizeof(clap_host_instance_t));
     if (!inst) return NULL;
+    clap_log_open(NULL, 0, g_host ? g_host->log : NULL);
 
     strncpy(inst->module_dir, module_dir, sizeof(inst->module_dir) - 1);
     inst->module_dir[sizeof(inst->module_dir) - 1] = '\0';
     inst->selected_index = -1;
+    inst->sidechain_source = CLAP_SIDECHAIN_OFF;
+    inst->sidechain_send = CLAP_SIDECHAIN_OFF;
+    inst->aux_outputs = true;
+    inst->midi_out = MIDI_OUT_OFF;
 
     v2_scan_plugins(inst);
 
@@ -384,7 +501,11 @@ static void* v2_create_instance(const char *module_dir, const char *json_default
         v2_load_selected_plugin(inst);
     }
 
-    fprintf(stderr, "CLAP v2: Instance created\n");
+    pthread_mutex_lock(&g_batch_mutex);
+    if (g_batch_count < BATCH_MAX_INSTANCES) g_batch_instances[g_batch_count++] = inst;
+    pthread_mutex_unlock(&g_batch_mutex);
+
+    CLAP_HOST_LOG(CLAP_HOST_LOG_INFO, "CLAP v2", "Instance created");
     return inst;
 }
 
@@ -393,29 +514,37 @@ static void v2_destroy_instance(void *instance) {
     clap_host_instance_t *inst = (clap_host_instance_t*)instance;
     if (!inst) return;
 
+    pthread_mutex_lock(&g_batch_mutex);
+    for (int i = 0; i < g_batch_count; i++) {
+        if (g_batch_instances[i] == inst) {
+            g_batch_instances[i] = g_batch_instances[--g_batch_count];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_batch_mutex);
+
     if (inst->current_plugin.plugin) {
         clap_unload_plugin(&inst->current_plugin);
     }
     clap_free_plugin_list(&inst->plugin_list);
     free(inst);
 
-    fprintf(stderr, "CLAP v2: Instance destroyed\n");
+    CLAP_HOST_LOG(CLAP_HOST_LOG_INFO, "CLAP v2", "Instance destroyed");
+    clap_log_close();
 }
 
 /* v2 API: MIDI handler */
 static void v2_on_midi(void *instance, const uint8_t *msg, int len, int source) {
     clap_host_instance_t *inst = (clap_host_instance_t*)instance;
-    if (!inst || !inst->current_plugin.plugin || len < 3) return;
+    if (!inst || !inst->current_plugin.plugin || len < 1) return;
 
     uint8_t status = msg[0] & 0xF0;
-    uint8_t data1 = msg[1];
-    uint8_t data2 = msg[2];
 
-    if (status == 0x90 || status == 0x80) {
-        int note = data1 + (inst->octave_transpose * 12);
+    if ((status == 0x90 || status == 0x80 || status == 0xA0) && len >= 3) {
+        int note = msg[1] + (inst->octave_transpose * 12);
         if (note < 0) note = 0;
         if (note > 127) note = 127;
-        uint8_t transposed[3] = {msg[0], (uint8_t)note, data2};
+        uint8_t transposed[3] = {msg[0], (uint8_t)note, msg[2]};
         clap_send_midi(&inst->current_plugin, transposed, 3);
     } else {
         clap_send_midi(&inst->current_plugin, msg, len);
@@ -427,28 +556,84 @@ static void v2_set_param(void *instance, const char *key, const char *val) {
     clap_host_instance_t *inst = (clap_host_instance_t*)instance;
     if (!inst || !key || !val) return;
 
-    if (strcmp(key, "selected_plugin") == 0) {
+    param_key_t k;
+    if (!param_key_parse(key, &k)) return;
+
+    switch (k.hash) {
+    PARAM_KEY_CASE(k, "selected_plugin") {
         int idx = atoi(val);
         if (idx >= 0 && idx < inst->plugin_list.count && idx != inst->selected_index) {
             inst->selected_index = idx;
             v2_load_selected_plugin(inst);
         }
+        return;
     }
-    else if (strcmp(key, "refresh") == 0) {
+    PARAM_KEY_CASE(k, "refresh")
         v2_scan_plugins(inst);
-    }
-    else if (strcmp(key, "octave_transpose") == 0) {
+        return;
+    PARAM_KEY_CASE(k, "octave_transpose")
         inst->octave_transpose = atoi(val);
         if (inst->octave_transpose < -2) inst->octave_transpose = -2;
         if (inst->octave_transpose > 2) inst->octave_transpose = 2;
-    }
-    else if (strcmp(key, "param_bank") == 0) {
+        return;
+    PARAM_KEY_CASE(k, "param_bank")
         inst->param_bank = atoi(val);
+        return;
+    PARAM_KEY_CASE(k, "sidechain")
+        inst->sidechain_source = clap_sidechain_parse(val);
+        return;
+    PARAM_KEY_CASE(k, "sidechain_send")
+        inst->sidechain_send = clap_sidechain_parse(val);
+        if (inst->sidechain_send == CLAP_SIDECHAIN_LINE_IN) inst->sidechain_send = CLAP_SIDECHAIN_OFF;
+        return;
+    PARAM_KEY_CASE(k, "aux_outputs")
+        inst->aux_outputs = atoi(val) != 0;
+        clap_set_aux_outputs(&inst->current_plugin, inst->aux_outputs);
+        return;
+    PARAM_KEY_CASE(k, "midi_out")
+        inst->midi_out = v2_midi_out_parse(val);
+        return;
+    PARAM_KEY_CASE(k, "preset") {
+        int idx = atoi(val);
+        if (idx != clap_preset_current(&inst->current_plugin)) clap_preset_load(&inst->current_plugin, idx);
+        return;
     }
-    else if (strncmp(key, "param_", 6) == 0) {
-        int param_idx = atoi(key + 6);
-        double value = atof(val);
-        clap_param_set(&inst->current_plugin, param_idx, value);
+    PARAM_KEY_CASE(k, "state")
+        /* A state file from get_param("state") - one state load restores the plugin */
+        if (inst->current_plugin.plugin && clap_state_read_file(&inst->current_plugin, val) != 0) {
+            CLAP_HOST_LOG(CLAP_HOST_LOG_ERROR, "CLAP v2", "state load failed: %s", val);
+        }
+        return;
+    PARAM_KEY_CASE(k, "sandbox") {
+        bool sandbox = atoi(val) != 0;
+        if (sandbox != inst->sandbox) {
+            inst->sandbox = sandbox;
+            if (inst->current_plugin.plugin) v2_load_selected_plugin(inst);
+        }
+        return;
+    }
+    PARAM_KEY_CASE(k, "batch")
+        inst->batch = atoi(val) != 0;
+        if (inst->current_plugin.plugin) clap_set_batch(&inst->current_plugin, inst->batch);
+        return;
+    PARAM_KEY_CASE(k, "params_batch")
+        v2_params_batch(inst, val, v2_set_param);
+        return;
+    PARAM_KEY_CASE(k, "log_level")
+        clap_log_set_level(clap_log_level_parse(val));
+        return;
+    PARAM_KEY_CASE(k, "perf_reset")
+        clap_perf_reset(&inst->current_plugin);
+        return;
+    PARAM_KEY_CASE(k, "knob_N") {
+        /* knob_0..knob_7 - the param on that knob of the current page (param_bank) */
+        int param_idx = clap_remote_param(&inst->current_plugin, inst->param_bank, k.index);
+        if (param_idx >= 0) clap_param_set(&inst->current_plugin, param_idx, atof(val));
+        return;
+    }
+    PARAM_KEY_CASE(k, "param_N")
+        clap_param_set(&inst->current_plugin, k.index, atof(val));
+        return;
     }
 }
 
@@ -457,53 +642,135 @@ static int v2_get_param(void *instance, const char *key, char *buf, int buf_len)
     clap_host_instance_t *inst = (clap_host_instance_t*)instance;
     if (!inst || !key || !buf || buf_len <= 0) return -1;
 
-    if (strcmp(key, "plugin_count") == 0) {
+    v2_check_audio_config(inst);
+
+    param_key_t k;
+    if (!param_key_parse(key, &k)) return -1;
+
+    switch (k.hash) {
+    PARAM_KEY_CASE(k, "plugin_count")
         return snprintf(buf, buf_len, "%d", inst->plugin_list.count);
+    /* params_gen is cheap to poll; params_snapshot only needs reading when it changes */
+    PARAM_KEY_CASE(k, "params_gen")
+        return snprintf(buf, buf_len, "%u", v2_params_snapshot(inst));
+    PARAM_KEY_CASE(k, "params_snapshot")
+        v2_params_snapshot(inst);
+        return v2_snapshot_read(&inst->snapshot, buf, buf_len);
+    /* plugin_names - every plugin name, newline separated, -1 if they don't fit */
+    PARAM_KEY_CASE(k, "plugin_names") {
+        int off = 0;
+        buf[0] = '\0';
+        for (int i = 0; i < inst->plugin_list.count; i++) {
+            int n = snprintf(buf + off, buf_len - off, i ? "\n%s" : "%s", inst->plugin_list.items[i].name);
+            if (n < 0 || n >= buf_len - off) return -1;
+            off += n;
+        }
+        return off;
     }
-    else if (strncmp(key, "plugin_name_", 12) == 0) {
-        int idx = atoi(key + 12);
-        if (idx >= 0 && idx < inst->plugin_list.count) {
-            return snprintf(buf, buf_len, "%s", inst->plugin_list.items[idx].name);
+    PARAM_KEY_CASE(k, "plugin_name_N")
+        if (k.index < inst->plugin_list.count) {
+            return snprintf(buf, buf_len, "%s", inst->plugin_list.items[k.index].name);
         }
         return -1;
-    }
-    else if (strncmp(key, "plugin_id_", 10) == 0) {
-        int idx = atoi(key + 10);
-        if (idx >= 0 && idx < inst->plugin_list.count) {
-            return snprintf(buf, buf_len, "%s", inst->plugin_list.items[idx].id);
+    PARAM_KEY_CASE(k, "plugin_id_N")
+        if (k.index < inst->plugin_list.count) {
+            return snprintf(buf, buf_len, "%s", inst->plugin_list.items[k.index].id);
         }
         return -1;
-    }
-    else if (strcmp(key, "selected_plugin") == 0) {
+    PARAM_KEY_CASE(k, "selected_plugin")
         return snprintf(buf, buf_len, "%d", inst->selected_index);
-    }
-    else if (strcmp(key, "current_plugin_name") == 0) {
+    PARAM_KEY_CASE(k, "current_plugin_name")
         if (inst->selected_index >= 0 && inst->selected_index < inst->plugin_list.count) {
             return snprintf(buf, buf_len, "%s", inst->plugin_list.items[inst->selected_index].name);
         }
         return snprintf(buf, buf_len, "None");
-    }
-    else if (strcmp(key, "octave_transpose") == 0) {
+    PARAM_KEY_CASE(k, "octave_transpose")
         return snprintf(buf, buf_len, "%d", inst->octave_transpose);
-    }
-    else if (strcmp(key, "param_bank") == 0) {
+    PARAM_KEY_CASE(k, "param_bank")
         return snprintf(buf, buf_len, "%d", inst->param_bank);
-    }
-    else if (strcmp(key, "param_count") == 0) {
+    PARAM_KEY_CASE(k, "param_count")
         return snprintf(buf, buf_len, "%d", clap_param_count(&inst->current_plugin));
-    }
-    else if (strncmp(key, "param_name_", 11) == 0) {
-        int idx = atoi(key + 11);
+    PARAM_KEY_CASE(k, "param_name_N") {
         char name[64] = "";
-        if (clap_param_info(&inst->current_plugin, idx, name, sizeof(name), NULL, NULL, NULL) == 0) {
+        if (clap_param_info(&inst->current_plugin, k.index, name, sizeof(name), NULL, NULL, NULL) == 0) {
             return snprintf(buf, buf_len, "%s", name);
         }
         return -1;
     }
-    else if (strncmp(key, "param_value_", 12) == 0) {
-        int idx = atoi(key + 12);
-        double value = clap_param_get(&inst->current_plugin, idx);
-        return snprintf(buf, buf_len, "%.3f", value);
+    PARAM_KEY_CASE(k, "param_value_N")
+        return snprintf(buf, buf_len, "%.3f", clap_param_get(&inst->current_plugin, k.index));
+    PARAM_KEY_CASE(k, "param_text_N")
+        return clap_param_text(&inst->current_plugin, k.index, buf, buf_len);
+    /* Knob pages - param_bank selects a remote-control page */
+    PARAM_KEY_CASE(k, "page_count")
+        return snprintf(buf, buf_len, "%d", clap_remote_page_count(&inst->current_plugin));
+    PARAM_KEY_CASE(k, "page_name")
+        return clap_remote_page_name(&inst->current_plugin, inst->param_bank, buf, buf_len);
+    PARAM_KEY_CASE(k, "knob_name_N") {
+        int idx = clap_remote_param(&inst->current_plugin, inst->param_bank, k.index);
+        char name[64] = "";
+        if (idx < 0 || clap_param_info(&inst->current_plugin, idx, name, sizeof(name), NULL, NULL, NULL) != 0) return -1;
+        return snprintf(buf, buf_len, "%s", name);
+    }
+    /* knob_text_N - the knob's value as the plugin displays it (units included) */
+    PARAM_KEY_CASE(k, "knob_text_N") {
+        int idx = clap_remote_param(&inst->current_plugin, inst->param_bank, k.index);
+        if (idx < 0) return -1;
+        return clap_param_text(&inst->current_plugin, idx, buf, buf_len);
+    }
+    PARAM_KEY_CASE(k, "knob_N") {
+        int idx = clap_remote_param(&inst->current_plugin, inst->param_bank, k.index);
+        if (idx < 0) return -1;
+        return snprintf(buf, buf_len, "%.3f", clap_param_get(&inst->current_plugin, idx));
+    }
+    PARAM_KEY_CASE(k, "sidechain")
+        return clap_sidechain_format(inst->sidechain_source, buf, buf_len);
+    PARAM_KEY_CASE(k, "sidechain_send")
+        return clap_sidechain_format(inst->sidechain_send, buf, buf_len);
+    PARAM_KEY_CASE(k, "aux_outputs")
+        return snprintf(buf, buf_len, "%d", inst->aux_outputs ? 1 : 0);
+    PARAM_KEY_CASE(k, "midi_out")
+        return snprintf(buf, buf_len, "%s", k_midi_out_names[inst->midi_out]);
+    PARAM_KEY_CASE(k, "voices")
+        return snprintf(buf, buf_len, "%d", clap_active_voices(&inst->current_plugin));
+    PARAM_KEY_CASE(k, "sleeping")
+        return snprintf(buf, buf_len, "%d", inst->current_plugin.sleeping ? 1 : 0);
+    PARAM_KEY_CASE(k, "sleep_ms")
+        return snprintf(buf, buf_len, "%.0f", clap_sleep_ms(&inst->current_plugin));
+    PARAM_KEY_CASE(k, "pool_speedup")
+        return snprintf(buf, buf_len, "%.2f", clap_thread_pool_speedup(&inst->current_plugin));
+    PARAM_KEY_CASE(k, "latency")
+        return snprintf(buf, buf_len, "%u", clap_latency(&inst->current_plugin));
+    PARAM_KEY_CASE(k, "preset") {
+        int current = clap_preset_current(&inst->current_plugin);
+        return snprintf(buf, buf_len, "%d", current < 0 ? 0 : current);
+    }
+    PARAM_KEY_CASE(k, "preset_count")
+        return snprintf(buf, buf_len, "%d", clap_preset_count(&inst->current_plugin));
+    PARAM_KEY_CASE(k, "preset_name")
+        return clap_preset_name(&inst->current_plugin, clap_preset_current(&inst->current_plugin), buf, buf_len);
+    PARAM_KEY_CASE(k, "preset_name_N")
+        return clap_preset_name(&inst->current_plugin, k.index, buf, buf_len);
+    PARAM_KEY_CASE(k, "state") {
+        /* Written to <module>/states for the patch to reference, named by content */
+        char dir[512], path[1024];
+        snprintf(dir, sizeof(dir), "%s/states", inst->module_dir);
+        if (clap_state_write_file(&inst->current_plugin, dir, path, sizeof(path)) != 0) return -1;
+        return snprintf(buf, buf_len, "%s", path);
+    }
+    PARAM_KEY_CASE(k, "batch")
+        return snprintf(buf, buf_len, "%d", inst->batch ? 1 : 0);
+    PARAM_KEY_CASE(k, "sandbox")
+        return snprintf(buf, buf_len, "%d", inst->sandbox ? 1 : 0);
+    PARAM_KEY_CASE(k, "sandbox_restarts")
+        return snprintf(buf, buf_len, "%d", clap_sandbox_restarts(&inst->current_plugin));
+    PARAM_KEY_CASE(k, "sandbox_ipc_us")
+        return snprintf(buf, buf_len, "%.1f", clap_sandbox_ipc_us(&inst->current_plugin));
+    PARAM_KEY_CASE(k, "log_level")
+        return clap_log_level_format(clap_log_get_level(), buf, buf_len);
+    /* perf_stats - process-time histograms, only in builds with CLAP_HOST_PERF */
+    PARAM_KEY_CASE(k, "perf_stats")
+        return clap_perf_stats(&inst->current_plugin, buf, buf_len);
     }
 
     return -1;
@@ -517,19 +784,34 @@ static void v2_render_block(void *instance, int16_t *out_interleaved_lr, int fra
         return;
     }
 
-    float float_out[MOVE_FRAMES_PER_BLOCK * 2];
+    if (v2_batch_eligible(inst, frames)) {
+        /* Rendering twice in one block means the next block has begun */
+        if (inst->block == g_batch_block && ++g_batch_block == 0) g_batch_block = 1;
+        inst->block = g_batch_block;
+        if (inst->batch_block != g_batch_block) v2_render_batch(inst, frames);
+        bool fresh = inst->batch_block == g_batch_block;
+        inst->batch_block = 0;  /* Stale output from a skipped block is dropped here */
+        if (fresh) {
+            if (inst->batch_rc != 0) {
+                memset(out_interleaved_lr, 0, frames * 2 * sizeof(int16_t));
+            } else {
+                memcpy(out_interleaved_lr, inst->batch_out, frames * 2 * sizeof(int16_t));
+            }
+            v2_forward_midi_out(g_host, &inst->current_plugin, inst->midi_out);
+            return;
+        }
+    }
 
-    if (clap_process_block(&inst->current_plugin, NULL, float_out, frames) != 0) {
+    clap_set_sidechain_input(&inst->current_plugin, v2_sidechain_input(g_host, inst->sidechain_source, frames));
+    if (clap_process_block_i16(&inst->current_plugin, NULL, out_interleaved_lr, frames) != 0) {
         memset(out_interleaved_lr, 0, frames * 2 * sizeof(int16_t));
         return;
     }
 
-    for (int i = 0; i < frames * 2; i++) {
-        float sample = float_out[i];
-        if (sample > 1.0f) sample = 1.0f;
-        if (sample < -1.0f) sample = -1.0f;
-        out_interleaved_lr[i] = (int16_t)(sample * 32767.0f);
+    if (inst->sidechain_send != CLAP_SIDECHAIN_OFF) {
+        clap_sidechain_bus_write(inst->sidechain_send, out_interleaved_lr, frames);
     }
+    v2_forward_midi_out(g_host, &inst->current_plugin, inst->midi_out);
 }
 
 /* CLAP host doesn't have load errors (plugins are scanned dynamically) */
@@ -545,6 +827,7 @@ static plugin_api_v2_t g_plugin_api_v2;
 
 extern "C" plugin_api_v2_t* move_plugin_init_v2(const host_api_v1_t *host) {
     g_host = host;
+    clap_host_set_audio_config(host->sample_rate, host->frames_per_block);
 
     memset(&g_plugin_api_v2, 0, sizeof(g_plugin_api_v2));
     g_plugin_api_v2.api_version = MOVE_PLUGIN_API_VERSION_2;
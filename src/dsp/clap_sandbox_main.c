@@ -0,0 +1,8 @@
+/*
+ * CLAP sandbox helper - hosts one plugin out of process for clap_load_plugin_sandboxed
+ */
+#include "clap_host.h"
+
+int main(int argc, char **argv) {
+    return clap_sandbox_child_main(argc, argv);
+}
@@ -0,0 +1,167 @@
+/*
+ * Helpers shared by the modules' v2 APIs (sound generator and audio FX)
+ *
+ * Include after host_api_v1_t is defined - each module declares it inline.
+ * Covers the params_snapshot/params_batch keys, sidechain sources and MIDI output.
+ */
+
+#ifndef MODULE_SHARED_H
+#define MODULE_SHARED_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* MIDI output destinations */
+#define MIDI_OUT_OFF      0
+#define MIDI_OUT_INTERNAL 1
+#define MIDI_OUT_EXTERNAL 2
+#define MIDI_OUT_COUNT    3
+
+static const char *const k_midi_out_names[MIDI_OUT_COUNT] = { "off", "internal", "external" };
+
+/* Parse a midi_out value, MIDI_OUT_OFF if unknown */
+static inline int v2_midi_out_parse(const char *val) {
+    for (int i = 0; i < MIDI_OUT_COUNT; i++) {
+        if (strcmp(val, k_midi_out_names[i]) == 0) return i;
+    }
+    return MIDI_OUT_OFF;
+}
+
+/* Forward MIDI the plugin emitted this block; always drains so the ring never fills */
+static inline void v2_forward_midi_out(const host_api_v1_t *host, clap_instance_t *plugin, int dest) {
+    uint8_t msg[3];
+    int len;
+    while ((len = clap_midi_out_read(plugin, msg)) > 0) {
+        if (!host) continue;
+        if (dest == MIDI_OUT_INTERNAL && host->midi_send_internal) {
+            host->midi_send_internal(msg, len);
+        } else if (dest == MIDI_OUT_EXTERNAL && host->midi_send_external) {
+            host->midi_send_external(msg, len);
+        }
+    }
+}
+
+/* Resolve a sidechain source to an interleaved stereo buffer for this block */
+static inline const int16_t *v2_sidechain_input(const host_api_v1_t *host, int source, int frames) {
+    if (source == CLAP_SIDECHAIN_LINE_IN) {
+        if (!host || !host->mapped_memory) return NULL;
+        return (const int16_t *)(host->mapped_memory + host->audio_in_offset);
+    }
+    if (frames > CLAP_SIDECHAIN_BUS_FRAMES) return NULL;
+    return clap_sidechain_bus_read(source);
+}
+
+/* Apply params_batch - "knob_0=0.5;param_12=0.25;..." - through the module's set_param */
+static inline void v2_params_batch(void *instance, const char *val,
+                                   void (*set_param)(void *instance, const char *key, const char *val)) {
+    char key[64], value[64];
+    while (*val) {
+        const char *eq = strchr(val, '=');
+        if (!eq) break;
+        const char *end = strchr(eq, ';');
+        if (!end) end = eq + strlen(eq);
+        int key_len = (int)(eq - val), val_len = (int)(end - eq - 1);
+        if (key_len > 0 && key_len < (int)sizeof(key) && val_len < (int)sizeof(value)) {
+            memcpy(key, val, key_len);
+            key[key_len] = '\0';
+            memcpy(value, eq + 1, val_len);
+            value[val_len] = '\0';
+            if (strcmp(key, "params_batch") != 0) set_param(instance, key, value);
+        }
+        val = *end ? end + 1 : end;
+    }
+}
+
+/*
+ * params_snapshot - what the knobs show, rebuilt only when something shown changed
+ *
+ * Format: "<gen>\n<page>\t<page_count>\t<page_name>\n" then one
+ * "<knob>\t<name>\t<value>\t<text>\n" line per assigned knob on the page.
+ * Knob lines that don't fit are left out whole.
+ */
+#define PARAMS_SNAPSHOT_SIZE 2048   /* Header plus 8 knob lines of name, value and text */
+
+typedef struct {
+    bool valid;
+    uint32_t seq;                   /* Reported as params_gen */
+    uint32_t param_gen;             /* Param generation, page and module generation it shows */
+    int page;
+    int source_gen;
+    int len;
+    char buf[PARAMS_SNAPSHOT_SIZE];
+} v2_snapshot_t;
+
+/* Append formatted text, clamped to the buffer - false if it didn't all fit */
+static inline bool v2_snapshot_printf(v2_snapshot_t *s, const char *fmt, ...) {
+    int room = PARAMS_SNAPSHOT_SIZE - s->len;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(s->buf + s->len, room, fmt, ap);
+    va_end(ap);
+    if (n < 0) n = 0;
+    bool fit = n < room;
+    s->len += fit ? n : room - 1;
+    return fit;
+}
+
+/* Append a field - tabs and newlines separate fields, so they become spaces */
+static inline bool v2_snapshot_field(v2_snapshot_t *s, const char *text) {
+    int n = s->len;
+    for (; *text && n < PARAMS_SNAPSHOT_SIZE - 1; text++, n++) {
+        s->buf[n] = (*text == '\t' || *text == '\n') ? ' ' : *text;
+    }
+    s->buf[n] = '\0';
+    s->len = n;
+    return *text == '\0';
+}
+
+/* True if the snapshot already shows this param generation, page and module generation */
+static inline bool v2_snapshot_fresh(const v2_snapshot_t *s, uint32_t param_gen, int page, int source_gen) {
+    return s->valid && s->param_gen == param_gen && s->page == page && s->source_gen == source_gen;
+}
+
+static inline void v2_snapshot_begin(v2_snapshot_t *s, int page, int page_count, const char *page_name) {
+    s->len = 0;
+    s->buf[0] = '\0';
+    v2_snapshot_printf(s, "%u\n%d\t%d\t", s->seq + 1, page, page_count);
+    v2_snapshot_field(s, page_name);
+    v2_snapshot_printf(s, "\n");
+}
+
+/* One knob line; value and text are left empty when value is NULL */
+static inline void v2_snapshot_knob(v2_snapshot_t *s, int knob, const char *name,
+                                    const double *value, const char *text) {
+    int start = s->len;
+    bool fit = v2_snapshot_printf(s, "%d\t", knob) && v2_snapshot_field(s, name);
+    if (fit && value) {
+        fit = v2_snapshot_printf(s, "\t%.3f\t", *value) && v2_snapshot_field(s, text ? text : "");
+    } else if (fit) {
+        fit = v2_snapshot_printf(s, "\t\t");
+    }
+    fit = fit && v2_snapshot_printf(s, "\n");
+    if (!fit) {
+        s->len = start;
+        s->buf[start] = '\0';
+    }
+}
+
+/* Publish a rebuilt snapshot, returns its generation */
+static inline uint32_t v2_snapshot_commit(v2_snapshot_t *s, uint32_t param_gen, int page, int source_gen) {
+    s->seq++;
+    s->param_gen = param_gen;
+    s->page = page;
+    s->source_gen = source_gen;
+    s->valid = true;
+    return s->seq;
+}
+
+/* Copy the snapshot out for get_param, -1 if it doesn't fit */
+static inline int v2_snapshot_read(const v2_snapshot_t *s, char *buf, int buf_len) {
+    if (s->len >= buf_len) return -1;
+    memcpy(buf, s->buf, s->len + 1);
+    return s->len;
+}
+
+#endif /* MODULE_SHARED_H */
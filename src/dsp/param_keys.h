@@ -0,0 +1,62 @@
+/*
+ * Key dispatch for the modules' set_param/get_param
+ *
+ * A key is folded into a template as it is hashed: its first run of digits becomes
+ * "N" and is returned as the index ("param_12" -> "param_N", 12). Handlers switch on
+ * the hash, with case labels hashed at compile time. Two keys with the same hash are
+ * a duplicate case and fail to build, so the switch is a perfect hash over the key
+ * set; PARAM_KEY_CASE's one strcmp turns away unknown keys that share a hash.
+ */
+
+#ifndef PARAM_KEYS_H
+#define PARAM_KEYS_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PARAM_KEY_MAX 64
+
+typedef struct {
+    uint32_t hash;                   /* param_key_hash(tmpl) */
+    int index;                       /* Value of the folded digits, -1 if there were none */
+    char tmpl[PARAM_KEY_MAX];
+} param_key_t;
+
+/* FNV-1a - constexpr so case labels are hashed by the compiler */
+static constexpr uint32_t param_key_hash(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) h = (h ^ (uint8_t)*s++) * 16777619u;
+    return h;
+}
+
+/* Fold and hash key in one pass, false if it is too long to be a known key */
+static inline bool param_key_parse(const char *key, param_key_t *out) {
+    uint32_t h = 2166136261u;
+    int n = 0;
+    out->index = -1;
+    for (const char *p = key; *p;) {
+        if (n >= PARAM_KEY_MAX - 1) return false;
+        char c = *p;
+        if (out->index < 0 && c >= '0' && c <= '9') {
+            int value = 0;
+            for (; *p >= '0' && *p <= '9'; p++) {
+                if (value < 100000000) value = value * 10 + (*p - '0');
+            }
+            out->index = value;
+            c = 'N';
+        } else {
+            p++;
+        }
+        out->tmpl[n++] = c;
+        h = (h ^ (uint8_t)c) * 16777619u;
+    }
+    out->tmpl[n] = '\0';
+    out->hash = h;
+    return true;
+}
+
+/* A case for one key template - leaves the switch if the key only shares its hash */
+#define PARAM_KEY_CASE(k, name) \
+    case param_key_hash(name): if (strcmp((k).tmpl, name) != 0) break;
+
+#endif /* PARAM_KEYS_H */
@@ -10,10 +10,16 @@ import {
 // State
 let plugins = [];
 let selectedIndex = 0;
-let paramBank = 0;
-let paramCount = 0;
+let paramBank = 0;      // Remote-control page on the encoders
+let pageCount = 0;
 let octaveTranspose = 0;
 
+// Visible knobs, from params_snapshot - only re-read when params_gen changes
+let paramsGen = "";
+let pageName = "";
+let knobs = [];
+let pendingKnobs = {};  // Encoder moves not yet sent, flushed as one params_batch per tick
+
 // Constants
 const PARAMS_PER_BANK = 8;
 const SCREEN_WIDTH = 128;
@@ -32,23 +38,68 @@ function refresh() {
     const countStr = host_module_get_param("plugin_count");
     const count = parseInt(countStr) || 0;
 
-    plugins = [];
-    for (let i = 0; i < count; i++) {
-        const name = host_module_get_param("plugin_name_" + i);
-        plugins.push(name || ("Plugin " + i));
+    // All names in one call; one call per name if they don't fit the buffer
+    const names = count > 0 ? host_module_get_param("plugin_names") : "";
+    if (names) {
+        plugins = names.split("\n");
+    } else {
+        plugins = [];
+        for (let i = 0; i < count; i++) {
+            const name = host_module_get_param("plugin_name_" + i);
+            plugins.push(name || ("Plugin " + i));
+        }
     }
 
     // Get current selection
     const selStr = host_module_get_param("selected_plugin");
     selectedIndex = parseInt(selStr) || 0;
 
-    // Get parameter count
-    const paramStr = host_module_get_param("param_count");
-    paramCount = parseInt(paramStr) || 0;
+    // Knob pages (the plugin's remote-control pages, or 8 params each)
+    const pageStr = host_module_get_param("page_count");
+    pageCount = parseInt(pageStr) || 0;
+    if (paramBank >= pageCount) {
+        paramBank = 0;
+        host_module_set_param("param_bank", "0");
+    }
 
     // Get octave transpose
     const octStr = host_module_get_param("octave_transpose");
     octaveTranspose = parseInt(octStr) || 0;
+
+    readParams();
+}
+
+// Re-read the visible knobs if anything changed, returns true if it did
+function readParams() {
+    const gen = host_module_get_param("params_gen");
+    if (!gen || gen === paramsGen) return false;
+    const snapshot = host_module_get_param("params_snapshot");
+    if (!snapshot) return false;
+
+    // "<gen>\n<page>\t<page_count>\t<page_name>\n" then "<knob>\t<name>\t<value>\t<text>" lines
+    const lines = snapshot.split("\n");
+    paramsGen = lines[0];
+    const page = (lines[1] || "").split("\t");
+    pageCount = parseInt(page[1]) || 0;
+    pageName = page[2] || "";
+    knobs = [];
+    for (let i = 2; i < lines.length; i++) {
+        if (!lines[i]) continue;
+        const f = lines[i].split("\t");
+        knobs.push({ knob: parseInt(f[0]), name: f[1], value: parseFloat(f[2]), text: f[3] });
+    }
+    return true;
+}
+
+// Send encoder moves collected since the last tick in one call
+function flushKnobs() {
+    const parts = [];
+    for (const k in pendingKnobs) {
+        parts.push("knob_" + k + "=" + pendingKnobs[k]);
+    }
+    if (parts.length === 0) return;
+    pendingKnobs = {};
+    host_module_set_param("params_batch", parts.join(";"));
 }
 
 function render() {
@@ -80,21 +131,17 @@ function render() {
     print(2, y, "[" + (selectedIndex + 1) + "/" + plugins.length + "] Oct:" + octStr, 1);
     y += LINE_HEIGHT;
 
-    // Parameters (show current bank)
-    if (paramCount > 0) {
-        const bankStart = paramBank * PARAMS_PER_BANK;
-        const bankEnd = Math.min(bankStart + PARAMS_PER_BANK, paramCount);
-        const bankNum = Math.floor(paramBank) + 1;
-        const totalBanks = Math.ceil(paramCount / PARAMS_PER_BANK);
-
-        print(2, y, "Params " + bankNum + "/" + totalBanks + ":", 1);
+    // Parameters (show current page)
+    if (pageCount > 0) {
+        const shortPage = pageName.length > 10 ? pageName.substring(0, 9) : pageName;
+        print(2, y, (paramBank + 1) + "/" + pageCount + " " + shortPage + ":", 1);
         y += LINE_HEIGHT;
 
-        // Show up to 3 params with names (limited screen space)
-        for (let i = bankStart; i < Math.min(bankStart + 3, bankEnd); i++) {
-            const pname = host_module_get_param("param_name_" + i) || ("P" + i);
-            const pval = host_module_get_param("param_value_" + i) || "0";
-            const shortPname = pname.length > 8 ? pname.substring(0, 7) : pname;
+        // Show up to 3 assigned knobs with names (limited screen space)
+        for (let i = 0; i < knobs.length && i < 3; i++) {
+            const k = knobs[i];
+            const pval = k.knob in pendingKnobs ? k.value.toFixed(3) : (k.text || k.value.toFixed(3));
+            const shortPname = k.name.length > 8 ? k.name.substring(0, 7) : k.name;
             print(2, y, shortPname + ": " + pval, 1);
             y += LINE_HEIGHT;
         }
@@ -117,6 +164,7 @@ function handleMidi(msg, source) {
                 // Right - next plugin
                 if (selectedIndex < plugins.length - 1) {
                     selectedIndex++;
+                    flushKnobs();
                     host_module_set_param("selected_plugin", String(selectedIndex));
                     refresh();
                     render();
@@ -125,6 +173,7 @@ function handleMidi(msg, source) {
                 // Left - previous plugin
                 if (selectedIndex > 0) {
                     selectedIndex--;
+                    flushKnobs();
                     host_module_set_param("selected_plugin", String(selectedIndex));
                     refresh();
                     render();
@@ -135,16 +184,19 @@ function handleMidi(msg, source) {
         else if (cc === CC_LEFT && val > 0) {
             if (paramBank > 0) {
                 paramBank--;
+                flushKnobs();
                 host_module_set_param("param_bank", String(paramBank));
+                readParams();
                 render();
             }
         }
         // Right button - next param bank
         else if (cc === CC_RIGHT && val > 0) {
-            const totalBanks = Math.ceil(paramCount / PARAMS_PER_BANK);
-            if (paramBank < totalBanks - 1) {
+            if (paramBank < pageCount - 1) {
                 paramBank++;
+                flushKnobs();
                 host_module_set_param("param_bank", String(paramBank));
+                readParams();
                 render();
             }
         }
@@ -167,12 +219,11 @@ function handleMidi(msg, source) {
         // Encoders (CC 71-78) - parameter control
         else if (cc >= 71 && cc <= 78) {
             const encoderIdx = cc - 71;
-            const paramIdx = paramBank * PARAMS_PER_BANK + encoderIdx;
+            const k = knobs.find(k => k.knob === encoderIdx);
 
-            if (paramIdx < paramCount) {
-                // Get current value and adjust
-                const currentStr = host_module_get_param("param_value_" + paramIdx) || "0";
-                let current = parseFloat(currentStr);
+            if (k) {
+                // Adjust the snapshot's value - sent with the next tick's batch
+                let current = k.value;
 
                 // Relative change based on encoder direction
                 const delta = val < 64 ? val * 0.01 : (val - 128) * 0.01;
@@ -182,7 +233,8 @@ function handleMidi(msg, source) {
                 if (current < 0) current = 0;
                 if (current > 1) current = 1;
 
-                host_module_set_param("param_" + paramIdx, String(current));
+                k.value = current;
+                pendingKnobs[encoderIdx] = current;
                 render();
             }
         }
@@ -199,7 +251,9 @@ globalThis.init = function() {
 };
 
 globalThis.tick = function() {
-    // Could refresh periodically if needed
+    // One round trip for all encoder moves, then redraw only if the params changed
+    flushKnobs();
+    if (readParams()) render();
 };
 
 globalThis.onMidiMessageInternal = function(msg) {
@@ -0,0 +1,109 @@
+/*
+ * Microbenchmark: get_param/set_param key dispatch, in calls per second
+ *
+ * Loads a built module (dsp.so or clap_fx.so) with an empty plugins directory and
+ * polls the keys a UI reads every frame, so the time measured is the dispatch.
+ * Not run by the test suite:
+ *
+ *   gcc -O2 -Isrc tests/bench_param_keys.c -o bench_param_keys -ldl
+ *   ./bench_param_keys build/dsp.so
+ *
+ * To compare revisions, build each module with the same flags, run the same
+ * iteration count and take the median of several runs, alternating between
+ * builds. Remove /tmp/clap_fx_debug.txt between runs - older FX builds append
+ * to it on every call.
+ */
+#include <dlfcn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Mirrors host_api_v1_t */
+typedef struct {
+    uint32_t api_version;
+    int sample_rate;
+    int frames_per_block;
+    uint8_t *mapped_memory;
+    int audio_out_offset;
+    int audio_in_offset;
+    void (*log)(const char *msg);
+    int (*midi_send_internal)(const uint8_t *msg, int len);
+    int (*midi_send_external)(const uint8_t *msg, int len);
+} bench_host_t;
+
+/* The prefix plugin_api_v2_t and audio_fx_api_v2_t share - set/get are in the same slots */
+typedef struct {
+    uint32_t api_version;
+    void *(*create_instance)(const char *module_dir, const char *config_json);
+    void (*destroy_instance)(void *instance);
+    void (*unused)(void);
+    void (*set_param)(void *instance, const char *key, const char *val);
+    int (*get_param)(void *instance, const char *key, char *buf, int buf_len);
+} bench_api_t;
+
+typedef bench_api_t *(*bench_init_fn)(const bench_host_t *host);
+
+/* Keys a UI polls per frame, early and late in the dispatch, plus an unknown one */
+static const char *const k_keys[] = {
+    "plugin_count", "params_gen", "knob_3", "knob_text_5", "param_value_12", "plugin_name_7",
+    "page_name", "sandbox_ipc_us", "latency", "no_such_key"
+};
+#define KEY_COUNT (int)(sizeof(k_keys) / sizeof(k_keys[0]))
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <module.so> [iterations]\n", argv[0]);
+        return 2;
+    }
+    long iterations = argc > 2 ? atol(argv[2]) : 200000;
+
+    void *lib = dlopen(argv[1], RTLD_NOW);
+    if (!lib) {
+        fprintf(stderr, "%s\n", dlerror());
+        return 1;
+    }
+    bench_init_fn init = (bench_init_fn)dlsym(lib, "move_plugin_init_v2");
+    if (!init) init = (bench_init_fn)dlsym(lib, "move_audio_fx_init_v2");
+    if (!init) {
+        fprintf(stderr, "no v2 init symbol in %s\n", argv[1]);
+        return 1;
+    }
+
+    char dir[] = "/tmp/bench_param_keys_XXXXXX";
+    if (!mkdtemp(dir)) return 1;
+    bench_host_t host = { 1 };
+    bench_api_t *api = init(&host);
+    void *inst = api ? api->create_instance(dir, "") : NULL;
+    if (!inst) {
+        fprintf(stderr, "create_instance failed\n");
+        return 1;
+    }
+
+    char buf[2048];
+    double start = now_s();
+    for (long i = 0; i < iterations; i++) {
+        api->get_param(inst, k_keys[i % KEY_COUNT], buf, sizeof(buf));
+    }
+    double get_s = now_s() - start;
+
+    start = now_s();
+    for (long i = 0; i < iterations; i++) {
+        api->set_param(inst, (i & 1) ? "knob_2" : "param_4", "0.5");
+    }
+    double set_s = now_s() - start;
+
+    printf("get_param: %.0f calls/s\n", iterations / get_s);
+    printf("set_param: %.0f calls/s\n", iterations / set_s);
+
+    api->destroy_instance(inst);
+    rmdir(dir);
+    return 0;
+}
@@ -0,0 +1,15 @@
+#!/bin/sh
+# Build the fixture plugins in tests/fixtures/clap for this machine
+#
+# The C tests load tests/fixtures/clap/<name>.clap, built from <name>.c next to it.
+# Run from anywhere; set CC to cross-compile.
+set -e
+
+cd "$(dirname "$0")/.."
+CC="${CC:-cc}"
+
+for src in tests/fixtures/clap/*.c; do
+    out="${src%.c}.clap"
+    echo "Building $out..."
+    $CC -shared -fPIC -O1 -Ithird_party/clap/include "$src" -o "$out" -lpthread
+done
@@ -0,0 +1,208 @@
+/*
+ * CLAP test stub - large param bank (audio out)
+ *
+ * BANK_PARAMS writable params with ids BANK_FIRST_ID + index. Each block outputs the
+ * values it holds on the left channel (sample i = param i) and, on the right, the
+ * number of param events received (sample 0) and how many repeated a param already
+ * seen that block (sample 1), both / 1000.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "clap/clap.h"
+
+#define BANK_PARAMS 100
+#define BANK_FIRST_ID 1000
+
+typedef struct {
+    clap_plugin_t plugin;
+    double values[BANK_PARAMS];
+} bank_plugin_t;
+
+static int bank_index(clap_id id) {
+    return id >= BANK_FIRST_ID && id < BANK_FIRST_ID + BANK_PARAMS ? (int)(id - BANK_FIRST_ID) : -1;
+}
+
+/* Plugin descriptor */
+static const char *features[] = { CLAP_PLUGIN_FEATURE_INSTRUMENT, CLAP_PLUGIN_FEATURE_SYNTHESIZER, NULL };
+
+static const clap_plugin_descriptor_t s_desc = {
+    .clap_version = CLAP_VERSION,
+    .id = "test.bank",
+    .name = "Test Bank",
+    .vendor = "Test",
+    .url = "",
+    .manual_url = "",
+    .support_url = "",
+    .version = "1.0.0",
+    .description = "Test stub with a large param bank",
+    .features = features
+};
+
+/* Audio ports extension - output only (synth) */
+static uint32_t audio_ports_count(const clap_plugin_t *plugin, bool is_input) {
+    return is_input ? 0 : 1;
+}
+
+static bool audio_ports_get(const clap_plugin_t *plugin, uint32_t index, bool is_input, clap_audio_port_info_t *info) {
+    if (is_input || index != 0) return false;
+    info->id = 0;
+    strncpy(info->name, "Output", CLAP_NAME_SIZE);
+    info->channel_count = 2;
+    info->flags = CLAP_AUDIO_PORT_IS_MAIN;
+    info->port_type = CLAP_PORT_STEREO;
+    info->in_place_pair = CLAP_INVALID_ID;
+    return true;
+}
+
+static const clap_plugin_audio_ports_t s_audio_ports = {
+    .count = audio_ports_count,
+    .get = audio_ports_get
+};
+
+/* Params extension - all writable, 0..1, default 0 */
+static uint32_t params_count(const clap_plugin_t *plugin) { return BANK_PARAMS; }
+
+static bool params_get_info(const clap_plugin_t *plugin, uint32_t index, clap_param_info_t *info) {
+    if (index >= BANK_PARAMS) return false;
+    memset(info, 0, sizeof(*info));
+    info->id = BANK_FIRST_ID + index;
+    snprintf(info->name, CLAP_NAME_SIZE, "Param %u", index);
+    info->min_value = 0.0;
+    info->max_value = 1.0;
+    info->default_value = 0.0;
+    info->flags = CLAP_PARAM_IS_AUTOMATABLE;
+    return true;
+}
+
+static bool params_get_value(const clap_plugin_t *plugin, clap_id id, double *value) {
+    const bank_plugin_t *p = (const bank_plugin_t *)plugin->plugin_data;
+    int index = bank_index(id);
+    if (index < 0) return false;
+    *value = p->values[index];
+    return true;
+}
+
+static bool params_value_to_text(const clap_plugin_t *plugin, clap_id id, double value, char *display, uint32_t size) {
+    snprintf(display, size, "%.3f", value);
+    return true;
+}
+
+static bool params_text_to_value(const clap_plugin_t *plugin, clap_id id, const char *text, double *value) {
+    *value = atof(text);
+    return true;
+}
+
+static void params_flush(const clap_plugin_t *plugin, const clap_input_events_t *in, const clap_output_events_t *out) {
+    bank_plugin_t *p = (bank_plugin_t *)plugin->plugin_data;
+    for (uint32_t i = 0; i < in->size(in); i++) {
+        const clap_event_header_t *hdr = in->get(in, i);
+        if (hdr->space_id != CLAP_CORE_EVENT_SPACE_ID || hdr->type != CLAP_EVENT_PARAM_VALUE) continue;
+        const clap_event_param_value_t *ev = (const clap_event_param_value_t *)hdr;
+        int index = bank_index(ev->param_id);
+        if (index >= 0) p->values[index] = ev->value;
+    }
+}
+
+static const clap_plugin_params_t s_params = {
+    .count = params_count,
+    .get_info = params_get_info,
+    .get_value = params_get_value,
+    .value_to_text = params_value_to_text,
+    .text_to_value = params_text_to_value,
+    .flush = params_flush
+};
+
+/* Plugin methods */
+static bool plugin_init(const clap_plugin_t *plugin) { return true; }
+static void plugin_destroy(const clap_plugin_t *plugin) { free((void*)plugin); }
+static bool plugin_activate(const clap_plugin_t *plugin, double sr, uint32_t min, uint32_t max) { return true; }
+static void plugin_deactivate(const clap_plugin_t *plugin) {}
+static bool plugin_start_processing(const clap_plugin_t *plugin) { return true; }
+static void plugin_stop_processing(const clap_plugin_t *plugin) {}
+static void plugin_reset(const clap_plugin_t *plugin) {}
+
+static clap_process_status plugin_process(const clap_plugin_t *plugin, const clap_process_t *process) {
+    bank_plugin_t *p = (bank_plugin_t *)plugin->plugin_data;
+    bool seen[BANK_PARAMS] = { false };
+    int events = 0, repeats = 0;
+
+    uint32_t n = process->in_events->size(process->in_events);
+    for (uint32_t i = 0; i < n; i++) {
+        const clap_event_header_t *hdr = process->in_events->get(process->in_events, i);
+        if (hdr->space_id != CLAP_CORE_EVENT_SPACE_ID || hdr->type != CLAP_EVENT_PARAM_VALUE) continue;
+        const clap_event_param_value_t *ev = (const clap_event_param_value_t *)hdr;
+        int index = bank_index(ev->param_id);
+        if (index < 0) continue;
+        events++;
+        if (seen[index]) repeats++;
+        seen[index] = true;
+        p->values[index] = ev->value;
+    }
+
+    /* Left: the values, right: event counts */
+    float *l = process->audio_outputs[0].data32[0];
+    float *r = process->audio_outputs[0].data32[1];
+    memset(l, 0, process->frames_count * sizeof(float));
+    memset(r, 0, process->frames_count * sizeof(float));
+    for (uint32_t i = 0; i < BANK_PARAMS && i < process->frames_count; i++) l[i] = (float)p->values[i];
+    if (process->frames_count >= 2) {
+        r[0] = events / 1000.0f;
+        r[1] = repeats / 1000.0f;
+    }
+    return CLAP_PROCESS_CONTINUE;
+}
+
+static const void *plugin_get_extension(const clap_plugin_t *plugin, const char *id) {
+    if (!strcmp(id, CLAP_EXT_AUDIO_PORTS)) return &s_audio_ports;
+    if (!strcmp(id, CLAP_EXT_PARAMS)) return &s_params;
+    return NULL;
+}
+
+static void plugin_on_main_thread(const clap_plugin_t *plugin) {}
+
+/* Factory */
+static uint32_t factory_get_plugin_count(const clap_plugin_factory_t *factory) { return 1; }
+
+static const clap_plugin_descriptor_t *factory_get_plugin_descriptor(const clap_plugin_factory_t *factory, uint32_t index) {
+    return index == 0 ? &s_desc : NULL;
+}
+
+static const clap_plugin_t *factory_create_plugin(const clap_plugin_factory_t *factory, const clap_host_t *host, const char *plugin_id) {
+    if (strcmp(plugin_id, s_desc.id)) return NULL;
+
+    bank_plugin_t *p = (bank_plugin_t*)calloc(1, sizeof(bank_plugin_t));
+    p->plugin.desc = &s_desc;
+    p->plugin.plugin_data = p;
+    p->plugin.init = plugin_init;
+    p->plugin.destroy = plugin_destroy;
+    p->plugin.activate = plugin_activate;
+    p->plugin.deactivate = plugin_deactivate;
+    p->plugin.start_processing = plugin_start_processing;
+    p->plugin.stop_processing = plugin_stop_processing;
+    p->plugin.reset = plugin_reset;
+    p->plugin.process = plugin_process;
+    p->plugin.get_extension = plugin_get_extension;
+    p->plugin.on_main_thread = plugin_on_main_thread;
+    return &p->plugin;
+}
+
+static const clap_plugin_factory_t s_factory = {
+    .get_plugin_count = factory_get_plugin_count,
+    .get_plugin_descriptor = factory_get_plugin_descriptor,
+    .create_plugin = factory_create_plugin
+};
+
+/* Entry point */
+static bool entry_init(const char *path) { return true; }
+static void entry_deinit(void) {}
+static const void *entry_get_factory(const char *factory_id) {
+    return !strcmp(factory_id, CLAP_PLUGIN_FACTORY_ID) ? &s_factory : NULL;
+}
+
+CLAP_EXPORT const clap_plugin_entry_t clap_entry = {
+    .clap_version = CLAP_VERSION,
+    .init = entry_init,
+    .deinit = entry_deinit,
+    .get_factory = entry_get_factory
+};
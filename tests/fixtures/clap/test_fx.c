@@ -55,6 +55,8 @@ static clap_process_status plugin_process(const clap_plugin_t *plugin, const cla
     /* Pass-through */
     for (uint32_t c = 0; c < process->audio_outputs[0].channel_count; c++) {
         if (process->audio_inputs && process->audio_inputs[0].data32[c]) {
+            /* In-place: host may hand us the same buffer for input and output */
+            if (process->audio_outputs[0].data32[c] == process->audio_inputs[0].data32[c]) continue;
             memcpy(process->audio_outputs[0].data32[c],
                    process->audio_inputs[0].data32[c],
                    process->frames_count * sizeof(float));
@@ -0,0 +1,120 @@
+/*
+ * CLAP test stub - double-precision effect (ports prefer 64-bit, output = input * 0.5)
+ */
+#include <string.h>
+#include <stdlib.h>
+#include "clap/clap.h"
+
+/* Plugin descriptor */
+static const char *features[] = { CLAP_PLUGIN_FEATURE_AUDIO_EFFECT, NULL };
+
+static const clap_plugin_descriptor_t s_desc = {
+    .clap_version = CLAP_VERSION,
+    .id = "test.fx64",
+    .name = "Test FX 64",
+    .vendor = "Test",
+    .url = "",
+    .manual_url = "",
+    .support_url = "",
+    .version = "1.0.0",
+    .description = "Test stub for 64-bit audio",
+    .features = features
+};
+
+/* Audio ports extension - input and output, both preferring double */
+static uint32_t audio_ports_count(const clap_plugin_t *plugin, bool is_input) {
+    return 1;  /* Both input and output */
+}
+
+static bool audio_ports_get(const clap_plugin_t *plugin, uint32_t index, bool is_input, clap_audio_port_info_t *info) {
+    if (index != 0) return false;
+    info->id = is_input ? 0 : 1;
+    strncpy(info->name, is_input ? "Input" : "Output", CLAP_NAME_SIZE);
+    info->channel_count = 2;
+    info->flags = CLAP_AUDIO_PORT_IS_MAIN | CLAP_AUDIO_PORT_SUPPORTS_64BITS | CLAP_AUDIO_PORT_PREFERS_64BITS;
+    info->port_type = CLAP_PORT_STEREO;
+    info->in_place_pair = is_input ? 1 : 0;  /* Allow in-place */
+    return true;
+}
+
+static const clap_plugin_audio_ports_t s_audio_ports = {
+    .count = audio_ports_count,
+    .get = audio_ports_get
+};
+
+/* Plugin methods */
+static bool plugin_init(const clap_plugin_t *plugin) { return true; }
+static void plugin_destroy(const clap_plugin_t *plugin) { free((void*)plugin); }
+static bool plugin_activate(const clap_plugin_t *plugin, double sr, uint32_t min, uint32_t max) { return true; }
+static void plugin_deactivate(const clap_plugin_t *plugin) {}
+static bool plugin_start_processing(const clap_plugin_t *plugin) { return true; }
+static void plugin_stop_processing(const clap_plugin_t *plugin) {}
+static void plugin_reset(const clap_plugin_t *plugin) {}
+
+static clap_process_status plugin_process(const clap_plugin_t *plugin, const clap_process_t *process) {
+    /* Only double buffers are accepted - the host must honour PREFERS_64BITS */
+    const clap_audio_buffer_t *in = &process->audio_inputs[0];
+    const clap_audio_buffer_t *out = &process->audio_outputs[0];
+    if (!in->data64 || !out->data64 || in->data32 || out->data32) return CLAP_PROCESS_ERROR;
+
+    /* Half gain, in place when the host aliases the buffers */
+    for (uint32_t c = 0; c < out->channel_count; c++) {
+        for (uint32_t i = 0; i < process->frames_count; i++) {
+            out->data64[c][i] = in->data64[c][i] * 0.5;
+        }
+    }
+    return CLAP_PROCESS_CONTINUE;
+}
+
+static const void *plugin_get_extension(const clap_plugin_t *plugin, const char *id) {
+    if (!strcmp(id, CLAP_EXT_AUDIO_PORTS)) return &s_audio_ports;
+    return NULL;
+}
+
+static void plugin_on_main_thread(const clap_plugin_t *plugin) {}
+
+/* Factory */
+static uint32_t factory_get_plugin_count(const clap_plugin_factory_t *factory) { return 1; }
+
+static const clap_plugin_descriptor_t *factory_get_plugin_descriptor(const clap_plugin_factory_t *factory, uint32_t index) {
+    return index == 0 ? &s_desc : NULL;
+}
+
+static const clap_plugin_t *factory_create_plugin(const clap_plugin_factory_t *factory, const clap_host_t *host, const char *plugin_id) {
+    if (strcmp(plugin_id, s_desc.id)) return NULL;
+
+    clap_plugin_t *p = (clap_plugin_t*)calloc(1, sizeof(clap_plugin_t));
+    p->desc = &s_desc;
+    p->plugin_data = NULL;
+    p->init = plugin_init;
+    p->destroy = plugin_destroy;
+    p->activate = plugin_activate;
+    p->deactivate = plugin_deactivate;
+    p->start_processing = plugin_start_processing;
+    p->stop_processing = plugin_stop_processing;
+    p->reset = plugin_reset;
+    p->process = plugin_process;
+    p->get_extension = plugin_get_extension;
+    p->on_main_thread = plugin_on_main_thread;
+    return p;
+}
+
+static const clap_plugin_factory_t s_factory = {
+    .get_plugin_count = factory_get_plugin_count,
+    .get_plugin_descriptor = factory_get_plugin_descriptor,
+    .create_plugin = factory_create_plugin
+};
+
+/* Entry point */
+static bool entry_init(const char *path) { return true; }
+static void entry_deinit(void) {}
+static const void *entry_get_factory(const char *factory_id) {
+    return !strcmp(factory_id, CLAP_PLUGIN_FACTORY_ID) ? &s_factory : NULL;
+}
+
+CLAP_EXPORT const clap_plugin_entry_t clap_entry = {
+    .clap_version = CLAP_VERSION,
+    .init = entry_init,
+    .deinit = entry_deinit,
+    .get_factory = entry_get_factory
+};
@@ -11,6 +11,14 @@ typedef struct plugin_data {
     double cutoff;
     double resonance;
     double volume;
+    const clap_host_t *host;
+    clap_id timer;
+    int callbacks;          /* on_main_thread calls, reported as a read-only param */
+    int activations;        /* activate calls - a serviced request_restart adds one */
+    int audio_thread;       /* process() saw is_audio_thread && !is_main_thread */
+    int changed;            /* A param event arrived, state is marked dirty on the main thread */
+    int pages_swapped;      /* Odd presets list the remote-control pages the other way round */
+    int texts;              /* value_to_text calls, shown in the resonance text so caching is visible */
 } plugin_data_t;
 
 /* Parameter IDs */
@@ -18,7 +26,10 @@ enum {
     PARAM_CUTOFF = 0,
     PARAM_RESONANCE = 1,
     PARAM_VOLUME = 2,
-    PARAM_COUNT = 3
+    PARAM_CALLBACKS = 3,
+    PARAM_ACTIVATIONS = 4,
+    PARAM_AUDIO_THREAD = 5,
+    PARAM_COUNT = 6
 };
 
 /* Plugin descriptor */
@@ -47,7 +58,7 @@ static bool params_get_info(const clap_plugin_t *plugin, uint32_t index, clap_pa
         case PARAM_CUTOFF:
             info->id = PARAM_CUTOFF;
             strncpy(info->name, "Cutoff", CLAP_NAME_SIZE);
-            strncpy(info->module, "", CLAP_PATH_SIZE);
+            strncpy(info->module, "Filter", CLAP_PATH_SIZE);
             info->min_value = 20.0;
             info->max_value = 20000.0;
             info->default_value = 1000.0;
@@ -57,7 +68,7 @@ static bool params_get_info(const clap_plugin_t *plugin, uint32_t index, clap_pa
         case PARAM_RESONANCE:
             info->id = PARAM_RESONANCE;
             strncpy(info->name, "Resonance", CLAP_NAME_SIZE);
-            strncpy(info->module, "", CLAP_PATH_SIZE);
+            strncpy(info->module, "Filter", CLAP_PATH_SIZE);
             info->min_value = 0.0;
             info->max_value = 1.0;
             info->default_value = 0.0;
@@ -67,28 +78,80 @@ static bool params_get_info(const clap_plugin_t *plugin, uint32_t index, clap_pa
         case PARAM_VOLUME:
             info->id = PARAM_VOLUME;
             strncpy(info->name, "Volume", CLAP_NAME_SIZE);
-            strncpy(info->module, "", CLAP_PATH_SIZE);
+            strncpy(info->module, "Amp", CLAP_PATH_SIZE);
             info->min_value = 0.0;
             info->max_value = 1.0;
             info->default_value = 0.8;
             info->flags = CLAP_PARAM_IS_AUTOMATABLE;
             info->cookie = NULL;
             return true;
+        case PARAM_CALLBACKS:
+            info->id = PARAM_CALLBACKS;
+            strncpy(info->name, "Callbacks", CLAP_NAME_SIZE);
+            strncpy(info->module, "Info", CLAP_PATH_SIZE);
+            info->min_value = 0.0;
+            info->max_value = 1000000.0;
+            info->default_value = 0.0;
+            info->flags = CLAP_PARAM_IS_READONLY;
+            info->cookie = NULL;
+            return true;
+        case PARAM_ACTIVATIONS:
+            info->id = PARAM_ACTIVATIONS;
+            strncpy(info->name, "Activations", CLAP_NAME_SIZE);
+            strncpy(info->module, "Info", CLAP_PATH_SIZE);
+            info->min_value = 0.0;
+            info->max_value = 1000000.0;
+            info->default_value = 0.0;
+            info->flags = CLAP_PARAM_IS_READONLY;
+            info->cookie = NULL;
+            return true;
+        case PARAM_AUDIO_THREAD:
+            info->id = PARAM_AUDIO_THREAD;
+            strncpy(info->name, "Audio Thread", CLAP_NAME_SIZE);
+            strncpy(info->module, "Info", CLAP_PATH_SIZE);
+            info->min_value = 0.0;
+            info->max_value = 1.0;
+            info->default_value = 0.0;
+            info->flags = CLAP_PARAM_IS_READONLY | CLAP_PARAM_IS_STEPPED;
+            info->cookie = NULL;
+            return true;
     }
     return false;
 }
 
+/* Writable values - set from process() and state load, read from the main thread */
+static double *param_slot(plugin_data_t *data, clap_id id) {
+    switch (id) {
+        case PARAM_CUTOFF: return &data->cutoff;
+        case PARAM_RESONANCE: return &data->resonance;
+        case PARAM_VOLUME: return &data->volume;
+    }
+    return NULL;
+}
+
 static bool params_get_value(const clap_plugin_t *plugin, clap_id id, double *value) {
     plugin_data_t *data = (plugin_data_t *)plugin->plugin_data;
+    double *slot = param_slot(data, id);
+    if (slot) {
+        __atomic_load(slot, value, __ATOMIC_RELAXED);
+        return true;
+    }
     switch (id) {
-        case PARAM_CUTOFF: *value = data->cutoff; return true;
-        case PARAM_RESONANCE: *value = data->resonance; return true;
-        case PARAM_VOLUME: *value = data->volume; return true;
+        case PARAM_CALLBACKS: *value = __atomic_load_n(&data->callbacks, __ATOMIC_RELAXED); return true;
+        case PARAM_ACTIVATIONS: *value = __atomic_load_n(&data->activations, __ATOMIC_RELAXED); return true;
+        case PARAM_AUDIO_THREAD: *value = __atomic_load_n(&data->audio_thread, __ATOMIC_RELAXED); return true;
     }
     return false;
 }
 
 static bool params_value_to_text(const clap_plugin_t *plugin, clap_id id, double value, char *display, uint32_t size) {
+    plugin_data_t *data = (plugin_data_t *)plugin->plugin_data;
+    data->texts++;
+    switch (id) {
+        case PARAM_CUTOFF: snprintf(display, size, "%.0f Hz", value); return true;
+        case PARAM_RESONANCE: snprintf(display, size, "%.2f #%d", value, data->texts); return true;
+        case PARAM_VOLUME: snprintf(display, size, "%.0f %%", value * 100.0); return true;
+    }
     snprintf(display, size, "%.2f", value);
     return true;
 }
@@ -98,8 +161,20 @@ static bool params_text_to_value(const clap_plugin_t *plugin, clap_id id, const
     return true;
 }
 
+static void apply_param_events(plugin_data_t *data, const clap_input_events_t *in) {
+    for (uint32_t i = 0; i < in->size(in); i++) {
+        const clap_event_header_t *hdr = in->get(in, i);
+        if (hdr->space_id != CLAP_CORE_EVENT_SPACE_ID || hdr->type != CLAP_EVENT_PARAM_VALUE) continue;
+        const clap_event_param_value_t *ev = (const clap_event_param_value_t *)hdr;
+        double *slot = param_slot(data, ev->param_id);
+        if (!slot) continue;
+        __atomic_store(slot, &ev->value, __ATOMIC_RELAXED);
+        __atomic_store_n(&data->changed, 1, __ATOMIC_RELAXED);
+    }
+}
+
 static void params_flush(const clap_plugin_t *plugin, const clap_input_events_t *in, const clap_output_events_t *out) {
-    /* Process parameter change events */
+    apply_param_events((plugin_data_t *)plugin->plugin_data, in);
 }
 
 static const clap_plugin_params_t s_params = {
@@ -151,27 +226,136 @@ static const clap_plugin_note_ports_t s_note_ports = {
     .get = note_ports_get
 };
 
+/* Timer support extension - each tick asks for a main-thread callback */
+static void timer_on_timer(const clap_plugin_t *plugin, clap_id timer_id) {
+    plugin_data_t *data = (plugin_data_t *)plugin->plugin_data;
+    data->host->request_callback(data->host);
+}
+
+static const clap_plugin_timer_support_t s_timer_support = {
+    .on_timer = timer_on_timer
+};
+
+/* State extension - the three writable values */
+static bool state_save(const clap_plugin_t *plugin, const clap_ostream_t *stream) {
+    plugin_data_t *data = (plugin_data_t *)plugin->plugin_data;
+    double values[3];
+    for (int i = 0; i < 3; i++) __atomic_load(param_slot(data, (clap_id)i), &values[i], __ATOMIC_RELAXED);
+    return stream->write(stream, values, sizeof(values)) == (int64_t)sizeof(values);
+}
+
+static bool state_load(const clap_plugin_t *plugin, const clap_istream_t *stream) {
+    plugin_data_t *data = (plugin_data_t *)plugin->plugin_data;
+    double values[3];
+    if (stream->read(stream, values, sizeof(values)) != (int64_t)sizeof(values)) return false;
+    for (int i = 0; i < 3; i++) __atomic_store(param_slot(data, (clap_id)i), &values[i], __ATOMIC_RELAXED);
+    return true;
+}
+
+static const clap_plugin_state_t s_state = {
+    .save = state_save,
+    .load = state_load
+};
+
+/* Remote controls extension - "Main" (the writable params, 3 knobs free) and "Info" */
+static uint32_t remote_count(const clap_plugin_t *plugin) { return 2; }
+
+static bool remote_get(const clap_plugin_t *plugin, uint32_t page_index, clap_remote_controls_page_t *page) {
+    plugin_data_t *data = (plugin_data_t *)plugin->plugin_data;
+    if (page_index >= 2) return false;
+    bool main = (page_index == 0) != (data->pages_swapped != 0);
+    memset(page, 0, sizeof(*page));
+    page->page_id = main ? 0 : 1;
+    strncpy(page->page_name, main ? "Main" : "Info", CLAP_NAME_SIZE);
+    for (int i = 0; i < CLAP_REMOTE_CONTROLS_COUNT; i++) page->param_ids[i] = CLAP_INVALID_ID;
+    if (main) {
+        page->param_ids[0] = PARAM_CUTOFF;
+        page->param_ids[1] = PARAM_RESONANCE;
+        page->param_ids[2] = PARAM_VOLUME;
+    } else {
+        page->param_ids[0] = PARAM_CALLBACKS;
+        page->param_ids[1] = PARAM_ACTIVATIONS;
+        page->param_ids[2] = PARAM_AUDIO_THREAD;
+    }
+    return true;
+}
+
+static const clap_plugin_remote_controls_t s_remote_controls = {
+    .count = remote_count,
+    .get = remote_get
+};
+
+/* Preset load extension - preset N (load key "N") sets the cutoff to 100 + 10 * N */
+#define PRESET_COUNT 200
+
+static bool preset_from_location(const clap_plugin_t *plugin, uint32_t location_kind,
+                                 const char *location, const char *load_key) {
+    plugin_data_t *data = (plugin_data_t *)plugin->plugin_data;
+    if (location_kind != CLAP_PRESET_DISCOVERY_LOCATION_PLUGIN || !load_key) return false;
+    int n = atoi(load_key);
+    if (n < 0 || n >= PRESET_COUNT) return false;
+    double cutoff = 100.0 + 10.0 * n;
+    __atomic_store(&data->cutoff, &cutoff, __ATOMIC_RELAXED);
+
+    const clap_host_remote_controls_t *remote =
+        (const clap_host_remote_controls_t *)data->host->get_extension(data->host, CLAP_EXT_REMOTE_CONTROLS);
+    if ((n & 1) != data->pages_swapped) {
+        data->pages_swapped = n & 1;
+        if (remote) remote->changed(data->host);
+    }
+
+    const clap_host_preset_load_t *host_load =
+        (const clap_host_preset_load_t *)data->host->get_extension(data->host, CLAP_EXT_PRESET_LOAD);
+    if (host_load) host_load->loaded(data->host, location_kind, location, load_key);
+    return true;
+}
+
+static const clap_plugin_preset_load_t s_preset_load = {
+    .from_location = preset_from_location
+};
+
 /* Plugin methods */
 static bool plugin_init(const clap_plugin_t *plugin) {
     plugin_data_t *data = (plugin_data_t *)plugin->plugin_data;
     data->cutoff = 1000.0;
     data->resonance = 0.0;
     data->volume = 0.8;
+    data->timer = CLAP_INVALID_ID;
+
+    const clap_host_timer_support_t *timer =
+        (const clap_host_timer_support_t *)data->host->get_extension(data->host, CLAP_EXT_TIMER_SUPPORT);
+    if (timer) timer->register_timer(data->host, 10, &data->timer);
     return true;
 }
 
 static void plugin_destroy(const clap_plugin_t *plugin) {
+    plugin_data_t *data = (plugin_data_t *)plugin->plugin_data;
+    const clap_host_timer_support_t *timer =
+        (const clap_host_timer_support_t *)data->host->get_extension(data->host, CLAP_EXT_TIMER_SUPPORT);
+    if (timer && data->timer != CLAP_INVALID_ID) timer->unregister_timer(data->host, data->timer);
     free(plugin->plugin_data);
     free((void*)plugin);
 }
 
-static bool plugin_activate(const clap_plugin_t *plugin, double sr, uint32_t min, uint32_t max) { return true; }
+static bool plugin_activate(const clap_plugin_t *plugin, double sr, uint32_t min, uint32_t max) {
+    plugin_data_t *data = (plugin_data_t *)plugin->plugin_data;
+    __atomic_add_fetch(&data->activations, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
 static void plugin_deactivate(const clap_plugin_t *plugin) {}
 static bool plugin_start_processing(const clap_plugin_t *plugin) { return true; }
 static void plugin_stop_processing(const clap_plugin_t *plugin) {}
 static void plugin_reset(const clap_plugin_t *plugin) {}
 
 static clap_process_status plugin_process(const clap_plugin_t *plugin, const clap_process_t *process) {
+    plugin_data_t *data = (plugin_data_t *)plugin->plugin_data;
+    const clap_host_thread_check_t *check =
+        (const clap_host_thread_check_t *)data->host->get_extension(data->host, CLAP_EXT_THREAD_CHECK);
+    int on_audio = check && check->is_audio_thread(data->host) && !check->is_main_thread(data->host);
+    __atomic_store_n(&data->audio_thread, on_audio, __ATOMIC_RELAXED);
+    apply_param_events(data, process->in_events);
+
     /* Silence output */
     for (uint32_t c = 0; c < process->audio_outputs[0].channel_count; c++) {
         memset(process->audio_outputs[0].data32[c], 0, process->frames_count * sizeof(float));
@@ -183,10 +367,27 @@ static const void *plugin_get_extension(const clap_plugin_t *plugin, const char
     if (!strcmp(id, CLAP_EXT_AUDIO_PORTS)) return &s_audio_ports;
     if (!strcmp(id, CLAP_EXT_NOTE_PORTS)) return &s_note_ports;
     if (!strcmp(id, CLAP_EXT_PARAMS)) return &s_params;
+    if (!strcmp(id, CLAP_EXT_TIMER_SUPPORT)) return &s_timer_support;
+    if (!strcmp(id, CLAP_EXT_STATE)) return &s_state;
+    if (!strcmp(id, CLAP_EXT_PRESET_LOAD)) return &s_preset_load;
+    if (!strcmp(id, CLAP_EXT_REMOTE_CONTROLS)) return &s_remote_controls;
     return NULL;
 }
 
-static void plugin_on_main_thread(const clap_plugin_t *plugin) {}
+static void plugin_on_main_thread(const clap_plugin_t *plugin) {
+    plugin_data_t *data = (plugin_data_t *)plugin->plugin_data;
+    /* The third callback acts like a configuration change that needs reactivating */
+    if (__atomic_add_fetch(&data->callbacks, 1, __ATOMIC_RELAXED) == 3) {
+        data->host->request_restart(data->host);
+    }
+    const clap_host_params_t *params =
+        (const clap_host_params_t *)data->host->get_extension(data->host, CLAP_EXT_PARAMS);
+    if (params) params->rescan(data->host, CLAP_PARAM_RESCAN_VALUES);
+
+    const clap_host_state_t *state =
+        (const clap_host_state_t *)data->host->get_extension(data->host, CLAP_EXT_STATE);
+    if (state && __atomic_exchange_n(&data->changed, 0, __ATOMIC_RELAXED)) state->mark_dirty(data->host);
+}
 
 /* Factory */
 static uint32_t factory_get_plugin_count(const clap_plugin_factory_t *factory) { return 1; }
@@ -201,6 +402,7 @@ static const clap_plugin_t *factory_create_plugin(const clap_plugin_factory_t *f
     clap_plugin_t *p = (clap_plugin_t*)calloc(1, sizeof(clap_plugin_t));
     p->desc = &s_desc;
     p->plugin_data = calloc(1, sizeof(plugin_data_t));
+    ((plugin_data_t *)p->plugin_data)->host = host;
     p->init = plugin_init;
     p->destroy = plugin_destroy;
     p->activate = plugin_activate;
@@ -220,11 +422,85 @@ static const clap_plugin_factory_t s_factory = {
     .create_plugin = factory_create_plugin
 };
 
+/* Preset discovery - built-in presets, plus one for another plugin that must be skipped */
+static const clap_preset_discovery_provider_descriptor_t s_provider_desc = {
+    .clap_version = CLAP_VERSION,
+    .id = "test.param.presets",
+    .name = "Test Param Presets",
+    .vendor = "Test"
+};
+
+static bool provider_init(const clap_preset_discovery_provider_t *provider) {
+    const clap_preset_discovery_indexer_t *indexer = (const clap_preset_discovery_indexer_t *)provider->provider_data;
+    clap_preset_discovery_location_t location = {
+        .flags = CLAP_PRESET_DISCOVERY_IS_FACTORY_CONTENT,
+        .name = "Factory",
+        .kind = CLAP_PRESET_DISCOVERY_LOCATION_PLUGIN,
+        .location = NULL
+    };
+    return indexer->declare_location(indexer, &location);
+}
+
+static void provider_destroy(const clap_preset_discovery_provider_t *provider) {
+    free((void *)provider);
+}
+
+static bool provider_get_metadata(const clap_preset_discovery_provider_t *provider, uint32_t location_kind,
+                                  const char *location, const clap_preset_discovery_metadata_receiver_t *receiver) {
+    clap_universal_plugin_id_t ours = { "clap", "test.param" };
+    clap_universal_plugin_id_t other = { "clap", "test.other" };
+    char name[32], key[16];
+    for (int i = 0; i < PRESET_COUNT; i++) {
+        snprintf(name, sizeof(name), "Preset %03d", i);
+        snprintf(key, sizeof(key), "%d", i);
+        if (!receiver->begin_preset(receiver, name, key)) return false;
+        receiver->add_plugin_id(receiver, &ours);
+        receiver->set_flags(receiver, CLAP_PRESET_DISCOVERY_IS_FACTORY_CONTENT);
+    }
+    if (!receiver->begin_preset(receiver, "Other Plugin", "0")) return false;
+    receiver->add_plugin_id(receiver, &other);
+    return true;
+}
+
+static const void *provider_get_extension(const clap_preset_discovery_provider_t *provider, const char *id) {
+    return NULL;
+}
+
+static uint32_t preset_factory_count(const clap_preset_discovery_factory_t *factory) { return 1; }
+
+static const clap_preset_discovery_provider_descriptor_t *preset_factory_get_descriptor(
+    const clap_preset_discovery_factory_t *factory, uint32_t index) {
+    return index == 0 ? &s_provider_desc : NULL;
+}
+
+static const clap_preset_discovery_provider_t *preset_factory_create(
+    const clap_preset_discovery_factory_t *factory, const clap_preset_discovery_indexer_t *indexer,
+    const char *provider_id) {
+    if (strcmp(provider_id, s_provider_desc.id)) return NULL;
+    clap_preset_discovery_provider_t *p =
+        (clap_preset_discovery_provider_t *)calloc(1, sizeof(clap_preset_discovery_provider_t));
+    p->desc = &s_provider_desc;
+    p->provider_data = (void *)indexer;
+    p->init = provider_init;
+    p->destroy = provider_destroy;
+    p->get_metadata = provider_get_metadata;
+    p->get_extension = provider_get_extension;
+    return p;
+}
+
+static const clap_preset_discovery_factory_t s_preset_factory = {
+    .count = preset_factory_count,
+    .get_descriptor = preset_factory_get_descriptor,
+    .create = preset_factory_create
+};
+
 /* Entry point */
 static bool entry_init(const char *path) { return true; }
 static void entry_deinit(void) {}
 static const void *entry_get_factory(const char *factory_id) {
-    return !strcmp(factory_id, CLAP_PLUGIN_FACTORY_ID) ? &s_factory : NULL;
+    if (!strcmp(factory_id, CLAP_PLUGIN_FACTORY_ID)) return &s_factory;
+    if (!strcmp(factory_id, CLAP_PRESET_DISCOVERY_FACTORY_ID)) return &s_preset_factory;
+    return NULL;
 }
 
 CLAP_EXPORT const clap_plugin_entry_t clap_entry = {
@@ -0,0 +1,154 @@
+/*
+ * CLAP test stub - thread pool (audio out, tasks run through host request_exec)
+ *
+ * The host thread pool extension is fetched lazily in the first process() call,
+ * not at init. Every block splits its work into POOL_TEST_TASKS tasks and outputs:
+ *   0.5   all tasks ran on the host pool (request_exec returned true)
+ *   0.25  request_exec returned false and the plugin ran them itself
+ *   0.0   a task was skipped or ran twice
+ */
+#include <string.h>
+#include <stdlib.h>
+#include "clap/clap.h"
+
+#define POOL_TEST_TASKS 16
+
+static const char *features[] = { CLAP_PLUGIN_FEATURE_INSTRUMENT, NULL };
+
+static const clap_plugin_descriptor_t s_desc = {
+    .clap_version = CLAP_VERSION,
+    .id = "test.pool",
+    .name = "Test Pool",
+    .vendor = "Test",
+    .url = "",
+    .manual_url = "",
+    .support_url = "",
+    .version = "1.0.0",
+    .description = "Test stub for the host thread pool",
+    .features = features
+};
+
+typedef struct {
+    clap_plugin_t plugin;
+    const clap_host_t *host;
+    const clap_host_thread_pool_t *host_pool;
+    int runs[POOL_TEST_TASKS];   /* Times each task ran this block */
+} pool_plugin_t;
+
+/* Audio ports extension - output only */
+static uint32_t audio_ports_count(const clap_plugin_t *plugin, bool is_input) {
+    return is_input ? 0 : 1;
+}
+
+static bool audio_ports_get(const clap_plugin_t *plugin, uint32_t index, bool is_input, clap_audio_port_info_t *info) {
+    if (is_input || index != 0) return false;
+    info->id = 0;
+    strncpy(info->name, "Output", CLAP_NAME_SIZE);
+    info->channel_count = 2;
+    info->flags = CLAP_AUDIO_PORT_IS_MAIN;
+    info->port_type = CLAP_PORT_STEREO;
+    info->in_place_pair = CLAP_INVALID_ID;
+    return true;
+}
+
+static const clap_plugin_audio_ports_t s_audio_ports = {
+    .count = audio_ports_count,
+    .get = audio_ports_get
+};
+
+/* Thread pool extension - tasks may run on any worker */
+static void pool_exec(const clap_plugin_t *plugin, uint32_t task_index) {
+    pool_plugin_t *p = (pool_plugin_t *)plugin->plugin_data;
+    if (task_index < POOL_TEST_TASKS) __atomic_add_fetch(&p->runs[task_index], 1, __ATOMIC_RELAXED);
+}
+
+static const clap_plugin_thread_pool_t s_thread_pool = {
+    .exec = pool_exec
+};
+
+/* Plugin methods */
+static bool plugin_init(const clap_plugin_t *plugin) { return true; }
+static void plugin_destroy(const clap_plugin_t *plugin) { free((void*)plugin); }
+static bool plugin_activate(const clap_plugin_t *plugin, double sr, uint32_t min, uint32_t max) { return true; }
+static void plugin_deactivate(const clap_plugin_t *plugin) {}
+static bool plugin_start_processing(const clap_plugin_t *plugin) { return true; }
+static void plugin_stop_processing(const clap_plugin_t *plugin) {}
+static void plugin_reset(const clap_plugin_t *plugin) {}
+
+static clap_process_status plugin_process(const clap_plugin_t *plugin, const clap_process_t *process) {
+    pool_plugin_t *p = (pool_plugin_t *)plugin->plugin_data;
+    if (!p->host_pool) {
+        p->host_pool = (const clap_host_thread_pool_t *)p->host->get_extension(p->host, CLAP_EXT_THREAD_POOL);
+    }
+
+    memset(p->runs, 0, sizeof(p->runs));
+    bool pooled = p->host_pool && p->host_pool->request_exec(p->host, POOL_TEST_TASKS);
+    if (!pooled) {
+        for (uint32_t i = 0; i < POOL_TEST_TASKS; i++) pool_exec(plugin, i);
+    }
+
+    float value = pooled ? 0.5f : 0.25f;
+    for (uint32_t i = 0; i < POOL_TEST_TASKS; i++) {
+        if (__atomic_load_n(&p->runs[i], __ATOMIC_RELAXED) != 1) value = 0.0f;
+    }
+    for (uint32_t c = 0; c < process->audio_outputs[0].channel_count; c++) {
+        float *dst = process->audio_outputs[0].data32[c];
+        for (uint32_t i = 0; i < process->frames_count; i++) dst[i] = value;
+    }
+    return CLAP_PROCESS_CONTINUE;
+}
+
+static const void *plugin_get_extension(const clap_plugin_t *plugin, const char *id) {
+    if (!strcmp(id, CLAP_EXT_AUDIO_PORTS)) return &s_audio_ports;
+    if (!strcmp(id, CLAP_EXT_THREAD_POOL)) return &s_thread_pool;
+    return NULL;
+}
+
+static void plugin_on_main_thread(const clap_plugin_t *plugin) {}
+
+/* Factory */
+static uint32_t factory_get_plugin_count(const clap_plugin_factory_t *factory) { return 1; }
+
+static const clap_plugin_descriptor_t *factory_get_plugin_descriptor(const clap_plugin_factory_t *factory, uint32_t index) {
+    return index == 0 ? &s_desc : NULL;
+}
+
+static const clap_plugin_t *factory_create_plugin(const clap_plugin_factory_t *factory, const clap_host_t *host, const char *plugin_id) {
+    if (strcmp(plugin_id, s_desc.id)) return NULL;
+
+    pool_plugin_t *p = (pool_plugin_t*)calloc(1, sizeof(pool_plugin_t));
+    p->host = host;
+    p->plugin.desc = &s_desc;
+    p->plugin.plugin_data = p;
+    p->plugin.init = plugin_init;
+    p->plugin.destroy = plugin_destroy;
+    p->plugin.activate = plugin_activate;
+    p->plugin.deactivate = plugin_deactivate;
+    p->plugin.start_processing = plugin_start_processing;
+    p->plugin.stop_processing = plugin_stop_processing;
+    p->plugin.reset = plugin_reset;
+    p->plugin.process = plugin_process;
+    p->plugin.get_extension = plugin_get_extension;
+    p->plugin.on_main_thread = plugin_on_main_thread;
+    return &p->plugin;
+}
+
+static const clap_plugin_factory_t s_factory = {
+    .get_plugin_count = factory_get_plugin_count,
+    .get_plugin_descriptor = factory_get_plugin_descriptor,
+    .create_plugin = factory_create_plugin
+};
+
+/* Entry point */
+static bool entry_init(const char *path) { return true; }
+static void entry_deinit(void) {}
+static const void *entry_get_factory(const char *factory_id) {
+    return !strcmp(factory_id, CLAP_PLUGIN_FACTORY_ID) ? &s_factory : NULL;
+}
+
+CLAP_EXPORT const clap_plugin_entry_t clap_entry = {
+    .clap_version = CLAP_VERSION,
+    .init = entry_init,
+    .deinit = entry_deinit,
+    .get_factory = entry_get_factory
+};
@@ -0,0 +1,193 @@
+/*
+ * CLAP test stub - sleep/wake statuses
+ *
+ * Pass-through effect with a MIDI input that adds 0.5 DC while a note is held.
+ * One descriptor per process status:
+ *   0 test.sleep       returns CLAP_PROCESS_SLEEP
+ *   1 test.tail        returns CLAP_PROCESS_TAIL, no tail extension
+ *   2 test.tail.long   returns CLAP_PROCESS_TAIL, tail of SLEEP_TEST_TAIL frames
+ *   3 test.quiet       returns CLAP_PROCESS_CONTINUE_IF_NOT_QUIET
+ */
+#include <string.h>
+#include <stdlib.h>
+#include "clap/clap.h"
+
+#define SLEEP_TEST_TAIL 512
+
+static const char *features[] = { CLAP_PLUGIN_FEATURE_AUDIO_EFFECT, NULL };
+
+#define SLEEP_DESC(id_, name_) {                      \
+    .clap_version = CLAP_VERSION,                     \
+    .id = id_,                                        \
+    .name = name_,                                    \
+    .vendor = "Test",                                 \
+    .url = "",                                        \
+    .manual_url = "",                                 \
+    .support_url = "",                                \
+    .version = "1.0.0",                               \
+    .description = "Test stub for sleep and tail",    \
+    .features = features                             \
+}
+
+static const clap_plugin_descriptor_t s_descs[] = {
+    SLEEP_DESC("test.sleep", "Test Sleep"),
+    SLEEP_DESC("test.tail", "Test Tail"),
+    SLEEP_DESC("test.tail.long", "Test Long Tail"),
+    SLEEP_DESC("test.quiet", "Test Quiet"),
+};
+static const clap_process_status s_statuses[] = {
+    CLAP_PROCESS_SLEEP,
+    CLAP_PROCESS_TAIL,
+    CLAP_PROCESS_TAIL,
+    CLAP_PROCESS_CONTINUE_IF_NOT_QUIET,
+};
+#define DESC_COUNT (sizeof(s_descs) / sizeof(s_descs[0]))
+
+typedef struct {
+    clap_plugin_t plugin;
+    uint32_t index;       /* Into s_descs */
+    int held;             /* Notes currently held */
+} sleep_plugin_t;
+
+/* Audio ports extension - stereo in and out */
+static uint32_t audio_ports_count(const clap_plugin_t *plugin, bool is_input) {
+    return 1;
+}
+
+static bool audio_ports_get(const clap_plugin_t *plugin, uint32_t index, bool is_input, clap_audio_port_info_t *info) {
+    if (index != 0) return false;
+    info->id = is_input ? 0 : 1;
+    strncpy(info->name, is_input ? "Input" : "Output", CLAP_NAME_SIZE);
+    info->channel_count = 2;
+    info->flags = CLAP_AUDIO_PORT_IS_MAIN;
+    info->port_type = CLAP_PORT_STEREO;
+    info->in_place_pair = CLAP_INVALID_ID;
+    return true;
+}
+
+static const clap_plugin_audio_ports_t s_audio_ports = {
+    .count = audio_ports_count,
+    .get = audio_ports_get
+};
+
+/* Note ports extension - MIDI input */
+static uint32_t note_ports_count(const clap_plugin_t *plugin, bool is_input) {
+    return is_input ? 1 : 0;
+}
+
+static bool note_ports_get(const clap_plugin_t *plugin, uint32_t index, bool is_input, clap_note_port_info_t *info) {
+    if (!is_input || index != 0) return false;
+    info->id = 0;
+    info->supported_dialects = CLAP_NOTE_DIALECT_MIDI;
+    info->preferred_dialect = CLAP_NOTE_DIALECT_MIDI;
+    strncpy(info->name, "MIDI In", CLAP_NAME_SIZE);
+    return true;
+}
+
+static const clap_plugin_note_ports_t s_note_ports = {
+    .count = note_ports_count,
+    .get = note_ports_get
+};
+
+/* Tail extension - only exposed by test.tail.long */
+static uint32_t tail_get(const clap_plugin_t *plugin) { return SLEEP_TEST_TAIL; }
+
+static const clap_plugin_tail_t s_tail = {
+    .get = tail_get
+};
+
+/* Plugin methods */
+static bool plugin_init(const clap_plugin_t *plugin) { return true; }
+static void plugin_destroy(const clap_plugin_t *plugin) { free((void*)plugin); }
+static bool plugin_activate(const clap_plugin_t *plugin, double sr, uint32_t min, uint32_t max) { return true; }
+static void plugin_deactivate(const clap_plugin_t *plugin) {}
+static bool plugin_start_processing(const clap_plugin_t *plugin) { return true; }
+static void plugin_stop_processing(const clap_plugin_t *plugin) {}
+static void plugin_reset(const clap_plugin_t *plugin) {}
+
+static clap_process_status plugin_process(const clap_plugin_t *plugin, const clap_process_t *process) {
+    sleep_plugin_t *p = (sleep_plugin_t *)plugin->plugin_data;
+
+    uint32_t n = process->in_events->size(process->in_events);
+    for (uint32_t i = 0; i < n; i++) {
+        const clap_event_header_t *hdr = process->in_events->get(process->in_events, i);
+        if (hdr->space_id != CLAP_CORE_EVENT_SPACE_ID || hdr->type != CLAP_EVENT_MIDI) continue;
+        const clap_event_midi_t *in = (const clap_event_midi_t *)hdr;
+        uint8_t status = in->data[0] & 0xF0;
+        if (status == 0x90 && in->data[2] > 0) {
+            p->held++;
+        } else if ((status == 0x80 || status == 0x90) && p->held > 0) {
+            p->held--;
+        }
+    }
+
+    /* Input plus DC while a note is held */
+    float dc = p->held > 0 ? 0.5f : 0.0f;
+    for (uint32_t c = 0; c < process->audio_outputs[0].channel_count; c++) {
+        const float *src = process->audio_inputs ? process->audio_inputs[0].data32[c] : NULL;
+        float *dst = process->audio_outputs[0].data32[c];
+        for (uint32_t i = 0; i < process->frames_count; i++) {
+            dst[i] = (src ? src[i] : 0.0f) + dc;
+        }
+    }
+    return s_statuses[p->index];
+}
+
+static const void *plugin_get_extension(const clap_plugin_t *plugin, const char *id) {
+    const sleep_plugin_t *p = (const sleep_plugin_t *)plugin->plugin_data;
+    if (!strcmp(id, CLAP_EXT_AUDIO_PORTS)) return &s_audio_ports;
+    if (!strcmp(id, CLAP_EXT_NOTE_PORTS)) return &s_note_ports;
+    if (!strcmp(id, CLAP_EXT_TAIL) && p->index == 2) return &s_tail;
+    return NULL;
+}
+
+static void plugin_on_main_thread(const clap_plugin_t *plugin) {}
+
+/* Factory */
+static uint32_t factory_get_plugin_count(const clap_plugin_factory_t *factory) { return DESC_COUNT; }
+
+static const clap_plugin_descriptor_t *factory_get_plugin_descriptor(const clap_plugin_factory_t *factory, uint32_t index) {
+    return index < DESC_COUNT ? &s_descs[index] : NULL;
+}
+
+static const clap_plugin_t *factory_create_plugin(const clap_plugin_factory_t *factory, const clap_host_t *host, const char *plugin_id) {
+    uint32_t index = 0;
+    while (index < DESC_COUNT && strcmp(plugin_id, s_descs[index].id)) index++;
+    if (index == DESC_COUNT) return NULL;
+
+    sleep_plugin_t *p = (sleep_plugin_t*)calloc(1, sizeof(sleep_plugin_t));
+    p->index = index;
+    p->plugin.desc = &s_descs[index];
+    p->plugin.plugin_data = p;
+    p->plugin.init = plugin_init;
+    p->plugin.destroy = plugin_destroy;
+    p->plugin.activate = plugin_activate;
+    p->plugin.deactivate = plugin_deactivate;
+    p->plugin.start_processing = plugin_start_processing;
+    p->plugin.stop_processing = plugin_stop_processing;
+    p->plugin.reset = plugin_reset;
+    p->plugin.process = plugin_process;
+    p->plugin.get_extension = plugin_get_extension;
+    p->plugin.on_main_thread = plugin_on_main_thread;
+    return &p->plugin;
+}
+
+static const clap_plugin_factory_t s_factory = {
+    .get_plugin_count = factory_get_plugin_count,
+    .get_plugin_descriptor = factory_get_plugin_descriptor,
+    .create_plugin = factory_create_plugin
+};
+
+/* Entry point */
+static bool entry_init(const char *path) { return true; }
+static void entry_deinit(void) {}
+static const void *entry_get_factory(const char *factory_id) {
+    return !strcmp(factory_id, CLAP_PLUGIN_FACTORY_ID) ? &s_factory : NULL;
+}
+
+CLAP_EXPORT const clap_plugin_entry_t clap_entry = {
+    .clap_version = CLAP_VERSION,
+    .init = entry_init,
+    .deinit = entry_deinit,
+    .get_factory = entry_get_factory
+};
@@ -3,6 +3,7 @@
  */
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "clap/clap.h"
 
 /* Plugin descriptor */
@@ -61,6 +62,9 @@ static const clap_plugin_note_ports_t s_note_ports = {
     .get = note_ports_get
 };
 
+/* Milliseconds every process() takes, set by CC 126 - sandbox test */
+static int s_stall_ms = 0;
+
 /* Plugin methods */
 static bool plugin_init(const clap_plugin_t *plugin) { return true; }
 static void plugin_destroy(const clap_plugin_t *plugin) { free((void*)plugin); }
@@ -75,6 +79,31 @@ static clap_process_status plugin_process(const clap_plugin_t *plugin, const cla
     for (uint32_t c = 0; c < process->audio_outputs[0].channel_count; c++) {
         memset(process->audio_outputs[0].data32[c], 0, process->frames_count * sizeof(float));
     }
+
+    /* Echo note ons as MIDI out, end the voice on note off (MIDI dialect) */
+    uint32_t n = process->in_events->size(process->in_events);
+    for (uint32_t i = 0; i < n; i++) {
+        const clap_event_header_t *hdr = process->in_events->get(process->in_events, i);
+        if (hdr->space_id != CLAP_CORE_EVENT_SPACE_ID || hdr->type != CLAP_EVENT_MIDI) continue;
+        const clap_event_midi_t *in = (const clap_event_midi_t *)hdr;
+        uint8_t status = in->data[0] & 0xF0;
+        if (status == 0xB0 && in->data[1] == 127) abort();  /* Crash on demand - sandbox test */
+        if (status == 0xB0 && in->data[1] == 126) s_stall_ms = in->data[2];
+        if (status == 0x90 && in->data[2] > 0) {
+            process->out_events->try_push(process->out_events, hdr);
+        } else if (status == 0x80 || status == 0x90) {
+            clap_event_note_t end = {
+                .header = { sizeof(clap_event_note_t), hdr->time, CLAP_CORE_EVENT_SPACE_ID, CLAP_EVENT_NOTE_END, 0 },
+                .note_id = -1,
+                .port_index = 0,
+                .channel = (int16_t)(in->data[0] & 0x0F),
+                .key = in->data[1],
+                .velocity = 0.0
+            };
+            process->out_events->try_push(process->out_events, &end.header);
+        }
+    }
+    if (s_stall_ms > 0) usleep(s_stall_ms * 1000);
     return CLAP_PROCESS_CONTINUE;
 }
 
@@ -0,0 +1,22 @@
+#!/bin/sh
+# Build the fixtures, then build and run each C test against src/dsp/clap_host.c
+#
+# Tests run from the repo root so fixture paths resolve. Extra compiler flags
+# (e.g. -fsanitize=address,undefined or -DCLAP_HOST_PERF) can be passed in CFLAGS.
+set -e
+
+cd "$(dirname "$0")/.."
+CC="${CC:-cc}"
+mkdir -p build/tests
+
+./tests/build_fixtures.sh
+
+for src in tests/test_*.c; do
+    name="$(basename "$src" .c)"
+    $CC -O1 -g -Wall $CFLAGS -Isrc -Isrc/dsp -Ithird_party/clap/include \
+        "$src" src/dsp/clap_host.c -o "build/tests/$name" -ldl -lpthread -lm
+    echo "== $name"
+    "./build/tests/$name" > "build/tests/$name.log" 2>&1 || { cat "build/tests/$name.log"; echo "FAIL: $name"; exit 1; }
+done
+
+echo "All tests passed!"
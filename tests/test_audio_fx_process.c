@@ -2,10 +2,20 @@
  * Test CLAP audio FX processing (for Signal Chain integration)
  */
 #include <assert.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include "dsp/clap_host.h"
 
+/* Re-activates back and forth, as restarts serviced by the main loop do */
+static void *restart_thread(void *arg) {
+    clap_instance_t *inst = (clap_instance_t *)arg;
+    for (int i = 0; i < 100; i++) {
+        assert(clap_reconfigure(inst, 44100.0, (i & 1) ? 64 : 128) == 0);
+    }
+    return NULL;
+}
+
 int main(void) {
     printf("Testing CLAP audio FX processing...\n");
 
@@ -34,6 +44,66 @@ int main(void) {
     printf("First input: %f, first output: %f\n", in[0], out[0]);
     assert(out[0] == in[0]);  /* Pass-through should match */
 
+    /* test_fx pairs its main ports, so int16 processing runs in-place */
+    assert(inst.in_place);
+    int16_t audio[128 * 2];
+    for (int i = 0; i < 128 * 2; i++) {
+        audio[i] = (int16_t)((i & 1) ? -8192 : 16384);
+    }
+    rc = clap_process_block_i16(&inst, audio, audio, 128);
+    printf("In-place process returned: %d, first samples: %d %d\n", rc, audio[0], audio[1]);
+    assert(rc == 0);
+    assert(audio[0] >= 16383 && audio[0] <= 16384);
+    assert(audio[1] >= -8192 && audio[1] <= -8191);
+
+    /* Blocks longer than the activated maximum are split into chunks */
+    static int16_t long_block[512 * 2];
+    for (int i = 0; i < 512 * 2; i++) {
+        long_block[i] = (int16_t)(i * 8);
+    }
+    rc = clap_process_block_i16(&inst, long_block, long_block, 512);
+    printf("Chunked process (max %d) returned: %d, last sample: %d\n", inst.max_frames, rc, long_block[1023]);
+    assert(rc == 0);
+    assert(inst.max_frames < 512);
+    assert(long_block[1023] >= 1023 * 8 - 1 && long_block[1023] <= 1023 * 8);
+
+    /* Re-activation picks up a new rate and block size */
+    rc = clap_reconfigure(&inst, 48000.0, 64);
+    assert(rc == 0);
+    assert(inst.sample_rate == 48000.0 && inst.max_frames == 64);
+    rc = clap_process_block(&inst, in, out, 128);
+    assert(rc == 0);
+    assert(out[255] == in[255]);
+
+    /* A process call that never returns makes re-activation fail and leaves the
+       buffers it may still be using alone */
+    void *io = inst.io;
+    inst.in_process = 1;
+    rc = clap_reconfigure(&inst, 44100.0, 128);
+    assert(rc == -1);
+    assert(inst.io == io && inst.max_frames == 64 && inst.suspend == 0);
+    inst.in_process = 0;
+    rc = clap_process_block(&inst, in, out, 128);
+    assert(rc == 0);
+
+    /* test_fx has no latency; a half-dry mix of a pass-through is still the input */
+    assert(clap_latency(&inst) == 0);
+    assert(clap_set_mix(&inst, 0.5f) == 0);
+    for (int i = 0; i < 128 * 2; i++) in[i] = (i & 1) ? -0.25f : 0.5f;
+    rc = clap_process_block(&inst, in, out, 128);
+    assert(rc == 0);
+    assert(out[0] == 0.5f && out[255] == -0.25f);
+
+    /* Mix and latency from the UI thread while re-activation replaces the dry ring */
+    pthread_t restarts;
+    assert(pthread_create(&restarts, NULL, restart_thread, &inst) == 0);
+    for (int i = 0; i < 100; i++) {
+        assert(clap_set_mix(&inst, (i & 1) ? 0.5f : 0.75f) == 0);
+        assert(clap_latency(&inst) == 0);
+        assert(clap_process_block(&inst, in, out, 64) == 0);
+    }
+    pthread_join(restarts, NULL);
+
     clap_unload_plugin(&inst);
 
     printf("All tests passed!\n");
@@ -11,9 +11,11 @@ echo "Testing build outputs..."
 [ -f dist/clap/dsp.so ] || { echo "FAIL: dist/clap/dsp.so not found"; exit 1; }
 [ -f dist/clap/module.json ] || { echo "FAIL: dist/clap/module.json not found"; exit 1; }
 [ -f dist/clap/ui.js ] || { echo "FAIL: dist/clap/ui.js not found"; exit 1; }
+[ -x dist/clap/clap-sandbox ] || { echo "FAIL: dist/clap/clap-sandbox not found"; exit 1; }
 
 # Check audio FX
 [ -d dist/chain_audio_fx/clap ] || { echo "FAIL: dist/chain_audio_fx/clap/ not found"; exit 1; }
 [ -f dist/chain_audio_fx/clap/clap.so ] || { echo "FAIL: dist/chain_audio_fx/clap/clap.so not found"; exit 1; }
+[ -x dist/chain_audio_fx/clap/clap-sandbox ] || { echo "FAIL: dist/chain_audio_fx/clap/clap-sandbox not found"; exit 1; }
 
 echo "All build outputs present!"
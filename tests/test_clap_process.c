@@ -28,10 +28,64 @@ int main(void) {
     /* Verify output buffer was touched (synth outputs silence, which is fine) */
     printf("First sample: %f\n", out[0]);
 
+    /* Plugin output events: echoed MIDI is readable, NOTE_END ends the voice */
+    const uint8_t note_on[3] = { 0x90, 60, 100 };
+    const uint8_t note_off[3] = { 0x80, 60, 0 };
+    uint8_t msg[3];
+    clap_send_midi(&inst, note_on, 3);
+    rc = clap_process_block(&inst, NULL, out, 128);
+    assert(rc == 0);
+    assert(clap_active_voices(&inst) == 1);
+    assert(clap_midi_out_read(&inst, msg) == 3);
+    assert(msg[0] == 0x90 && msg[1] == 60);
+    assert(clap_midi_out_read(&inst, msg) == 0);
+
+    /* Short messages (program change) are accepted */
+    const uint8_t program[2] = { 0xC0, 5 };
+    assert(clap_send_midi(&inst, program, 2) == 0);
+
+    clap_send_midi(&inst, note_off, 3);
+    rc = clap_process_block(&inst, NULL, out, 128);
+    assert(rc == 0);
+    assert(clap_active_voices(&inst) == 0);
+
+    /* Batch render alongside a second instance - MIDI queues are per instance */
+    clap_instance_t inst2 = {0};
+    assert(clap_load_plugin("tests/fixtures/clap/test_synth.clap", 0, &inst2) == 0);
+    clap_set_batch(&inst, true);
+    clap_set_batch(&inst2, true);
+    int16_t batch_out[2][128 * 2];
+    clap_batch_item_t items[2] = {
+        { &inst, NULL, batch_out[0], 128, -1 },
+        { &inst2, NULL, batch_out[1], 128, -1 }
+    };
+    clap_send_midi(&inst2, note_on, 3);
+    rc = clap_process_batch_i16(items, 2);
+    assert(rc == 0);
+    assert(items[0].result == 0 && items[1].result == 0);
+    assert(clap_active_voices(&inst) == 0);
+    assert(clap_active_voices(&inst2) == 1);
+    clap_unload_plugin(&inst2);
+
     /* Unload */
     clap_unload_plugin(&inst);
     assert(inst.plugin == NULL);
 
+    /* simple_synth never sends NOTE_END - note offs end its voices instead */
+    clap_instance_t simple = {0};
+    assert(clap_load_plugin("tests/fixtures/clap/simple_synth.clap", 0, &simple) == 0);
+    for (int i = 0; i < 3; i++) {
+        const uint8_t vel0[3] = { 0x90, 64, 0 };
+        clap_send_midi(&simple, note_on, 3);
+        assert(clap_process_block(&simple, NULL, out, 128) == 0);
+        assert(clap_active_voices(&simple) == 1);
+        clap_send_midi(&simple, i == 2 ? vel0 : note_off, 3);
+        if (i == 2) clap_send_midi(&simple, note_off, 3);
+        assert(clap_process_block(&simple, NULL, out, 128) == 0);
+        assert(clap_active_voices(&simple) == 0);
+    }
+    clap_unload_plugin(&simple);
+
     printf("All tests passed!\n");
     return 0;
 }
@@ -0,0 +1,128 @@
+/*
+ * Test the host logger: levels, the writer thread, rate limiting and file rotation
+ */
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "dsp/clap_host.h"
+
+#define LOG_FILE "test_log.txt"
+#define LOG_FILE_OLD "test_log.txt.1"
+#define PRODUCERS 4
+#define PRODUCER_RECORDS 2000
+
+static int s_sink_lines = 0;
+
+static void count_sink(const char *msg) {
+    (void)msg;
+    __atomic_add_fetch(&s_sink_lines, 1, __ATOMIC_RELAXED);
+}
+
+/* Lines in a file containing text, 0 if it doesn't exist */
+static int count_lines(const char *path, const char *text) {
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    char line[512];
+    int n = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (strstr(line, text)) n++;
+    }
+    fclose(f);
+    return n;
+}
+
+/* Logs from an audio thread with no logger open */
+static void *audio_thread(void *arg) {
+    clap_instance_t *inst = (clap_instance_t *)arg;
+    float out[128 * 2];
+    assert(clap_process_block(inst, NULL, out, 128) == 0);
+    CLAP_HOST_LOG(CLAP_HOST_LOG_ERROR, "test", "from audio %d", 1);
+    return NULL;
+}
+
+static void *producer(void *arg) {
+    for (int i = 0; i < PRODUCER_RECORDS; i++) {
+        CLAP_HOST_LOG(CLAP_HOST_LOG_INFO, "test", "flood %ld %d", (long)arg, i);
+    }
+    return NULL;
+}
+
+int main(void) {
+    printf("Testing CLAP host logger...\n");
+    remove(LOG_FILE);
+    remove(LOG_FILE_OLD);
+
+    /* Level names round-trip */
+    char buf[16];
+    assert(clap_log_level_parse("debug") == CLAP_HOST_LOG_DEBUG);
+    assert(clap_log_level_parse("warn") == CLAP_HOST_LOG_WARN);
+    assert(clap_log_level_parse("1") == CLAP_HOST_LOG_WARN);
+    assert(clap_log_level_parse("bogus") == CLAP_HOST_LOG_INFO);
+    assert(clap_log_level_format(CLAP_HOST_LOG_ERROR, buf, sizeof(buf)) > 0);
+    assert(strcmp(buf, "error") == 0);
+
+    /* Without a logger, an audio thread's records aren't written to stderr there - they
+       are counted and reported by the next writer */
+    clap_instance_t inst = {0};
+    assert(clap_load_plugin("tests/fixtures/clap/test_synth.clap", 0, &inst) == 0);
+    pthread_t audio;
+    pthread_create(&audio, NULL, audio_thread, &inst);
+    pthread_join(audio, NULL);
+    clap_unload_plugin(&inst);
+    clap_log_open(LOG_FILE, 1 << 20, NULL);
+    clap_log_close();
+    assert(count_lines(LOG_FILE, "from audio") == 0);
+    assert(count_lines(LOG_FILE, "1 dropped") == 1);
+    remove(LOG_FILE);
+
+    /* Records below the runtime level are not written */
+    clap_log_open(LOG_FILE, 1 << 20, count_sink);
+    clap_log_set_level(CLAP_HOST_LOG_INFO);
+    assert(clap_log_get_level() == CLAP_HOST_LOG_INFO);
+    CLAP_HOST_LOG(CLAP_HOST_LOG_DEBUG, "test", "hidden %d", 1);
+    CLAP_HOST_LOG(CLAP_HOST_LOG_INFO, "test", "shown %d", 1);
+    clap_log_close();
+    assert(count_lines(LOG_FILE, "[test] shown 1") == 1);
+    assert(count_lines(LOG_FILE, "hidden") == 0);
+    assert(s_sink_lines == 1);
+
+    /* A flood from several threads never blocks them; the writer holds it to the rate
+       limit and reports what it skipped. Errors are exempt from the limit. */
+    clap_log_open(LOG_FILE, 1 << 20, count_sink);
+    pthread_t threads[PRODUCERS];
+    for (long i = 0; i < PRODUCERS; i++) pthread_create(&threads[i], NULL, producer, (void *)i);
+    for (int i = 0; i < PRODUCERS; i++) pthread_join(threads[i], NULL);
+    usleep(200000);
+    for (int i = 0; i < 50; i++) {
+        CLAP_HOST_LOG(CLAP_HOST_LOG_ERROR, "test", "error %d", i);
+        if (i % 10 == 9) usleep(20000);
+    }
+    usleep(200000);
+    clap_log_close();
+    int flood = count_lines(LOG_FILE, "flood");
+    printf("Flood records written: %d of %d\n", flood, PRODUCERS * PRODUCER_RECORDS);
+    assert(flood > 0 && flood < PRODUCERS * PRODUCER_RECORDS);
+    assert(count_lines(LOG_FILE, "error ") == 50);
+    assert(count_lines(LOG_FILE, "records over the rate limit") >= 1);
+
+    /* The file is rotated once it passes its size cap */
+    clap_log_open(LOG_FILE, 1024, NULL);
+    for (int i = 0; i < 60; i++) {
+        CLAP_HOST_LOG(CLAP_HOST_LOG_ERROR, "test", "rotate %d", i);
+        if (i % 10 == 9) usleep(20000);
+    }
+    clap_log_close();
+    assert(access(LOG_FILE_OLD, F_OK) == 0);
+    FILE *f = fopen(LOG_FILE, "r");
+    assert(f);
+    fseek(f, 0, SEEK_END);
+    assert(ftell(f) < 2048);
+    fclose(f);
+
+    remove(LOG_FILE);
+    remove(LOG_FILE_OLD);
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -3,7 +3,10 @@
  */
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include "dsp/clap_host.h"
+#include "clap/clap.h"
 
 int main(void) {
     printf("Testing CLAP parameter enumeration...\n");
@@ -26,7 +29,126 @@ int main(void) {
     rc = clap_param_info(&inst, 0, name, sizeof(name), &min, &max, &def);
     printf("Param 0: %s (min=%f, max=%f, def=%f)\n", name, min, max, def);
     assert(rc == 0);
+    assert(clap_param_info(&inst, count, name, sizeof(name), &min, &max, &def) == -1);
 
+    /* Module paths group params for navigation */
+    assert(clap_param_module(&inst, 0, name, sizeof(name)) > 0);
+    assert(strcmp(name, "Filter") == 0);
+    assert(clap_param_module(&inst, 2, name, sizeof(name)) > 0);
+    assert(strcmp(name, "Amp") == 0);
+    assert(clap_param_module(&inst, count, name, sizeof(name)) == -1);
+
+    /* Values come from the host-side table, set is visible immediately */
+    assert(clap_param_get(&inst, 0) == def);
+    assert(clap_param_set(&inst, 0, max) == 0);
+    assert(clap_param_get(&inst, 0) == max);
+
+    /* Display text comes from the plugin, and is only re-rendered when the value changes */
+    assert(clap_param_text(&inst, 0, name, sizeof(name)) > 0);
+    assert(strcmp(name, "20000 Hz") == 0);
+    assert(clap_param_text(&inst, 1, name, sizeof(name)) > 0);
+    assert(strcmp(name, "0.00 #2") == 0);
+    assert(clap_param_text(&inst, 1, name, sizeof(name)) > 0);
+    assert(strcmp(name, "0.00 #2") == 0);
+    assert(clap_param_set(&inst, 1, 0.5) == 0);
+    assert(clap_param_text(&inst, 1, name, sizeof(name)) > 0);
+    assert(strcmp(name, "0.50 #3") == 0);
+    assert(clap_param_text(&inst, count, name, sizeof(name)) == -1);
+
+    /* The generation moves with values, so an unchanged UI can skip re-reading */
+    uint32_t gen = clap_param_generation(&inst);
+    assert(clap_param_generation(&inst) == gen);
+    assert(clap_param_set(&inst, 2, 0.5) == 0);
+    assert(clap_param_generation(&inst) != gen);
+
+    /* Knob pages come from the plugin's remote controls */
+    assert(clap_remote_page_count(&inst) == 2);
+    assert(clap_remote_page_name(&inst, 0, name, sizeof(name)) > 0);
+    assert(strcmp(name, "Main") == 0);
+    assert(clap_remote_param(&inst, 0, 1) == 1);
+    assert(clap_remote_param(&inst, 0, 3) == -1);
+    assert(clap_remote_param(&inst, 1, 0) == 3);
+    assert(clap_remote_param(&inst, 2, 0) == -1);
+
+    /* test_param's timer requests callbacks; the main loop delivers them and the
+       plugin reports the count through a read-only param */
+    int callbacks = 0;
+    for (int i = 0; i < 200 && callbacks == 0; i++) {
+        usleep(10000);
+        callbacks = (int)clap_param_get(&inst, 3);
+    }
+    printf("Main-thread callbacks: %d\n", callbacks);
+    assert(callbacks > 0);
+
+    /* Timers and fds belong to the instance that registered them - another plugin's
+       host can't modify or remove them (each instance's host starts with clap_host_t) */
+    clap_instance_t other = {0};
+    assert(clap_load_plugin("tests/fixtures/clap/test_param.clap", 0, &other) == 0);
+    const clap_host_t *host = (const clap_host_t *)inst.host;
+    const clap_host_t *other_host = (const clap_host_t *)other.host;
+    const clap_host_timer_support_t *timers =
+        (const clap_host_timer_support_t *)host->get_extension(host, CLAP_EXT_TIMER_SUPPORT);
+    const clap_host_posix_fd_support_t *fds =
+        (const clap_host_posix_fd_support_t *)host->get_extension(host, CLAP_EXT_POSIX_FD_SUPPORT);
+    clap_id timer_id;
+    assert(timers->register_timer(host, 1000, &timer_id));
+    assert(!timers->unregister_timer(other_host, timer_id));
+    assert(timers->unregister_timer(host, timer_id));
+    int pipe_fds[2];
+    assert(pipe(pipe_fds) == 0);
+    assert(fds->register_fd(host, pipe_fds[0], CLAP_POSIX_FD_READ));
+    assert(!fds->modify_fd(other_host, pipe_fds[0], CLAP_POSIX_FD_READ | CLAP_POSIX_FD_WRITE));
+    assert(!fds->unregister_fd(other_host, pipe_fds[0]));
+    assert(fds->modify_fd(host, pipe_fds[0], CLAP_POSIX_FD_READ | CLAP_POSIX_FD_ERROR));
+    assert(fds->unregister_fd(host, pipe_fds[0]));
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    clap_unload_plugin(&other);
+
+    /* The process thread is the plugin's audio thread, not its main thread */
+    int16_t out[128 * 2];
+    assert(clap_process_block_i16(&inst, NULL, out, 128) == 0);
+    double on_audio = 0.0;
+    for (int i = 0; i < 200 && on_audio == 0.0; i++) {
+        usleep(10000);
+        on_audio = clap_param_get(&inst, 5);
+    }
+    assert(on_audio == 1.0);
+
+    /* The third callback requests a restart, which the main loop services by reactivating */
+    int activations = 0;
+    for (int i = 0; i < 200 && activations < 2; i++) {
+        usleep(10000);
+        activations = (int)clap_param_get(&inst, 4);
+    }
+    printf("Activations: %d\n", activations);
+    assert(activations >= 2);
+    assert(clap_process_block_i16(&inst, NULL, out, 128) == 0);
+
+    clap_unload_plugin(&inst);
+
+    /* Changes made between two blocks are coalesced to one event per param, the last
+       value wins and none are dropped - test_bank reports what it received */
+    assert(clap_load_plugin("tests/fixtures/clap/test_bank.clap", 0, &inst) == 0);
+    int bank = clap_param_count(&inst);
+    assert(bank == 100);
+    float seen[128 * 2];
+    for (int i = 0; i < bank; i++) assert(clap_param_set(&inst, i, (i + 1) / 128.0) == 0);
+    for (int i = 0; i < bank; i += 3) assert(clap_param_set(&inst, i, (i + 1) / 256.0) == 0);
+    assert(clap_process_block(&inst, NULL, seen, 128) == 0);
+    for (int i = 0; i < bank; i++) {
+        float want = (float)((i + 1) / (i % 3 == 0 ? 256.0 : 128.0));
+        assert(seen[i * 2] == want);
+        assert(clap_param_get(&inst, i) == (i + 1) / (i % 3 == 0 ? 256.0 : 128.0));
+    }
+    printf("Param events in one block: %.0f\n", seen[1] * 1000.0f);
+    assert((int)(seen[1] * 1000.0f + 0.5f) == bank);
+    assert(seen[3] == 0.0f);
+
+    /* Nothing left over for the next block */
+    assert(clap_process_block(&inst, NULL, seen, 128) == 0);
+    assert(seen[1] == 0.0f);
+    assert(seen[2 * 98] == (float)(99 / 128.0));
     clap_unload_plugin(&inst);
 
     printf("All tests passed!\n");
@@ -0,0 +1,65 @@
+/*
+ * Test process-time stats (full checks need clap_host.c built with -DCLAP_HOST_PERF)
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dsp/clap_host.h"
+
+/* Number after "key": in the stats JSON, searching from start */
+static double stat_value(const char *json, const char *start, const char *key) {
+    const char *p = strstr(json, start);
+    assert(p);
+    p = strstr(p, key);
+    assert(p);
+    return atof(p + strlen(key) + 1);  /* Past the colon */
+}
+
+int main(void) {
+    printf("Testing CLAP process-time stats...\n");
+
+    clap_instance_t inst = {0};
+    assert(clap_load_plugin("tests/fixtures/clap/test_synth.clap", 0, &inst) == 0);
+
+    char buf[1024];
+    int16_t out[128 * 2];
+    if (clap_perf_stats(&inst, buf, sizeof(buf)) < 0) {
+        /* Built without CLAP_HOST_PERF - stats are off and reset is a no-op */
+        clap_perf_reset(&inst);
+        assert(clap_process_block_i16(&inst, NULL, out, 128) == 0);
+        clap_unload_plugin(&inst);
+        printf("Built without CLAP_HOST_PERF, stats disabled\n");
+        printf("All tests passed!\n");
+        return 0;
+    }
+
+    /* Hold a note so the synth doesn't sleep, then process some blocks */
+    const uint8_t note_on[3] = { 0x90, 60, 100 };
+    assert(clap_send_midi(&inst, note_on, 3) == 0);
+    for (int i = 0; i < 50; i++) assert(clap_process_block_i16(&inst, NULL, out, 128) == 0);
+
+    assert(clap_perf_stats(&inst, buf, sizeof(buf)) > 0);
+    printf("%s\n", buf);
+    assert(stat_value(buf, "{", "\"blocks\"") == 50);
+    assert(stat_value(buf, "{", "\"budget_us\"") > 2900 && stat_value(buf, "{", "\"budget_us\"") < 2905);
+    double min = stat_value(buf, "\"plugin\"", "\"min_us\"");
+    double p50 = stat_value(buf, "\"plugin\"", "\"p50_us\"");
+    double p99 = stat_value(buf, "\"plugin\"", "\"p99_us\"");
+    double max = stat_value(buf, "\"plugin\"", "\"max_us\"");
+    assert(min > 0 && min <= p50 && p50 <= p99 && p99 <= max);
+    assert(stat_value(buf, "\"host\"", "\"max_us\"") > 0);
+
+    /* A too-small buffer is an error, not a truncated object */
+    assert(clap_perf_stats(&inst, buf, 16) == -1);
+
+    /* Reset clears at the next block, which is then the only one counted */
+    clap_perf_reset(&inst);
+    assert(clap_process_block_i16(&inst, NULL, out, 128) == 0);
+    assert(clap_perf_stats(&inst, buf, sizeof(buf)) > 0);
+    assert(stat_value(buf, "{", "\"blocks\"") == 1);
+
+    clap_unload_plugin(&inst);
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Test the preset catalog (preset-discovery factory + preset-load)
+ */
+#include <assert.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "dsp/clap_host.h"
+
+#define PARAM_PLUGIN "tests/fixtures/clap/test_param.clap"
+
+int main(void) {
+    printf("Testing CLAP preset catalog...\n");
+
+    char dir[] = "/tmp/clap_presets_XXXXXX";
+    assert(mkdtemp(dir) != NULL);
+
+    clap_instance_t inst = {0};
+    assert(clap_load_plugin(PARAM_PLUGIN, 0, &inst) == 0);
+    assert(clap_preset_count(&inst) == 0);
+    assert(clap_preset_load(&inst, 0) == -1);
+
+    /* Indexing runs in the background; presets for other plugins are skipped */
+    assert(clap_presets_index(&inst, dir) == 0);
+    int count = 0;
+    for (int i = 0; i < 500 && count == 0; i++) {
+        usleep(10000);
+        count = clap_preset_count(&inst);
+    }
+    printf("Presets: %d\n", count);
+    assert(count == 200);
+
+    char name[64];
+    assert(clap_preset_name(&inst, 7, name, sizeof(name)) > 0);
+    assert(strcmp(name, "Preset 007") == 0);
+    assert(clap_preset_name(&inst, count, name, sizeof(name)) == -1);
+
+    /* Loading a preset is one call; the param table picks up the new values */
+    assert(clap_preset_current(&inst) == -1);
+    assert(clap_preset_load(&inst, 5) == 0);
+    assert(clap_preset_current(&inst) == 5);
+    assert(clap_param_count(&inst) > 0);
+    assert(clap_param_get(&inst, 0) == 150.0);
+
+    /* Odd presets reorder the knob pages; the plugin reports it and the table is re-read */
+    assert(clap_remote_page_name(&inst, 0, name, sizeof(name)) > 0);
+    assert(strcmp(name, "Info") == 0);
+    assert(clap_remote_param(&inst, 1, 0) == 0);
+    clap_unload_plugin(&inst);
+
+    /* The next load maps the index file without crawling again */
+    assert(clap_load_plugin(PARAM_PLUGIN, 0, &inst) == 0);
+    assert(clap_presets_index(&inst, dir) == 0);
+    assert(clap_preset_count(&inst) == 200);
+    assert(clap_preset_load(&inst, 199) == 0);
+    assert(clap_param_count(&inst) > 0);
+    assert(clap_param_get(&inst, 0) == 2090.0);
+    clap_unload_plugin(&inst);
+
+    /* A damaged index is crawled again rather than mapped: first a string offset past
+       the end of the file (entries follow the 24-byte header), then a pool that isn't
+       NUL-terminated */
+    char index_file[1024] = "";
+    DIR *d = opendir(dir);
+    struct dirent *de;
+    while (d && (de = readdir(d)) != NULL) {
+        if (strstr(de->d_name, ".clappresets")) snprintf(index_file, sizeof(index_file), "%s/%s", dir, de->d_name);
+    }
+    if (d) closedir(d);
+    assert(index_file[0]);
+    for (int damage = 0; damage < 2; damage++) {
+        FILE *f = fopen(index_file, "r+b");
+        assert(f);
+        if (damage == 0) {
+            uint32_t bad = 0x7fffffff;
+            fseek(f, 24, SEEK_SET);
+            assert(fwrite(&bad, sizeof(bad), 1, f) == 1);
+        } else {
+            fseek(f, -1, SEEK_END);
+            assert(fputc('X', f) == 'X');
+        }
+        fclose(f);
+
+        assert(clap_load_plugin(PARAM_PLUGIN, 0, &inst) == 0);
+        assert(clap_presets_index(&inst, dir) == 0);
+        count = 0;
+        for (int i = 0; i < 500 && count == 0; i++) {
+            usleep(10000);
+            count = clap_preset_count(&inst);
+        }
+        assert(count == 200);
+        assert(clap_preset_name(&inst, 0, name, sizeof(name)) > 0);
+        assert(strcmp(name, "Preset 000") == 0);
+        clap_unload_plugin(&inst);
+
+        /* The crawl rewrote the file */
+        f = fopen(index_file, "rb");
+        assert(f);
+        fseek(f, -1, SEEK_END);
+        assert(fgetc(f) == 0);
+        fclose(f);
+    }
+
+    /* A plugin without preset discovery has no catalog */
+    assert(clap_load_plugin("tests/fixtures/clap/test_synth.clap", 0, &inst) == 0);
+    assert(clap_presets_index(&inst, dir) == -1);
+    assert(clap_preset_count(&inst) == 0);
+    assert(clap_remote_page_count(&inst) == (clap_param_count(&inst) + 7) / 8);
+    clap_unload_plugin(&inst);
+
+    d = opendir(dir);
+    char path[1024];
+    while (d && (de = readdir(d)) != NULL) {
+        if (de->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+        unlink(path);
+    }
+    if (d) closedir(d);
+    rmdir(dir);
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * Test 64-bit processing: plugins preferring double get data64 buffers
+ */
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include "dsp/clap_host.h"
+
+int main(void) {
+    printf("Testing CLAP 64-bit processing...\n");
+
+    /* test_fx64 fails process() unless it gets data64 buffers only */
+    clap_instance_t inst = {0};
+    assert(clap_load_plugin("tests/fixtures/clap/test_fx64.clap", 0, &inst) == 0);
+    assert(inst.in_place);
+
+    /* int16 round trip through double: half gain, within the last bit */
+    int16_t audio[128 * 2];
+    for (int i = 0; i < 128 * 2; i++) {
+        audio[i] = (int16_t)((i & 1) ? -8192 : 16384);
+    }
+    assert(clap_process_block_i16(&inst, audio, audio, 128) == 0);
+    printf("int16 out: %d %d\n", audio[0], audio[1]);
+    assert(audio[0] >= 8191 && audio[0] <= 8192);
+    assert(audio[1] >= -4096 && audio[1] <= -4095);
+
+    /* Float path */
+    float in[127 * 2];
+    float out[127 * 2];
+    for (int i = 0; i < 127 * 2; i++) in[i] = (i & 1) ? -0.25f : 0.5f;
+    assert(clap_process_block(&inst, in, out, 127) == 0);
+    assert(out[0] == 0.25f && out[1] == -0.125f);
+
+    /* Dry/wet on double outputs, odd length for the scalar tail:
+       0.5 wet + 0.5 dry of a half-gain plugin is 0.75 of the input */
+    assert(clap_set_mix(&inst, 0.5f) == 0);
+    for (int b = 0; b < 2; b++) {
+        assert(clap_process_block(&inst, in, out, 127) == 0);
+    }
+    for (int i = 0; i < 127 * 2; i++) {
+        assert(fabsf(out[i] - in[i] * 0.75f) < 1e-6f);
+    }
+
+    clap_unload_plugin(&inst);
+    printf("All tests passed!\n");
+    return 0;
+}
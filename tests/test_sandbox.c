@@ -0,0 +1,142 @@
+/*
+ * Test sandboxed (out-of-process) plugin hosting
+ *
+ * The test binary doubles as the sandbox helper, like clap-sandbox.
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "dsp/clap_host.h"
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], CLAP_SANDBOX_ARG) == 0) {
+        return clap_sandbox_child_main(argc, argv);
+    }
+    printf("Testing sandboxed plugin hosting...\n");
+
+    clap_instance_t inst = {0};
+    int rc = clap_load_plugin_sandboxed("/proc/self/exe", "tests/fixtures/clap/test_synth.clap", 0, &inst);
+    printf("Load returned: %d\n", rc);
+    assert(rc == 0);
+    assert(inst.sandbox != NULL);
+
+    /* MIDI round-trips through the child: test_synth echoes note ons */
+    const uint8_t note_on[3] = { 0x90, 60, 100 };
+    uint8_t msg[3];
+    int16_t out[128 * 2];
+    clap_send_midi(&inst, note_on, 3);
+    rc = clap_process_block_i16(&inst, NULL, out, 128);
+    assert(rc == 0);
+    assert(clap_midi_out_read(&inst, msg) == 3);
+    assert(msg[0] == 0x90 && msg[1] == 60);
+    printf("IPC overhead: %.1f us\n", clap_sandbox_ipc_us(&inst));
+    assert(clap_sandbox_ipc_us(&inst) > 0.0);
+
+    /* A crash in the child passes audio through while it restarts */
+    const uint8_t crash[3] = { 0xB0, 127, 127 };
+    clap_send_midi(&inst, crash, 3);
+    rc = clap_process_block_i16(&inst, NULL, out, 128);
+    assert(rc == 0);
+    for (int i = 0; i < 500 && clap_sandbox_restarts(&inst) == 0; i++) {
+        rc = clap_process_block_i16(&inst, NULL, out, 128);
+        assert(rc == 0);
+        usleep(10000);
+    }
+    printf("Restarts: %d\n", clap_sandbox_restarts(&inst));
+    assert(clap_sandbox_restarts(&inst) == 1);
+
+    clap_send_midi(&inst, note_on, 3);
+    rc = clap_process_block_i16(&inst, NULL, out, 128);
+    assert(rc == 0);
+    assert(clap_midi_out_read(&inst, msg) == 3);
+
+    /* A child that answers every block late is slow, not hung: it isn't restarted, and
+       events sent while it is behind reach it with a later block instead of being lost */
+    const uint8_t stall[3] = { 0xB0, 126, 5 };
+    const uint8_t unstall[3] = { 0xB0, 126, 0 };
+    clap_send_midi(&inst, stall, 3);
+    int sent = 0, echoed = 0;
+    for (int i = 0; i < 400; i++) {
+        if (i % 4 == 0) {
+            const uint8_t note[3] = { 0x90, (uint8_t)(i / 4 % 128), 100 };
+            clap_send_midi(&inst, note, 3);
+            sent++;
+        }
+        if (i == 399) clap_send_midi(&inst, unstall, 3);
+        rc = clap_process_block_i16(&inst, NULL, out, 128);
+        assert(rc == 0);
+        while (clap_midi_out_read(&inst, msg) == 3) echoed++;
+        usleep(2000);
+    }
+    for (int i = 0; i < 100 && echoed < sent; i++) {
+        rc = clap_process_block_i16(&inst, NULL, out, 128);
+        assert(rc == 0);
+        while (clap_midi_out_read(&inst, msg) == 3) echoed++;
+        usleep(10000);
+    }
+    printf("Slow child: %d of %d notes echoed, restarts %d\n", echoed, sent, clap_sandbox_restarts(&inst));
+    assert(echoed == sent);
+    assert(clap_sandbox_restarts(&inst) == 1);
+
+    clap_unload_plugin(&inst);
+    assert(inst.sandbox == NULL);
+
+    /* Voices end across the sandbox: note offs end simple_synth's (it never sends NOTE_END),
+       and test_synth's NOTE_END comes back from the child */
+    const char *synths[] = { "tests/fixtures/clap/simple_synth.clap", "tests/fixtures/clap/test_synth.clap" };
+    const uint8_t note_off[3] = { 0x80, 60, 0 };
+    for (int s = 0; s < 2; s++) {
+        rc = clap_load_plugin_sandboxed("/proc/self/exe", synths[s], 0, &inst);
+        assert(rc == 0);
+        for (int round = 0; round < 2; round++) {
+            clap_send_midi(&inst, note_on, 3);
+            assert(clap_process_block_i16(&inst, NULL, out, 128) == 0);
+            clap_send_midi(&inst, note_off, 3);
+            for (int i = 0; i < 100 && clap_active_voices(&inst) != 0; i++) {
+                assert(clap_process_block_i16(&inst, NULL, out, 128) == 0);
+                usleep(2000);
+            }
+            assert(clap_active_voices(&inst) == 0);
+        }
+        clap_unload_plugin(&inst);
+    }
+
+    /* State goes through the child, and blobs name the sandboxed plugin - not the proxy -
+       so they move between sandboxed and in-process instances */
+    rc = clap_load_plugin_sandboxed("/proc/self/exe", "tests/fixtures/clap/test_param.clap", 0, &inst);
+    assert(rc == 0);
+    assert(clap_param_set(&inst, 0, 500.0) == 0);
+    for (int i = 0; i < 10; i++) {
+        assert(clap_process_block_i16(&inst, NULL, out, 128) == 0);
+        usleep(2000);
+    }
+    uint8_t *blob = NULL;
+    size_t len = 0;
+    assert(clap_state_save(&inst, &blob, &len) == 0);
+    clap_instance_t local = {0};
+    assert(clap_load_plugin("tests/fixtures/clap/test_param.clap", 0, &local) == 0);
+    assert(clap_state_load(&local, blob, len) == 0);
+    assert(clap_param_get(&local, 0) == 500.0);
+    free(blob);
+
+    assert(clap_param_set(&local, 0, 250.0) == 0);
+    assert(clap_process_block_i16(&local, NULL, out, 128) == 0);
+    assert(clap_state_save(&local, &blob, &len) == 0);
+    assert(clap_state_load(&inst, blob, len) == 0);
+    assert(clap_param_get(&inst, 0) == 250.0);
+    free(blob);
+    clap_unload_plugin(&local);
+
+    /* A clone of a sandboxed instance is sandboxed too, with the source's state */
+    clap_instance_t clone = {0};
+    assert(clap_clone_plugin(&inst, &clone) == 0);
+    assert(clone.sandbox != NULL);
+    assert(clap_param_get(&clone, 0) == 250.0);
+    clap_unload_plugin(&clone);
+    clap_unload_plugin(&inst);
+
+    printf("All tests passed!\n");
+    return 0;
+}
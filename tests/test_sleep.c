@@ -0,0 +1,102 @@
+/*
+ * Test sleep and wake on the SLEEP, TAIL and CONTINUE_IF_NOT_QUIET process statuses
+ */
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "dsp/clap_host.h"
+
+#define FIXTURE "tests/fixtures/clap/test_sleep.clap"
+#define FRAMES 128
+
+static const uint8_t s_note_on[3] = { 0x90, 60, 100 };
+static const uint8_t s_note_off[3] = { 0x80, 60, 0 };
+
+/* Process n blocks of constant input, return the first output sample */
+static int16_t run(clap_instance_t *inst, int16_t level, int n) {
+    int16_t in[FRAMES * 2];
+    int16_t out[FRAMES * 2];
+    for (int i = 0; i < FRAMES * 2; i++) in[i] = level;
+    for (int b = 0; b < n; b++) {
+        memset(out, 0, sizeof(out));
+        assert(clap_process_block_i16(inst, in, out, FRAMES) == 0);
+    }
+    return out[0];
+}
+
+/* int16 -> float -> int16 may lose the last bit */
+static bool near(int16_t got, int16_t want) {
+    return got >= want - 1 && got <= want;
+}
+
+static void load(clap_instance_t *inst, int index) {
+    assert(clap_load_plugin(FIXTURE, index, inst) == 0);
+    assert(!inst->sleeping);
+}
+
+int main(void) {
+    printf("Testing CLAP sleep and wake...\n");
+    clap_instance_t inst;
+
+    /* SLEEP: stops after every block, input or a note wakes it */
+    load(&inst, 0);
+    run(&inst, 0, 1);
+    assert(inst.sleeping);
+    run(&inst, 0, 4);
+    assert(inst.sleeping && inst.sleep_frames >= 4 * FRAMES);
+    assert(near(run(&inst, 8192, 1), 8192));
+    assert(inst.sleeping);
+    assert(clap_send_midi(&inst, s_note_on, 3) == 0);
+    assert(run(&inst, 0, 1) >= 16383);
+    clap_unload_plugin(&inst);
+
+    /* TAIL without a tail extension: a zero-length tail must not cut held notes
+       or steady input, only silence in and out puts it to sleep */
+    load(&inst, 1);
+    run(&inst, 0, 1);
+    assert(inst.sleeping);
+    assert(clap_send_midi(&inst, s_note_on, 3) == 0);
+    assert(run(&inst, 0, 20) >= 16383);
+    assert(!inst.sleeping);
+    assert(clap_send_midi(&inst, s_note_off, 3) == 0);
+    assert(run(&inst, 0, 1) == 0);
+    assert(!inst.sleeping);
+    run(&inst, 0, 1);
+    assert(inst.sleeping);
+    assert(near(run(&inst, 4096, 20), 4096));
+    assert(!inst.sleeping);
+    run(&inst, 0, 1);
+    assert(inst.sleeping);
+    clap_unload_plugin(&inst);
+
+    /* TAIL with a 512-frame tail: sleeps once that much silence has passed */
+    load(&inst, 2);
+    assert(inst.tail_frames == 512);
+    assert(clap_send_midi(&inst, s_note_on, 3) == 0);
+    assert(run(&inst, 0, 20) >= 16383);
+    assert(clap_send_midi(&inst, s_note_off, 3) == 0);
+    run(&inst, 0, 1);
+    run(&inst, 0, 3);
+    assert(!inst.sleeping);
+    run(&inst, 0, 1);
+    assert(inst.sleeping);
+    clap_unload_plugin(&inst);
+
+    /* CONTINUE_IF_NOT_QUIET: runs while sounding, sleeps on the first quiet block */
+    load(&inst, 3);
+    assert(clap_send_midi(&inst, s_note_on, 3) == 0);
+    assert(run(&inst, 0, 20) >= 16383);
+    assert(!inst.sleeping);
+    assert(clap_send_midi(&inst, s_note_off, 3) == 0);
+    run(&inst, 0, 1);
+    assert(!inst.sleeping);
+    run(&inst, 0, 1);
+    assert(inst.sleeping);
+    assert(near(run(&inst, 4096, 1), 4096));
+    assert(!inst.sleeping);
+    clap_unload_plugin(&inst);
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * Test the host thread pool: request_exec for plugins that fetch the extension after init
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "dsp/clap_host.h"
+
+#define FIXTURE "tests/fixtures/clap/test_pool.clap"
+#define FRAMES 128
+
+/* Process one block, return the first output sample (see test_pool.c for the values) */
+static int16_t run(clap_instance_t *inst) {
+    int16_t out[FRAMES * 2];
+    assert(clap_process_block_i16(inst, NULL, out, FRAMES) == 0);
+    return out[0];
+}
+
+/* Process until the main loop has started workers for the instance, max ~1 s */
+static void wait_for_pool(clap_instance_t *inst) {
+    for (int i = 0; i < 100 && !__atomic_load_n(&inst->thread_pool, __ATOMIC_ACQUIRE); i++) {
+        run(inst);
+        usleep(10000);
+    }
+    assert(__atomic_load_n(&inst->thread_pool, __ATOMIC_ACQUIRE));
+}
+
+int main(void) {
+    printf("Testing CLAP thread pool...\n");
+
+    /* test_pool only fetches the extension in its first process() - the plugin runs its
+       own tasks until the main loop has started workers, then they go through the pool */
+    clap_instance_t a = {0};
+    assert(clap_load_plugin(FIXTURE, 0, &a) == 0);
+    assert(!a.thread_pool);
+    int16_t first = run(&a);  /* The loop may already have started workers mid-block */
+    assert(first == 8191 || first == 16383);
+    wait_for_pool(&a);
+    for (int i = 0; i < 20; i++) assert(run(&a) == 16383);
+    assert(clap_thread_pool_speedup(&a) > 0.0);
+
+    /* Loading other plugins in between doesn't lose a later query */
+    clap_instance_t synth = {0};
+    assert(clap_load_plugin("tests/fixtures/clap/test_synth.clap", 0, &synth) == 0);
+    assert(!synth.thread_pool);
+    clap_instance_t b = {0};
+    assert(clap_load_plugin(FIXTURE, 0, &b) == 0);
+    clap_unload_plugin(&synth);
+    wait_for_pool(&b);
+    assert(run(&b) == 16383);
+
+    /* Workers stay up for the remaining instance */
+    clap_unload_plugin(&a);
+    assert(run(&b) == 16383);
+    clap_unload_plugin(&b);
+
+    printf("All tests passed!\n");
+    return 0;
+}